@@ -0,0 +1,65 @@
+#include "ansi_renderer.hpp"
+#include <cstring>
+
+namespace BG {
+
+AnsiRenderer::AnsiRenderer(int top, int left) : _top(top), _left(left) {}
+
+void AnsiRenderer::put(int y, int x, const char* glyph, Ink ink){
+    if (y<0 || y>=kHeight || x<0 || x>=kWidth) return;
+    Cell& c = _next[y*kWidth + x];
+    std::memset(c.glyph, 0, sizeof c.glyph);
+    for (size_t i=0; i<sizeof c.glyph && glyph[i]; ++i) c.glyph[i] = glyph[i];
+    c.ink = uint8_t(ink);
+}
+
+// Mirrors the ncurses color pairs: default background outside the board,
+// unified black background inside it (white checkers drawn magenta there).
+void AnsiRenderer::appendSgr(std::string& out, uint8_t ink, bool interior){
+    const char* fg = "37";
+    switch (Ink(ink)){
+        case Ink::Plain:  fg = "37"; break;
+        case Ink::White:  fg = interior ? "35" : "37"; break;
+        case Ink::Black:  fg = "36"; break;
+        case Ink::Border: fg = "33"; break;
+        case Ink::Text:   fg = "32"; break;
+    }
+    out += "\x1b[0;";
+    out += fg;
+    if (interior) out += ";40";
+    out += 'm';
+}
+
+void AnsiRenderer::render(const Board::State& s, std::string& out){
+    paint(s);
+
+    int curY=-1, curX=-1;       // cursor position after last emitted glyph
+    int curInk=-1; bool curInt=false;
+    for (int y=0; y<kHeight; ++y){
+        for (int x=0; x<kWidth; ++x){
+            const int i = y*kWidth + x;
+            const Cell& c = _next[i];
+            if (_valid && c==_shown[i]) continue;
+
+            if (y!=curY || x!=curX){
+                out += "\x1b[";
+                out += std::to_string(_top + y);
+                out += ';';
+                out += std::to_string(_left + x);
+                out += 'H';
+            }
+            const bool interior = inInterior(y, x);
+            if (c.ink!=curInk || interior!=curInt){
+                appendSgr(out, c.ink, interior);
+                curInk = c.ink; curInt = interior;
+            }
+            out.append(c.glyph, strnlen(c.glyph, sizeof c.glyph));
+            _shown[i] = c;
+            curY = y; curX = x+1;
+        }
+    }
+    if (curInk>=0) out += "\x1b[0m";
+    _valid = true;
+}
+
+} // namespace BG
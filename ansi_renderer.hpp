@@ -0,0 +1,66 @@
+/**
+ * @file ansi_renderer.hpp
+ * @brief Headless ANSI renderer for BG::Board::State producing minimal diff streams.
+ *
+ * Shares the UTF-8 layout of NcursesRenderer (via BoardPainter) but keeps all
+ * state in two small in-memory frames, so many instances can live in one
+ * process without touching ncurses' global screen.
+ */
+#ifndef BG_ANSI_RENDERER_HPP
+#define BG_ANSI_RENDERER_HPP
+
+#include <string>
+#include <cstdint>
+#include "board.hpp"
+#include "board_layout.hpp"
+
+namespace BG {
+
+class AnsiRenderer : private BoardPainter {
+public:
+    static constexpr int kHeight = BoardPainter::kHeight;
+    static constexpr int kWidth  = BoardPainter::kWidth;
+
+    /**
+     * @param top  1-based terminal row of the board's top-left cell.
+     * @param left 1-based terminal column of the board's top-left cell.
+     */
+    explicit AnsiRenderer(int top=1, int left=1);
+
+    /**
+     * @brief Paint @p s and append the escape sequences that turn the previously
+     *        emitted frame into the new one.
+     * @param s   Board snapshot.
+     * @param out Receives cursor moves, SGR changes and glyphs (appended).
+     *
+     * Only changed cells are emitted; the first call (or the first after
+     * invalidate()) emits every cell. Attributes are reset at the end.
+     */
+    void render(const Board::State& s, std::string& out);
+
+    /// Forget what the terminal shows (e.g., after a clear); next render() repaints fully.
+    void invalidate() { _valid = false; }
+
+private:
+    /// One screen cell: UTF-8 glyph (≤3 bytes, NUL-padded) plus ink.
+    struct Cell {
+        char glyph[3];
+        uint8_t ink;
+        bool operator==(const Cell& o) const {
+            return ink==o.ink && glyph[0]==o.glyph[0] && glyph[1]==o.glyph[1] && glyph[2]==o.glyph[2];
+        }
+    };
+
+    int _top, _left;
+    bool _valid = false;
+    Cell _shown[kHeight*kWidth]{};  ///< what the terminal currently displays
+    Cell _next [kHeight*kWidth]{};  ///< frame being painted
+
+    void put(int y, int x, const char* glyph, Ink ink) override;
+
+    static void appendSgr(std::string& out, uint8_t ink, bool interior);
+};
+
+} // namespace BG
+
+#endif // BG_ANSI_RENDERER_HPP
@@ -0,0 +1,109 @@
+/**
+ * @file arena.cpp
+ * @brief Arena game and match play, Elo intervals and Bradley-Terry fitting.
+ */
+
+#include "arena.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace BG {
+
+ArenaGame playArenaGame(const ArenaPlayer players[2], RolloutDice &dice, unsigned &turn, unsigned maxTurns) {
+    ArenaGame g;
+    std::vector<ScoredPlay> plays;
+    Position p = Position::initial();
+    unsigned cube = 1;
+    int owner = -1;                     // -1 centred, else index into players
+    for (unsigned t=0; t<maxTurns; ++t) {
+        const int mover = int(t & 1);
+        const int sign = mover ? -1 : 1;
+        const ArenaPlayer &me = players[mover], &opp = players[1-mover];
+
+        if ((owner<0 || owner==mover) && me.cube && me.cube->offer(p, cube)) {
+            if (!opp.cube || opp.cube->take(p, cube)) {
+                cube *= 2; owner = 1-mover;
+            } else {
+                g.points = sign*int(cube); g.turns = t; g.finished = g.dropped = true;
+                return g;
+            }
+        }
+
+        int d1, d2;
+        dice.roll(turn++, d1, d2);   // only rolled turns advance the stream
+        me.search->hint(p, d1, d2, me.plies, 1, plays);
+        const Position &after = plays.front().cand.after;
+        if (after.finished(0)) {
+            g.points = sign*int(after.winMultiplier(0)*cube);
+            g.turns = t+1; g.finished = true;
+            return g;
+        }
+        p = after.swapped();
+    }
+    g.turns = maxTurns;
+    return g;
+}
+
+bool playArenaMatch(const ArenaPlayer players[2], unsigned length, RolloutDice &dice, unsigned maxTurns) {
+    unsigned score[2] = {0, 0}, turn = 0;
+    ArenaPlayer order[2] = { players[0], players[1] };
+    order[0].cube = order[1].cube = nullptr;
+    const ArenaPlayer swapped[2] = { order[1], order[0] };
+    for (unsigned game=0; score[0]<length && score[1]<length; ++game) {
+        bool firstOnRoll = game%2==0;
+        ArenaGame g = playArenaGame(firstOnRoll ? order : swapped, dice, turn, maxTurns);
+        if (!g.finished) break;
+        int pts = firstOnRoll ? g.points : -g.points;   // for players[0]
+        if (pts>0) score[0] += unsigned(pts);
+        else       score[1] += unsigned(-pts);
+    }
+    return score[0]>score[1];
+}
+
+EloEstimate eloFromPairs(const std::vector<double> &pairScores) {
+    EloEstimate e;
+    size_t n = pairScores.size();
+    if (n==0) return e;
+    double sum=0.0, sq=0.0;
+    for (double s : pairScores) { sum += s; sq += s*s; }
+    double mean = sum/double(n);
+    double var = n>1 ? std::max(0.0, (sq - sum*sum/double(n)) / double(n-1)) : 0.0;
+    double se = std::sqrt(var/double(n));
+
+    auto elo = [](double s){
+        s = std::clamp(s, 1e-4, 1.0-1e-4);
+        return -400.0*std::log10(1.0/s - 1.0);
+    };
+    e.score = mean;
+    e.elo = elo(mean);
+    e.lo = elo(mean - 1.96*se);
+    e.hi = elo(mean + 1.96*se);
+    return e;
+}
+
+std::vector<double> bradleyTerryElo(const std::vector<std::vector<double>> &wins) {
+    size_t n = wins.size();
+    std::vector<double> r(n, 1.0);
+    // Minorise-maximise updates; a small prior keeps undefeated players finite.
+    for (int it=0; it<1000; ++it) {
+        double change = 0.0;
+        for (size_t i=0; i<n; ++i) {
+            double w = 0.5, d = 0.0;
+            for (size_t j=0; j<n; ++j) {
+                if (i==j) continue;
+                double games = wins[i][j] + wins[j][i] + 1.0;
+                w += wins[i][j];
+                d += games / (r[i] + r[j]);
+            }
+            double nr = d>0.0 ? w/d : r[i];
+            change = std::max(change, std::fabs(std::log(nr/r[i])));
+            r[i] = nr;
+        }
+        if (change<1e-9) break;
+    }
+    std::vector<double> elo(n, 0.0);
+    for (size_t i=0; i<n; ++i) elo[i] = 400.0*std::log10(r[i]/r[0]);
+    return elo;
+}
+
+} // namespace BG
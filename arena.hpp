@@ -0,0 +1,84 @@
+/**
+ * @file arena.hpp
+ * @brief Engine-versus-engine games and matches with rating estimates.
+ */
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include "rollout.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @struct ArenaPlayer
+ * @brief One side of an arena game.
+ */
+struct ArenaPlayer {
+    const Search *search = nullptr;     ///< checker play via Search::hint() (book-aware)
+    unsigned plies = 0;
+    const CubePolicy *cube = nullptr;   ///< null never doubles and always takes
+};
+
+/**
+ * @struct ArenaGame
+ * @brief Result of one game, for the player who moved first.
+ */
+struct ArenaGame {
+    int points = 0;         ///< signed, multiplier times the final cube
+    unsigned turns = 0;
+    bool finished = false;  ///< false if abandoned at the turn limit (points 0)
+    bool dropped = false;   ///< ended by a dropped double
+};
+
+/**
+ * @brief Play one game from the starting position, @p players[0] on roll first.
+ *
+ * Dice are drawn from @p dice starting at turn @p turn, which is advanced
+ * once per roll (a dropped double uses no dice) so that a match can
+ * continue the same stream into its next game.
+ * Cube handling follows Rollout: the side on roll with cube access may
+ * double before rolling, and a drop ends the game at the current value.
+ */
+ArenaGame playArenaGame(const ArenaPlayer players[2], RolloutDice &dice, unsigned &turn,
+                        unsigned maxTurns = 5000);
+
+/**
+ * @brief Play a cubeless match to @p length points; true if @p players[0] wins it.
+ *
+ * The first game starts with players[0] on roll; later games alternate.
+ * Gammons and backgammons count double and triple. If a game is
+ * abandoned the match is decided on the score so far (players[0] wins
+ * only when ahead).
+ */
+bool playArenaMatch(const ArenaPlayer players[2], unsigned length, RolloutDice &dice, unsigned maxTurns = 5000);
+
+/**
+ * @struct EloEstimate
+ * @brief Score fraction and Elo difference with a 95% interval.
+ */
+struct EloEstimate {
+    double score = 0.5;
+    double elo = 0.0, lo = 0.0, hi = 0.0;
+};
+
+/**
+ * @brief Elo from per-pair scores in [0, 1] (one entry per mirrored pair).
+ *
+ * The interval uses the spread of the pair scores, so the correlation
+ * the mirrored dice introduce is accounted for, mapped to Elo by the delta
+ * method. Scores of exactly 0 or 1 are clamped to avoid infinite Elo.
+ */
+EloEstimate eloFromPairs(const std::vector<double> &pairScores);
+
+/**
+ * @brief Bradley-Terry ratings (Elo scale, player 0 at 0) from a win matrix.
+ * @param wins wins[i][j] = games (or matches) i won against j; half points allowed.
+ */
+std::vector<double> bradleyTerryElo(const std::vector<std::vector<double>> &wins);
+
+} // namespace BG
+
+#endif // ARENA_HPP
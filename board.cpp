@@ -1,61 +1,72 @@
 /**
  * @file board.cpp
- * @brief Board implementation: initialization, serialization, opening/turn control, legality, undo, commit, and cube.
+ * @brief Board implementation: initialization, serialization, opening/turn control, legality, undo, commit, engine make/unmake, and cube.
  */
 
 #include "board.hpp"
+#include "dice.hpp"
 #include <sstream>
 #include <algorithm>
 #include <random>
+#include <bit>
 
 namespace BG {
 
-// ===== Static initial layouts (point numbers) ================================
-const unsigned char Board::INIT_BLACK[15] = {
-    1,1, 12,12,12,12,12, 17,17,17, 19,19,19,19,19
-};
-const unsigned char Board::INIT_WHITE[15] = {
-    24,24, 13,13,13,13,13, 8,8,8, 6,6,6,6,6
-};
+// ===== Variants and starting layouts ========================================
+
+const char *variantName(Variant v) {
+    switch (v) {
+        case Variant::Standard:    return "standard";
+        case Variant::Nackgammon:  return "nackgammon";
+        case Variant::Hypergammon: return "hypergammon";
+    }
+    return "?";
+}
+
+bool parseVariant(const std::string &name, Variant &out) {
+    for (Variant v : {Variant::Standard, Variant::Nackgammon, Variant::Hypergammon})
+        if (name==variantName(v)) { out=v; return true; }
+    return false;
+}
+
+unsigned StartLayout::checkers() const {
+    unsigned n=0;
+    for (unsigned c : count) n += c;
+    return n;
+}
+
+StartLayout StartLayout::of(Variant v) {
+    StartLayout l;
+    switch (v) {
+        case Variant::Standard:
+            l.count[23]=2; l.count[12]=5; l.count[7]=3; l.count[5]=5;
+            break;
+        case Variant::Nackgammon:
+            l.count[23]=2; l.count[22]=2; l.count[12]=4; l.count[7]=3; l.count[5]=4;
+            break;
+        case Variant::Hypergammon:
+            l.count[23]=1; l.count[22]=1; l.count[21]=1;
+            break;
+    }
+    return l;
+}
 
 // ===== Construction / baseline snapshot =====================================
 
 Board::Board() {
-    rebuildPointsFromCheckerPositions();
+    placeLayout(StartLayout::of(Variant::Standard));
 }
 
-void Board::rebuildPointsFromCheckerPositions() {
-    // clear all stacks/counters
-    for (auto &pt : _points) pt.clear();
+void Board::placeLayout(const StartLayout &layout) {
+    for (auto &pt : _points) pt = State::Point{};
+    _occ[0]=_occ[1]=_made[0]=_made[1]=0;
     _whitebar=_blackbar=_whiteoff=_blackoff=0;
-
-    // Whites
-    for(unsigned i=0; i<15; i++) {
-        Checker* c(&_checkers[1][i]);
-        auto p(c->position);
-        if(p>=1 && p<=24) {
-            _points[p-1].insert(c);
-        }
-        else if(p==0){
-            ++_whitebar;
-        }
-        else{
-            ++_whiteoff;
-        }
-    }
-
-    // Blacks
-    for(unsigned i=0; i<15; i++) {
-        Checker* c(&_checkers[0][i]);
-        auto p(c->position);
-        if(p>=1 && p<=24) {
-            _points[p-1].insert(c);
-        }
-        else if(p==0){
-            ++_blackbar;
-        }
-        else{
-            ++_blackoff;
+    _nCheckers = layout.checkers();
+    for (int p=1; p<=24; p++) {
+        // WHITE's own point p is board point p; BLACK's is 25-p.
+        for (unsigned k=0; k<layout.count[p-1]; k++) {
+            pushToPoint(p, WHITE);
+            pushToPoint(25-p, BLACK);
         }
     }
 }
@@ -65,13 +76,11 @@ std::string Board::to_string() const
     std::ostringstream os;
     os <<"Board\n" "Point ";
     for (unsigned i=0; i<24; i++) {
-        const Checkers& checkers(_points[i]);
-        if (checkers.empty())
+        const State::Point& pt(_points[i]);
+        if (pt.count==0)
             continue;
         os << i+1;
-        auto c(*checkers.begin()); {
-            os << " " << (c->side==BLACK ? "B" : "W") << checkers.size() << " ";
-        }
+        os << " " << (pt.side==BLACK ? "B" : "W") << pt.count << " ";
         if (i==11)
             os << "\nPoint ";
     }
@@ -81,11 +90,7 @@ std::string Board::to_string() const
 
 void Board::getState(State &s) const
 {
-    for (unsigned i=0; i<24; i++) {
-        const Checkers &c(_points[i]);
-        s.points[i].count=c.size();
-        s.points[i].side = c.empty() ? NONE : (*c.begin())->side;
-    }
+    for (unsigned i=0; i<24; i++) s.points[i] = _points[i];
     s.whitebar=_whitebar;
     s.blackbar=_blackbar;
     s.whiteoff=_whiteoff;
@@ -93,14 +98,48 @@ void Board::getState(State &s) const
     s.cube=_cubeval;
 }
 
+void Board::setState(const State &s, Side toMove)
+{
+    if (toMove==NONE) throw std::invalid_argument("setState: no side to move");
+    for (auto &pt : _points) pt = State::Point{};
+    _occ[0]=_occ[1]=_made[0]=_made[1]=0;
+    unsigned total[2] = { s.whitebar + s.whiteoff, s.blackbar + s.blackoff };
+    for (int p=1; p<=24; p++) {
+        const State::Point &pt = s.points[p-1];
+        if (pt.side==NONE) continue;
+        for (unsigned k=0; k<pt.count; k++) pushToPoint(p, pt.side);
+        total[int(pt.side)] += pt.count;
+    }
+    _whitebar=s.whitebar; _blackbar=s.blackbar; _whiteoff=s.whiteoff; _blackoff=s.blackoff;
+    _nCheckers = std::max(total[0], total[1]);
+
+    _cubeval=s.cube; _cubeholder=NONE; _cubePendingFrom=NONE;
+    _phase=Phase::AwaitingRoll;
+    _actor=toMove;
+    _diceLeft.clear();
+    _lastErr.clear();
+    _steps.clear();
+    _result = GameResult{};
+}
+
+Board::State Board::State::mirrored() const
+{
+    State m;
+    for (unsigned i=0; i<24; i++) {
+        const Point &p = points[23-i];
+        m.points[i].count = p.count;
+        m.points[i].side = p.side==WHITE ? BLACK : p.side==BLACK ? WHITE : NONE;
+    }
+    m.whitebar=blackbar; m.blackbar=whitebar;
+    m.whiteoff=blackoff; m.blackoff=whiteoff;
+    m.cube=cube;
+    return m;
+}
+
 // ===== Lifecycle / phases ====================================================
 
 void Board::startGame(const Rules& rules) {
-    for (unsigned i=0;i<15;i++) {
-        _checkers[0][i].side=BLACK; _checkers[0][i].position=INIT_BLACK[i];
-        _checkers[1][i].side=WHITE; _checkers[1][i].position=INIT_WHITE[i];
-    }
-    rebuildPointsFromCheckerPositions();
+    placeLayout(StartLayout::of(rules.variant));
 
     _cubeval=1; _cubeholder=NONE; _cubePendingFrom=NONE;
     _rules=rules;
@@ -116,29 +155,37 @@ void Board::startGame(const Rules& rules) {
     _result = GameResult{}; // clear any previous game result
 }
 
+// One engine per thread, seeded once (random_device per roll is a syscall).
+static inline std::mt19937 &dice_rng(){
+    static thread_local std::mt19937 rng{std::random_device{}()};
+    return rng;
+}
+
 static inline int roll_die(std::mt19937 &rng){
-    static std::uniform_int_distribution<int> d(1,6);
+    std::uniform_int_distribution<int> d(1,6);
     return d(rng);
 }
 
-void Board::snapshotTurnStart(){
-    SimpleState s{};
+void Board::fillSimple(SimpleState &s) const {
+    s = SimpleState{};
     for(int p=1;p<=24;p++){
-        const Checkers& c=_points[p-1];
-        if(c.empty()) continue;
-        Side owner=(*c.begin())->side;
-        if(owner==WHITE) s.w[p]=c.size(); else s.b[p]=c.size();
+        const State::Point& pt=_points[p-1];
+        if(pt.count==0) continue;
+        if(pt.side==WHITE) s.w[p]=pt.count; else s.b[p]=pt.count;
     }
     s.wbar=_whitebar; s.bbar=_blackbar; s.woff=_whiteoff; s.boff=_blackoff;
-    _turnStart = s;
+    for (int i=0;i<2;i++){ s.occ[i]=_occ[i]; s.made[i]=_made[i]; }
+}
+
+void Board::snapshotTurnStart(){
+    fillSimple(_turnStart);
     _turnStartDice = _diceLeft;
     _turnStartActor = _actor;
 }
 
 std::pair<int,int> Board::rollOpening() {
     if (_phase!=Phase::OpeningRoll) throw std::logic_error("rollOpening: not in OpeningRoll phase");
-    std::random_device rd;
-    std::mt19937 rng(rd());
+    std::mt19937 &rng = dice_rng();
 
     while (true) {
         int w = roll_die(rng);
@@ -192,12 +239,10 @@ bool Board::needsRoll() const {
 std::pair<int,int> Board::rollDice() {
     if (_result.over){ throw std::logic_error("rollDice: game over"); }
     if (_phase!=Phase::AwaitingRoll) throw std::logic_error("rollDice: not in AwaitingRoll phase");
-    std::random_device rd;
-    std::mt19937 rng(rd());
+    std::mt19937 &rng = dice_rng();
     int d1 = roll_die(rng), d2 = roll_die(rng);
-    _diceLeft.clear();
-    if (d1==d2) _diceLeft = {d1,d1,d1,d1};
-    else        _diceLeft = {d1,d2};
+    const Roll &r = rollOf(d1, d2);
+    _diceLeft.assign(r.pips, r.pips + r.n);
     _phase = Phase::Moving;
     _lastErr.clear();
     _steps.clear();
@@ -209,9 +254,8 @@ void Board::setDice(int d1, int d2) {
     if (_result.over){ throw std::logic_error("setDice: game over"); }
     if (_phase!=Phase::AwaitingRoll) throw std::logic_error("setDice: not in AwaitingRoll phase");
     if (d1<1||d1>6||d2<1||d2>6) throw std::invalid_argument("setDice: dice out of range");
-    _diceLeft.clear();
-    if (d1==d2) _diceLeft = {d1,d1,d1,d1};
-    else        _diceLeft = {d1,d2};
+    const Roll &r = rollOf(d1, d2);
+    _diceLeft.assign(r.pips, r.pips + r.n);
     _phase = Phase::Moving;
     _lastErr.clear();
     _steps.clear();
@@ -220,87 +264,30 @@ void Board::setDice(int d1, int d2) {
 
 // ===== low-level board queries/mutations ====================================
 
-unsigned Board::pointCount(int p) const {
-    if (!inBoard(p)) return 0U;
-    return (unsigned)_points[p-1].size();
-}
-
-Side Board::pointSide(int p) const {
-    if (!inBoard(p)) return NONE;
-    const Checkers& c = _points[p-1];
-    if (c.empty()) return NONE;
-    return (*c.begin())->side;
-}
-
 unsigned Board::sidePointCount(Side s, int p) const {
     if (!inBoard(p)) return 0U;
-    const Checkers& c = _points[p-1];
-    if (c.empty()) return 0U;
-    return (*c.begin())->side==s ? (unsigned)c.size() : 0U;
-}
-
-Checker* Board::popFromPoint(int p){
-    Checkers& c = _points[p-1];
-    auto it = c.begin();
-    Checker* ck = *it;
-    c.erase(it);
-    return ck;
-}
-
-void Board::pushToPoint(int p, Checker* c){
-    c->position = (unsigned char)p;
-    _points[p-1].insert(c);
-}
-
-Checker* Board::popFromBar(Side s){
-    Checker* found = nullptr;
-    int idx = sideIndex(s);
-    if (idx<0) return nullptr;
-    for(int i=0;i<15;i++){
-        Checker* c = &_checkers[idx][i];
-        if (c->position==0){ found=c; break; }
-    }
-    if (!found) return nullptr;
-    if (s==WHITE) { if (_whitebar==0) return nullptr; --_whitebar; }
-    else          { if (_blackbar==0) return nullptr; --_blackbar; }
-    return found;
-}
-
-void Board::pushToBar(Side s, Checker* c){
-    c->position = 0;
-    if (s==WHITE) ++_whitebar; else ++_blackbar;
-}
-
-void Board::pushOff(Side s, Checker* c){
-    c->position = 25; // any >24
-    if (s==WHITE) ++_whiteoff; else ++_blackoff;
+    const State::Point& pt = _points[p-1];
+    return pt.side==s ? pt.count : 0U;
 }
 
 // ===== legality helpers ======================================================
 
 bool Board::allInHome(Side s) const {
-    if (s==WHITE) {
-        if (_whitebar>0) return false;
-        unsigned inHome=0;
-        for(int p=1;p<=6;p++){ inHome += sidePointCount(WHITE,p); }
-        return (inHome + _whiteoff)==15;
-    } else if (s==BLACK) {
-        if (_blackbar>0) return false;
-        unsigned inHome=0;
-        for(int p=19;p<=24;p++){ inHome += sidePointCount(BLACK,p); }
-        return (inHome + _blackoff)==15;
-    }
-    return false;
+    if (s==NONE || countBar(s)>0) return false;
+    return (_occ[int(s)] & ~kHomeMask[int(s)])==0;
 }
 
 bool Board::anyFurtherFromHome(Side s, int from) const {
-    if (s==WHITE){
-        for(int p=from+1;p<=24;p++) if (sidePointCount(WHITE,p)>0) return true;
-        return false;
-    } else {
-        for(int p=1;p<from;p++) if (sidePointCount(BLACK,p)>0) return true;
-        return false;
-    }
+    // WHITE: any point above from (highest = bit_width-1); BLACK: any point 1..from-1.
+    if (s==WHITE) return int(std::bit_width(_occ[0]))-1 > from;
+    return (_occ[1] & ((1u<<from)-2u))!=0;
+}
+
+unsigned Board::longestPrime(Side s) const {
+    uint32_t m = _made[int(s)];
+    unsigned n = 0;
+    for (; m; m &= m<<1) ++n;       // each pass trims one point off every run
+    return n;
 }
 
 // ===== apply/undo/commit =====================================================
@@ -329,9 +316,7 @@ bool Board::applyStep(int from, int pip) {
     bool borne=false, hit=false;
 
     if (inBoard(to)){
-        Side dstSide = pointSide(to);
-        unsigned dstCnt = pointCount(to);
-        if (dstSide!=NONE && dstSide!=_actor && dstCnt>=2){
+        if (_made[int(opponent(_actor))] & (1u<<to)){
             _lastErr="applyStep: destination blocked"; return false;
         }
     } else {
@@ -350,34 +335,28 @@ bool Board::applyStep(int from, int pip) {
 
     Step st{}; st.from=from; st.to=to; st.pip=pip; st.borneOff=borne; st.entered=(from==0);
 
-    Checker* mover=nullptr;
     if (from==0){
-        mover = popFromBar(_actor);
-        if (!mover){ _lastErr="applyStep: internal bar underflow"; return false; }
+        --barCount(_actor);
     } else {
-        mover = popFromPoint(from);
+        popFromPoint(from);
     }
 
-    Checker* hitCk=nullptr;
     if (!borne && inBoard(to)){
-        Side dstSide = pointSide(to);
-        unsigned dstCnt = pointCount(to);
-        if (dstSide!=NONE && dstSide!=_actor && dstCnt==1){
+        const Side opp = opponent(_actor);
+        if (_occ[int(opp)] & (1u<<to)){     // not made (checked above): a blot
             hit=true;
-            hitCk = popFromPoint(to);
-            pushToBar(dstSide, hitCk);
+            popFromPoint(to);
+            ++barCount(opp);
         }
     }
 
     if (borne){
-        pushOff(_actor, mover);
+        ++offCount(_actor);
     } else {
-        pushToPoint(to, mover);
+        pushToPoint(to, _actor);
     }
 
-    st.moved = mover;
     st.hit = hit;
-    st.hitChecker = hitCk;
     _steps.push_back(st);
 
     _diceLeft.erase(it);
@@ -394,22 +373,19 @@ bool Board::undoStep() {
     _steps.pop_back();
 
     if (st.borneOff){
-        if (_actor==WHITE){ if (_whiteoff>0) --_whiteoff; } else { if (_blackoff>0) --_blackoff; }
-        pushToPoint(st.from, st.moved);
+        --offCount(_actor);
+        pushToPoint(st.from, _actor);
     } else {
-        if (inBoard(st.to)){
-            Checkers& dst = _points[st.to-1];
-            auto it = dst.find(st.moved);
-            if (it!=dst.end()) dst.erase(it);
-        }
-        if (st.hit && st.hitChecker){
-            if (st.hitChecker->side==WHITE){ if (_whitebar>0) --_whitebar; } else { if (_blackbar>0) --_blackbar; }
-            pushToPoint(st.to, st.hitChecker);
+        popFromPoint(st.to);
+        if (st.hit){
+            Side opp = opponent(_actor);
+            --barCount(opp);
+            pushToPoint(st.to, opp);
         }
         if (st.entered){
-            pushToBar(_actor, st.moved);
+            ++barCount(_actor);
         } else {
-            pushToPoint(st.from, st.moved);
+            pushToPoint(st.from, _actor);
         }
     }
 
@@ -418,101 +394,102 @@ bool Board::undoStep() {
     return true;
 }
 
+// ===== engine make/unmake ====================================================
+
+void Board::makePlay(Side mover, const Play &play, PlayUndo &undo) {
+    const Side opp = opponent(mover);
+    undo.play = play;
+    undo.mover = mover;
+    undo.hits = 0;
+    for (unsigned k=0; k<play.n; ++k) {
+        const int from = play.steps[k].from;
+        const int to = destPoint(mover, from, play.steps[k].pip);
+        if (from==0) --barCount(mover); else popFromPoint(from);
+        if (!inBoard(to)) { ++offCount(mover); continue; }
+        if (_occ[int(opp)] & (1u<<to)) {    // a legal play only lands on a blot
+            popFromPoint(to);
+            ++barCount(opp);
+            undo.hits |= (unsigned char)(1u << k);
+        }
+        pushToPoint(to, mover);
+    }
+}
+
+void Board::unmakePlay(const PlayUndo &undo) {
+    const Side mover = undo.mover, opp = opponent(mover);
+    for (unsigned k=undo.play.n; k-- > 0; ) {
+        const int from = undo.play.steps[k].from;
+        const int to = destPoint(mover, from, undo.play.steps[k].pip);
+        if (!inBoard(to)) {
+            --offCount(mover);
+        } else {
+            popFromPoint(to);
+            if (undo.hits & (1u << k)) { --barCount(opp); pushToPoint(to, opp); }
+        }
+        if (from==0) ++barCount(mover); else pushToPoint(from, mover);
+    }
+}
+
+
+void Board::simpleAdd(SimpleState& s, Side side, int p){
+    const int i = int(side);
+    unsigned &c = (side==WHITE ? s.w : s.b)[p];
+    if (++c==1) s.occ[i] |= 1u<<p; else s.made[i] |= 1u<<p;
+}
+
+void Board::simpleRemove(SimpleState& s, Side side, int p){
+    const int i = int(side);
+    unsigned &c = (side==WHITE ? s.w : s.b)[p];
+    if (--c==1) s.made[i] &= ~(1u<<p);
+    else if (c==0) s.occ[i] &= ~(1u<<p);
+}
 
 unsigned Board::dfsMax(const SimpleState& st, Side actor,
                        const std::vector<int>& dice, size_t usedMask){
+    const int me = int(actor), op = 1-me;
+    const Side opp = opponent(actor);
+    const unsigned bar = actor==WHITE ? st.wbar : st.bbar;
+    // Bearing off needs nothing on the bar or outside home (independent of the checker count).
+    const bool allHome = bar==0 && (st.occ[me] & ~kHomeMask[me])==0;
+
     unsigned best = 0;
     for (size_t i = 0; i < dice.size(); ++i) {
         if (usedMask & (1ULL << i)) continue;
         int pip = dice[i];
 
-        // If bar has checkers, only from==0 is allowed.
-        bool barFirst = (actor==WHITE ? st.wbar>0 : st.bbar>0);
-        std::vector<int> froms;
-        if (barFirst) {
-            froms.push_back(0);
-        } else {
-            if (actor==WHITE) { for (int p=1;p<=24;p++) if (st.w[p]>0) froms.push_back(p); }
-            else              { for (int p=1;p<=24;p++) if (st.b[p]>0) froms.push_back(p); }
-        }
+        // If bar has checkers, only from==0 is allowed (bit 0 stands for the bar).
+        for (uint32_t froms = bar>0 ? 1u : st.occ[me]; froms; froms &= froms-1) {
+            const int from = std::countr_zero(froms);
+            const int to = destPoint(actor, from, pip);
 
-        auto ownerAt = [&](int p)->Side{
-            if (p<1||p>24) return NONE;
-            if (st.w[p]>0) return WHITE;
-            if (st.b[p]>0) return BLACK;
-            return NONE;
-        };
-        auto countAt = [&](int p)->unsigned{
-            if (p<1||p>24) return 0U;
-            Side own = ownerAt(p);
-            if (own==WHITE) return st.w[p];
-            if (own==BLACK) return st.b[p];
-            return 0U;
-        };
-        auto anyFurther = [&](int from)->bool{
-            if (actor==WHITE){ for(int p=from+1;p<=24;p++) if (st.w[p]>0) return true; return false; }
-            else             { for(int p=1;p<from;p++)    if (st.b[p]>0) return true; return false; }
-        };
-        auto dec = [&](unsigned &v){ if (v>0) --v; };
-
-        for (int from : froms) {
-            int to = (actor==WHITE ? (from==0 ? 25-pip : from-pip)
-                                     : (from==0 ? pip : from+pip));
-
-            bool allow=false, hit=false;
-
-            if (to>=1 && to<=24) {
-                Side dstSide = ownerAt(to);
-                unsigned dstCnt = countAt(to);
-                if (dstSide!=NONE && dstSide!=actor && dstCnt>=2) {
-                    allow=false; // blocked
-                } else {
-                    allow=true;
-                    hit = (dstSide!=NONE && dstSide!=actor && dstCnt==1);
-                }
+            bool hit=false;
+            if (inBoard(to)) {
+                if (st.made[op] & (1u<<to)) continue;   // blocked
+                hit = (st.occ[op] & (1u<<to))!=0;
             } else {
-                // Bearing off
-                bool allHome=false;
-                if (actor==WHITE) {
-                    if (st.wbar==0) {
-                        unsigned inHome=0; for(int p=1;p<=6;p++) inHome+=st.w[p];
-                        allHome = (inHome+st.woff)==15;
-                    }
-                } else {
-                    if (st.bbar==0) {
-                        unsigned inHome=0; for(int p=19;p<=24;p++) inHome+=st.b[p];
-                        allHome = (inHome+st.boff)==15;
-                    }
-                }
-                if (!allHome) {
-                    allow=false;
-                } else {
-                    if (actor==WHITE)  allow = (from==pip)     || !anyFurther(from);
-                    else               allow = (from==(25-pip))|| !anyFurther(from);
-                }
+                // Bearing off: exact roll, or nothing further from home than from.
+                if (!allHome) continue;
+                bool exact = actor==WHITE ? from==pip : from==25-pip;
+                bool further = actor==WHITE ? int(std::bit_width(st.occ[me]))-1 > from
+                                            : (st.occ[me] & ((1u<<from)-2u))!=0;
+                if (!exact && further) continue;
             }
 
-            if (!allow) continue;
-
             // Apply simple move to a copy
             SimpleState s = st;
-            if (from==0) {
-                if (actor==WHITE) dec(s.wbar); else dec(s.bbar);
+            if (from==0) --(actor==WHITE ? s.wbar : s.bbar);
+            else         simpleRemove(s, actor, from);
+            if (inBoard(to)) {
+                if (hit) { simpleRemove(s, opp, to); ++(actor==WHITE ? s.bbar : s.wbar); }
+                simpleAdd(s, actor, to);
             } else {
-                if (actor==WHITE) dec(s.w[from]); else dec(s.b[from]);
-            }
-            if (to>=1 && to<=24) {
-                if (hit) {
-                    if (actor==WHITE) { dec(s.b[to]); ++s.bbar; }
-                    else              { dec(s.w[to]); ++s.wbar; }
-                }
-                if (actor==WHITE) ++s.w[to]; else ++s.b[to];
-            } else {
-                if (actor==WHITE) ++s.woff; else ++s.boff;
+                ++(actor==WHITE ? s.woff : s.boff);
             }
 
             unsigned cand = 1 + dfsMax(s, actor, dice, usedMask | (1ULL<<i));
             if (cand>best) best=cand;
+            // Every remaining die is usable along this line: nothing can beat it.
+            if (best + std::popcount(usedMask) == dice.size()) return best;
         }
     }
     return best;
@@ -543,8 +520,9 @@ bool Board::commitTurn() {
         _lastErr="commitTurn: must use maximum number of dice"; return false;
     }
     if (maxUse==1 && _turnStartDice.size()==2 && _turnStartDice[0]!=_turnStartDice[1]){
+        // Either die but not both: the higher one is obligatory only if it can be played.
         int hi = std::max(_turnStartDice[0], _turnStartDice[1]);
-        if (_steps[0].pip != hi){
+        if (_steps[0].pip != hi && maxPlayableDice(_turnStart, _turnStartActor, {hi})>0){
             _lastErr="commitTurn: only one die playable; must use the higher die"; return false;
         }
     }
@@ -558,32 +536,28 @@ bool Board::commitTurn() {
 }
 
 bool BG::Board::hasAnyLegalStep() const {
-    if (_result.over) return false;
-    if (_phase != Phase::Moving) return false;
-    if (_diceLeft.empty()) return false;
+    return maxPlayableDice() > 0;
+}
+
+unsigned BG::Board::maxPlayableDice() const {
+    if (_result.over) return 0;
+    if (_phase != Phase::Moving) return 0;
+    if (_diceLeft.empty()) return 0;
 
     // Build a SimpleState snapshot of the current live board
-    SimpleState s{};
-    for (int p = 1; p <= 24; ++p) {
-        const Checkers& c = _points[p-1];
-        if (c.empty()) continue;
-        Side owner = (*c.begin())->side;
-        if (owner == WHITE) s.w[p] = (unsigned)c.size();
-        else                s.b[p] = (unsigned)c.size();
-    }
-    s.wbar = _whitebar; s.bbar = _blackbar; s.woff = _whiteoff; s.boff = _blackoff;
+    SimpleState s;
+    fillSimple(s);
 
     // Use the same search that commitTurn() relies on
-    return maxPlayableDice(s, _actor, _diceLeft) > 0;
+    return maxPlayableDice(s, _actor, _diceLeft);
 }
 
 // ===== Convenience counts ====================================================
 
 unsigned Board::countAt(Side s, int point) const {
     if (point<1 || point>24) return 0;
-    const Checkers &c(_points[point-1]);
-    if (c.empty()) return 0;
-    return (*c.begin())->side==s ? (unsigned)c.size() : 0U;
+    const State::Point &pt(_points[point-1]);
+    return pt.side==s ? pt.count : 0U;
 }
 
 unsigned Board::countBar(Side s) const {
@@ -6,7 +6,7 @@
 #ifndef BOARD_HPP
 #define BOARD_HPP
 
-#include <set>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <utility>
@@ -29,32 +29,68 @@ enum class Side {WHITE=0, BLACK=1, NONE};
 const Side WHITE(Side::WHITE), BLACK(Side::BLACK), NONE(Side::NONE);
 
 /**
- * @struct Checker
- * @brief A single checker with side and current location.
+ * @struct Play
+ * @brief One turn's checker movement: up to four per-die steps in the order played.
  *
- * @var Checker::side
- *   Owner of the checker.
- * @var Checker::position
- *   Location encoding:
- *   - 1..24 : board points
- *   - 0     : on the bar
- *   - >24   : borne off (off the board)
+ * Steps use the Board::applyStep() encoding: @c from is a point 1..24
+ * (0 = enter from the bar) and @c pip is the die consumed.
+ * An empty play (n==0) means no legal move existed.
  */
-struct Checker {
-    Side side;
-    unsigned char position;
+struct Play {
+    struct Step { unsigned char from=0, pip=0; };
+    Step steps[4];
+    unsigned char n=0; ///< number of valid entries in steps[]
+
+    void push(int from, int pip){ steps[n].from=(unsigned char)from; steps[n].pip=(unsigned char)pip; ++n; }
 };
 
 /**
- * @typedef Checkers
- * @brief A set of pointers to checkers stacked on a point.
+ * @struct PlayUndo
+ * @brief What Board::unmakePlay() needs to reverse one Board::makePlay().
  */
-typedef std::set<Checker*> Checkers;
+struct PlayUndo {
+    Play play;
+    Side mover=NONE;
+    unsigned char hits=0;   ///< bit k set if step k hit a blot
+};
+
+/**
+ * @enum Variant
+ * @brief Starting layout, and with it the number of checkers per side.
+ *
+ * Values (points counted from each side's own home):
+ * - Standard   : 15 checkers, 2-5-3-5 on the 24, 13, 8 and 6 points
+ * - Nackgammon : 15 checkers, 2-2-4-3-4 on the 24, 23, 13, 8 and 6 points
+ * - Hypergammon: 3 checkers, one each on the 24, 23 and 22 points
+ */
+enum class Variant { Standard, Nackgammon, Hypergammon };
+
+/// Lower-case name of @p v ("standard", "nackgammon", "hypergammon").
+const char *variantName(Variant v);
+
+/// Inverse of variantName(); false if @p name is not a variant.
+bool parseVariant(const std::string &name, Variant &out);
+
+/**
+ * @struct StartLayout
+ * @brief Starting checkers of one side by its own point number; the other side mirrors it.
+ */
+struct StartLayout {
+    unsigned char count[24]{};  ///< count[i] = checkers on own point i+1
+
+    /// Checkers per side.
+    unsigned checkers() const;
+
+    static StartLayout of(Variant v);
+};
 
 /**
  * @brief Game rule options that affect flow (esp. the opening).
  */
 struct Rules {
+    /// Starting layout (default: standard backgammon).
+    Variant variant = Variant::Standard;
+
     /**
      * @brief Policy when the *opening* roll is doubles.
      */
@@ -102,6 +138,14 @@ public:
 
         /// Checkers on bars and borne off, by side.
         unsigned whitebar=0, blackbar=0, whiteoff=0, blackoff=0;
+
+        /**
+         * @brief Colour-reversed twin: sides swapped and point p renumbered 25-p.
+         *
+         * A position with WHITE to move plays exactly like its mirror with
+         * BLACK to move. The cube value is kept.
+         */
+        State mirrored() const;
     };
 
     /**
@@ -120,6 +164,16 @@ public:
      */
     void getState(State &s) const;
 
+    /**
+     * @brief Set up an arbitrary position with @p toMove to roll next.
+     * @throws std::invalid_argument if @p toMove is NONE.
+     *
+     * Takes the points, bars, off counts and cube value from @p s (cube
+     * centred); the checker count is the larger side's total. The phase
+     * becomes AwaitingRoll with no game result, as after a committed turn.
+     */
+    void setState(const State &s, Side toMove);
+
     /**
      * @brief Human-readable summary (occupied points only).
      */
@@ -129,7 +183,7 @@ public:
 
     /**
      * @brief Reset to the initial position, center cube, clear turn state and result.
-     * @param rules Rule options (opening doubles behavior, caps).
+     * @param rules Rule options (variant, opening doubles behavior, caps).
      *
      * After this call, phase()==OpeningRoll. No dice are set yet.
      */
@@ -147,6 +201,9 @@ public:
     /// Final result descriptor (valid when gameOver()==true).
     GameResult result() const { return _result; }
 
+    /// Checkers per side in the current variant (15 until startGame() says otherwise).
+    unsigned checkers() const { return _nCheckers; }
+
     // ===== Opening ============================================================
 
     /**
@@ -217,6 +274,14 @@ public:
     /// True if any legal step exists with the current dice and board.
     bool hasAnyLegalStep() const;
 
+    /**
+     * @brief Most of the remaining dice that can be played from the current board.
+     *
+     * This is the count commitTurn() insists on (from the turn's start); 0
+     * outside the Moving phase or once the game is over.
+     */
+    unsigned maxPlayableDice() const;
+
     /// Return a machine-friendly explanation of the last rule failure.
     std::string lastError() const { return _lastErr; }
 
@@ -226,6 +291,21 @@ public:
     unsigned countBar(Side s) const;
     unsigned countOff(Side s) const;
 
+    // ===== Occupancy masks ====================================================
+    // Bit p stands for board point p (1..24); bits 0 and 25..31 are always clear.
+
+    /// Points holding at least one checker of @p s.
+    uint32_t pointMask(Side s) const { return _occ[int(s)]; }
+
+    /// Points @p s has made (two or more checkers).
+    uint32_t madeMask(Side s) const { return _made[int(s)]; }
+
+    /// Points holding exactly one checker of @p s.
+    uint32_t blotMask(Side s) const { return _occ[int(s)] & ~_made[int(s)]; }
+
+    /// Longest run of consecutive made points of @p s (6 or more is a full prime).
+    unsigned longestPrime(Side s) const;
+
     // ===== Doubling cube ======================================================
 
     /// Current cube value (1,2,4,...).
@@ -265,29 +345,27 @@ public:
      */
     bool dropCube();
 
-private:
-    // ===== Static initial layout helpers =====================================
-    static const unsigned char INIT_BLACK[15];
-    static const unsigned char INIT_WHITE[15];
+    // ===== Engine make/unmake ================================================
 
-    // ===== Core board containers =============================================
-    Checker _checkers[2][15] =
-        {
-        {
-         {BLACK, 1}, {BLACK, 1},
-         {BLACK, 12}, {BLACK, 12}, {BLACK, 12}, {BLACK, 12}, {BLACK, 12},
-         {BLACK, 17}, {BLACK, 17}, {BLACK, 17},
-         {BLACK, 19}, {BLACK, 19}, {BLACK, 19}, {BLACK, 19}, {BLACK, 19}
-        },
-        {
-         {WHITE, 24}, {WHITE, 24},
-         {WHITE, 13}, {WHITE, 13}, {WHITE, 13}, {WHITE, 13}, {WHITE, 13},
-         {WHITE, 8}, {WHITE, 8}, {WHITE, 8},
-         {WHITE, 6}, {WHITE, 6}, {WHITE, 6}, {WHITE, 6}, {WHITE, 6}
-        }
-};
+    /**
+     * @brief Apply @p play for @p mover with no rule checks.
+     * @param[out] undo Filled with everything unmakePlay() needs.
+     *
+     * For search and rollouts, where the play comes from the move generator
+     * and is known to be legal. Phase, dice, the turn's step list and
+     * lastError() are left alone, so a make/unmake pair is a handful of
+     * counter updates. Illegal plays corrupt the board.
+     */
+    void makePlay(Side mover, const Play &play, PlayUndo &undo);
 
-    Checkers _points[24];
+    /// Reverse the makePlay() that filled @p undo; pairs must nest (last made, first unmade).
+    void unmakePlay(const PlayUndo &undo);
+
+private:
+    // ===== Core board containers =============================================
+    unsigned _nCheckers = 15;          ///< per side, from the variant's layout
+    State::Point _points[24];          ///< owner and count per board point (index = point-1)
+    uint32_t _occ[2]{}, _made[2]{};    ///< occupancy masks by int(Side), kept in step with _points
 
     unsigned _whitebar=0, _blackbar=0,_whiteoff=0, _blackoff=0;
 
@@ -310,8 +388,6 @@ private:
     struct Step {
         int from=0, to=0, pip=0;
         bool hit=false, entered=false, borneOff=false;
-        Checker* moved=nullptr;
-        Checker* hitChecker=nullptr;
     };
     std::vector<Step> _steps;          ///< applied steps this turn
 
@@ -319,13 +395,14 @@ private:
     struct SimpleState {
         unsigned w[25]{}, b[25]{}; // 1..24 used
         unsigned wbar=0, bbar=0, woff=0, boff=0;
+        uint32_t occ[2]{}, made[2]{};  // masks by int(Side), as in Board
     };
     SimpleState _turnStart{};
     std::vector<int> _turnStartDice{};
     Side _turnStartActor = NONE;
 
     // ===== Internal helpers ===================================================
-    void rebuildPointsFromCheckerPositions();
+    void placeLayout(const StartLayout &layout);     // both sides, bars and off cleared
     static Side opponent(Side s) { return s==WHITE?BLACK : s==BLACK?WHITE : NONE; }
     static int sideIndex(Side s){ return s==WHITE?1 : s==BLACK?0 : -1; }
 
@@ -336,26 +413,38 @@ private:
     }
     static inline bool inBoard(int p){ return p>=1 && p<=24; }
     static inline bool isHome(Side s, int p){ return s==WHITE ? (p>=1 && p<=6) : (p>=19 && p<=24); }
+    static constexpr uint32_t kHomeMask[2] = { 0x7Eu, 0x3Fu << 19 };   // points 1..6 / 19..24
+    static constexpr uint32_t kBoardMask = 0x1FFFFFEu;                  // points 1..24
 
     // board queries
-    unsigned pointCount(int p) const;                 // total checkers on point
-    Side     pointSide(int p) const;                  // NONE if empty else owner
     unsigned sidePointCount(Side s, int p) const;     // count for s on p (0 or size)
 
     // mutations
-    Checker* popFromPoint(int p);                     // remove one checker from p
-    void     pushToPoint(int p, Checker* c);          // add checker to p
-    Checker* popFromBar(Side s);                      // remove from bar
-    void     pushToBar(Side s, Checker* c);           // add to bar
-    void     pushOff(Side s, Checker* c);             // bear off
+    void popFromPoint(int p){                         // remove one checker from p
+        State::Point &pt = _points[p-1];
+        const int s = int(pt.side);
+        if (--pt.count==1) _made[s] &= ~(1u<<p);
+        else if (pt.count==0) { _occ[s] &= ~(1u<<p); pt.side=NONE; }
+    }
+    void pushToPoint(int p, Side s){                  // add one of s's checkers to p
+        State::Point &pt = _points[p-1];
+        pt.side=s;
+        if (++pt.count==1) _occ[int(s)] |= 1u<<p;
+        else               _made[int(s)] |= 1u<<p;
+    }
+    unsigned& barCount(Side s){ return s==WHITE ? _whitebar : _blackbar; }
+    unsigned& offCount(Side s){ return s==WHITE ? _whiteoff : _blackoff; }
 
     void snapshotTurnStart();                         // fill _turnStart/actor/dice
+    void fillSimple(SimpleState &s) const;            // current board as a SimpleState
 
     // validation helpers for bearing off
     bool allInHome(Side s) const;
     bool anyFurtherFromHome(Side s, int from) const;
 
     // commit-time search
+    static void simpleAdd(SimpleState& s, Side side, int p);
+    static void simpleRemove(SimpleState& s, Side side, int p);
     static unsigned dfsMax(const SimpleState& st, Side actor, const std::vector<int>& dice, size_t usedMask);
     static unsigned maxPlayableDice(const SimpleState& st, Side actor, const std::vector<int>& dice);
 };
@@ -0,0 +1,145 @@
+#include "board_layout.hpp"
+
+namespace BG {
+
+void BoardPainter::putch(int y, int x, char ch, Ink ink){
+    char buf[2] = { ch, 0 };
+    put(y, x, buf, ink);
+}
+
+void BoardPainter::drawChrome(){
+    // Derived columns for the right gutter
+    const int X_LEFT   = 0;
+    const int X_INNER  = kWidth - 3; // T column (left edge of bear-off gutter)
+    const int X_OFF    = kWidth - 2; // off-lane column (between inner and outer)
+    const int X_RIGHT  = kWidth - 1; // new outer right border
+
+    // Clear our rect; sinks give interior cells the unified board background
+    for (int y=0; y<kHeight; ++y){
+        for (int x=0; x<kWidth; ++x){
+            put(y, x, " ", Ink::Plain);
+        }
+    }
+
+    // ---- Numbers (aligned to point columns) ----
+    // Top: points 13..24
+    for (int p=13; p<=24; ++p){
+        int x = PO[p-1].x;
+        int tens = p / 10, ones = p % 10;
+        if (tens) putch(0, x, char('0'+tens), Ink::Text);
+        putch(1, x, char('0'+ones), Ink::Text);
+    }
+    // Bottom: points 12..1
+    for (int p=12; p>=1; --p){
+        int x = PO[p-1].x;
+        if (p >= 10) putch(15, x, '1', Ink::Text);
+        putch(16, x, char('0'+(p%10)), Ink::Text);
+    }
+
+    // ---- Outer border (top/bottom) with right gutter ----
+    put( 2, X_LEFT,  "┌", Ink::Border);
+    put(14, X_LEFT,  "└", Ink::Border);
+
+    // Main-board horizontal runs up to (but not including) the inner T column
+    for (int x=X_LEFT+1; x<X_INNER; ++x){
+        put( 2, x, "─", Ink::Border);
+        put(14, x, "─", Ink::Border);
+    }
+
+    // T-junctions at the inner gutter edge
+    put( 2, X_INNER, "┬", Ink::Border);
+    put(14, X_INNER, "┴", Ink::Border);
+
+    // One extra segment into the gutter
+    put( 2, X_OFF, "─", Ink::Border);
+    put(14, X_OFF, "─", Ink::Border);
+
+    // New outer right corners
+    put( 2, X_RIGHT, "┐", Ink::Border);
+    put(14, X_RIGHT, "┘", Ink::Border);
+
+    // Verticals: left border, inner gutter line, outer border
+    for (int y=3; y<=13; ++y){
+        put(y, X_LEFT,  "│", Ink::Border);
+        put(y, X_INNER, "│", Ink::Border);
+        put(y, X_RIGHT, "│", Ink::Border);
+    }
+
+    // Center thick separator (home line): span full width to the right border
+    for (int x = X_LEFT+1; x < X_INNER; ++x) put(8, x, "═", Ink::Border);
+    put(8, X_LEFT,  "╞", Ink::Border);   // left border join
+    put(8, X_INNER, "╪", Ink::Border);   // inner gutter join
+
+    for (int x = X_INNER+1; x < X_RIGHT; ++x) put(8, x, "═", Ink::Border);
+    put(8, X_RIGHT, "╡", Ink::Border);   // right border join
+
+    // ---- Center bar rails (already shifted left by 1) ----
+    for (int y=3; y<=13; ++y){
+        put(y, 12, "│", Ink::Border);
+        put(y, 14, "│", Ink::Border);
+    }
+    // Intersections with top/bottom borders
+    put( 2, 12, "┬", Ink::Border);
+    put( 2, 14, "┬", Ink::Border);
+    put(14, 12, "┴", Ink::Border);
+    put(14, 14, "┴", Ink::Border);
+    // Intersections with center thick line: use vertical single + horizontal double
+    put(8, 12, "╪", Ink::Border);
+    put(8, 14, "╪", Ink::Border);
+}
+
+void BoardPainter::drawStack(Side side, unsigned cnt, const Origin& o){
+    const char* glyph = (side==BLACK ? BCHK : (side==WHITE ? WCHK : EMPTY));
+    const Ink ink = (side==WHITE ? Ink::White : Ink::Black);
+    int y=o.y, x=o.x;
+    auto step = [&](){ if (o.dir==Dir::UP) --y; else ++y; };
+    auto putg = [&](){ put(y, x, glyph, ink); step(); };
+    auto pute = [&](){ put(y, x, EMPTY, Ink::Plain); step(); };
+
+    if (cnt<=5){
+        for (unsigned i=0;i<5;++i) (i<cnt? putg() : pute());
+        return;
+    }
+    if (cnt<10){
+        for (unsigned i=0;i<4;++i) putg();
+        putch(y, x, char('0'+cnt), ink);
+        return;
+    }
+    // 10..15 → 3 glyphs + two digits
+    for (unsigned i=0;i<3;++i) putg();
+    char tens = char('0' + (cnt/10));
+    char ones = char('0' + (cnt%10));
+    if (o.dir==Dir::UP){
+        putch(y, x, ones, ink); step();
+        putch(y, x, tens, ink);
+    } else {
+        putch(y, x, tens, ink); step();
+        putch(y, x, ones, ink);
+    }
+}
+
+void BoardPainter::paint(const Board::State& s){
+    drawChrome();
+
+    // Points 1..24
+    for (int i=0;i<24;++i){
+        const auto &pt = s.points[i];
+        drawStack(pt.side, pt.count, PO[i]);
+    }
+
+    // Bars / off ladders
+    // If any off-ladder origin lands on the right border after the shift,
+    // nudge it left by 1 so we don't overwrite the border column.
+    Origin wo = WHITEOFF;
+    Origin bo = BLACKOFF;
+    const int right_border_x = kWidth - 1; // outer right border
+    if (wo.x >= right_border_x) wo.x = right_border_x - 1;
+    if (bo.x >= right_border_x) bo.x = right_border_x - 1;
+
+    drawStack(WHITE, s.whitebar, WHITEBAR);
+    drawStack(BLACK, s.blackbar, BLACKBAR);
+    drawStack(WHITE, s.whiteoff, wo);
+    drawStack(BLACK, s.blackoff, bo);
+}
+
+} // namespace BG
@@ -0,0 +1,88 @@
+/**
+ * @file board_layout.hpp
+ * @brief Terminal-independent UTF-8 board layout: chrome, point stacks, bars and off ladders.
+ *
+ * The painter knows *where* every glyph goes; subclasses decide *how* a cell is
+ * emitted (ncurses window, in-memory ANSI frame, ...).
+ */
+#ifndef BG_BOARD_LAYOUT_HPP
+#define BG_BOARD_LAYOUT_HPP
+
+#include "board.hpp"
+
+namespace BG {
+
+class BoardPainter {
+public:
+    // Make the frame symmetric: 29 cols total, right border at x=28.
+    static constexpr int kHeight = 17; // rows: 0..16
+    static constexpr int kWidth  = 29; // cols: 0..28
+
+    /// Semantic ink of a cell; values double as the ncurses color-pair ids.
+    enum class Ink : short { Plain = 0, White = 1, Black = 2, Border = 3, Text = 4 };
+
+    virtual ~BoardPainter() = default;
+
+    /// Board interior: rows 3..13, cols 1..(kWidth-3)-1 (left edge to T column exclusive)
+    static bool inInterior(int y, int x) {
+        return (y >= 3 && y <= 13 && x >= 1 && x < (kWidth - 3));
+    }
+
+protected:
+    /// Emit one cell. @p glyph is a NUL-terminated UTF-8 sequence of display width 1.
+    virtual void put(int y, int x, const char* glyph, Ink ink) = 0;
+
+    /// Draw the frame and every stack of @p s.
+    void paint(const Board::State& s);
+
+private:
+    enum class Dir { UP, DOWN };
+    struct Origin { Dir dir; int x, y; };
+
+    // UTF-8 glyphs (plain narrow strings)
+    static constexpr const char* WCHK = "●"; // white checker
+    static constexpr const char* BCHK = "●"; // black checker
+    static constexpr const char* EMPTY= " "; // eraser
+
+    // Point origins (match the ASCII renderer)
+    static constexpr Origin PO[24] = {
+        /*  1 */ {Dir::UP,   25, 13},
+        /*  2 */ {Dir::UP,   23, 13},
+        /*  3 */ {Dir::UP,   21, 13},
+        /*  4 */ {Dir::UP,   19, 13},
+        /*  5 */ {Dir::UP,   17, 13},
+        /*  6 */ {Dir::UP,   15, 13},
+        /*  7 */ {Dir::UP,   11, 13},
+        /*  8 */ {Dir::UP,    9, 13},
+        /*  9 */ {Dir::UP,    7, 13},
+        /* 10 */ {Dir::UP,    5, 13},
+        /* 11 */ {Dir::UP,    3, 13},
+        /* 12 */ {Dir::UP,    1, 13},
+        /* 13 */ {Dir::DOWN,  1,  3},
+        /* 14 */ {Dir::DOWN,  3,  3},
+        /* 15 */ {Dir::DOWN,  5,  3},
+        /* 16 */ {Dir::DOWN,  7,  3},
+        /* 17 */ {Dir::DOWN,  9,  3},
+        /* 18 */ {Dir::DOWN, 11,  3},
+        /* 19 */ {Dir::DOWN, 15,  3},
+        /* 20 */ {Dir::DOWN, 17,  3},
+        /* 21 */ {Dir::DOWN, 19,  3},
+        /* 22 */ {Dir::DOWN, 21,  3},
+        /* 23 */ {Dir::DOWN, 23,  3},
+        /* 24 */ {Dir::DOWN, 25,  3},
+    };
+
+    // Bars / off ladders — centered bar at x=14; off ladders moved to x=27
+    static constexpr Origin WHITEBAR = {Dir::UP,   13,  7}; // rows 7..3  (upper gutter, drawn up)
+    static constexpr Origin BLACKBAR = {Dir::DOWN, 13,  9}; // rows 9..13 (lower gutter, drawn down)
+    static constexpr Origin BLACKOFF = {Dir::DOWN, 27,  3}; // rows 3..7   (upper off, x=27)
+    static constexpr Origin WHITEOFF = {Dir::UP,   27, 13}; // rows 13..9  (lower off, x=27)
+
+    void putch(int y, int x, char ch, Ink ink);
+    void drawChrome(); // borders, separators, numbers
+    void drawStack(Side side, unsigned cnt, const Origin& o);
+};
+
+} // namespace BG
+
+#endif // BG_BOARD_LAYOUT_HPP
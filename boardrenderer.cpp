@@ -4,10 +4,14 @@
  */
 
 #include "boardrenderer.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace BG {
 
-BoardRenderer::BoardRenderer() {}
+BoardRenderer::BoardRenderer() {
+    std::memcpy(_image, BOARD_IMAGE, kImageSize);
+}
 
 
 /**
@@ -15,38 +19,36 @@ BoardRenderer::BoardRenderer() {}
  *
  * See BoardRenderer::renderPoint declaration for details.
  */
-void BoardRenderer::renderPoint(Side s, unsigned cnt, const Origin &o){
+void BoardRenderer::renderPoint(char *img, Side s, unsigned cnt, const Origin &o){
     char ch = s==BLACK ? BC : s==WHITE ? WC : NC;
-    unsigned ypos=o.y, xpos=o.x;
+    char *cell = img + o.y*kCols + o.x;
+    const ptrdiff_t step = (o.dir==UP) ? -ptrdiff_t(kCols) : ptrdiff_t(kCols);
 
     // Always overwrite exactly five cells in the column so background 'x'/'o' ghosts can't bleed through.
     if (cnt<=5){
-        for(unsigned i=0; i<5; ++i){
-            _image[ypos][xpos] = (i<cnt) ? ch : NC;
-            if(o.dir==UP) --ypos; else ++ypos;
+        for(unsigned i=0; i<5; ++i, cell+=step){
+            *cell = (i<cnt) ? ch : NC;
         }
         return;
     }
 
     if(cnt<10){
         // 4 glyphs + 1 digit
-        for(unsigned i=0; i<4; ++i){
-            _image[ypos][xpos] = ch;
-            if(o.dir==UP) --ypos; else ++ypos;
+        for(unsigned i=0; i<4; ++i, cell+=step){
+            *cell = ch;
         }
-        _image[ypos][xpos] = char('0'+cnt);
+        *cell = char('0'+cnt);
         return;
     }
 
     // cnt >= 10 (max 15): 3 glyphs + two digits (tens then ones along draw direction)
     char tens('1'), ones(char('0'+(cnt%10)));
-    for(unsigned i=0; i<3; ++i){
-        _image[ypos][xpos] = ch;
-        if(o.dir==UP) --ypos; else ++ypos;
+    for(unsigned i=0; i<3; ++i, cell+=step){
+        *cell = ch;
     }
-    _image[ypos][xpos] = (o.dir==UP ? ones : tens);
-    if(o.dir==UP) --ypos; else ++ypos;
-    _image[ypos][xpos] = (o.dir==UP ? tens : ones);
+    *cell = (o.dir==UP ? ones : tens);
+    cell += step;
+    *cell = (o.dir==UP ? tens : ones);
 }
 
 /**
@@ -54,54 +56,71 @@ void BoardRenderer::renderPoint(Side s, unsigned cnt, const Origin &o){
  * @param os Output stream to receive the image.
  */
 void BoardRenderer::print(std::ostream &os) const {
-    for(const std::string &str: _image){
-        os << str;
-    }
+    os.write(_image, kImageSize);
 }
 
 /**
  * @brief Render a full board snapshot onto a fresh background image.
  * @param s Board state as produced by Board::getState().
+ */
+void BoardRenderer::render(const Board::State &s) {
+    renderTo(s, _image);
+}
+
+/**
+ * @brief Render a snapshot into @p buf, starting from the background art.
  *
  * Draw order: points 1..24, then bars/off areas.
  */
-void BoardRenderer::render(const Board::State &s) {
-    _image = BOARD_IMAGE; // reset before drawing
+void BoardRenderer::renderTo(const Board::State &s, char *buf) {
+    std::memcpy(buf, BOARD_IMAGE, kImageSize); // reset before drawing
     for (unsigned i=0; i<24; ++i) {
-        const Origin &o=PO[i];
-        renderPoint(s.points[i].side, s.points[i].count, o);
+        renderPoint(buf, s.points[i].side, s.points[i].count, PO[i]);
+    }
+    renderPoint(buf, WHITE, s.whitebar, WHITEBAR);
+    renderPoint(buf, BLACK, s.blackbar, BLACKBAR);
+    renderPoint(buf, WHITE, s.whiteoff, WHITEOFF);
+    renderPoint(buf, BLACK, s.blackoff, BLACKOFF);
+}
+
+/**
+ * @brief Render @p n snapshots into @p os, staging up to 16 images per write.
+ */
+void BoardRenderer::renderAll(const Board::State *states, size_t n, std::ostream &os) {
+    constexpr size_t kBatch = 16;
+    char buf[kBatch*kImageSize];
+    while (n>0) {
+        size_t k = std::min(n, kBatch);
+        for (size_t i=0; i<k; ++i) renderTo(states[i], buf + i*kImageSize);
+        os.write(buf, std::streamsize(k*kImageSize));
+        states += k;
+        n -= k;
     }
-    renderPoint(WHITE, s.whitebar, WHITEBAR);
-    renderPoint(BLACK, s.blackbar, BLACKBAR);
-    renderPoint(WHITE, s.whiteoff, WHITEOFF);
-    renderPoint(BLACK, s.blackoff, BLACKOFF);
 }
 
 /**
  * @brief Static background art for the board (with guides/labels).
  *
- * The drawing coordinates in PO[] and the bar/off origins are calibrated
- * for this exact layout.
+ * Rows are concatenated into a single kImageSize-byte literal. The drawing
+ * coordinates in PO[] and the bar/off origins are calibrated for this exact layout.
  */
-const BoardRenderer::Image BoardRenderer::BOARD_IMAGE=
-    {
-        " 1 1 1 1 1 1    1 2 2 2 2 2   \n",
-        " 3 4 5 6 7 8    9 0 1 2 3 4   \n",
-        "------------------------------\n",
-        "|x       o   | |o         x| |\n",
-        "|x       o   | |o         x| |\n",
-        "|x       o   | |o          | |\n",
-        "|x           | |o          | |\n",
-        "|x           | |o          | |\n",
-        "|============|=|===========|=|\n",
-        "|o           | |x          | |\n",
-        "|o           | |x          | |\n",
-        "|o       x   | |x          | |\n",
-        "|o       x   | |x         o| |\n",
-        "|o       x   | |x         o| |\n",
-        "------------------------------\n",
-        " 1 1 1 9 8 7    6 5 4 3 2 1   \n",
-        " 2 1 0                        \n"
-};
+const char BoardRenderer::BOARD_IMAGE[kImageSize+1]=
+        " 1 1 1 1 1 1    1 2 2 2 2 2   \n"
+        " 3 4 5 6 7 8    9 0 1 2 3 4   \n"
+        "------------------------------\n"
+        "|x       o   | |o         x| |\n"
+        "|x       o   | |o         x| |\n"
+        "|x       o   | |o          | |\n"
+        "|x           | |o          | |\n"
+        "|x           | |o          | |\n"
+        "|============|=|===========|=|\n"
+        "|o           | |x          | |\n"
+        "|o           | |x          | |\n"
+        "|o       x   | |x          | |\n"
+        "|o       x   | |x         o| |\n"
+        "|o       x   | |x         o| |\n"
+        "------------------------------\n"
+        " 1 1 1 9 8 7    6 5 4 3 2 1   \n"
+        " 2 1 0                        \n";
 
 } // namespace BG
@@ -21,11 +21,20 @@ namespace BG {
  * @code
  *   BG::Board b; BG::Board::State s; b.getState(s);
  *   BG::BoardRenderer r; r.render(s); r.print(std::cout);
+ *
+ *   // Allocation-free variant for bulk output:
+ *   char buf[BG::BoardRenderer::kImageSize]; BG::BoardRenderer::renderTo(s, buf);
  * @endcode
  */
 class BoardRenderer
 {
 public:
+    /// Image geometry: rows, and columns per row including the trailing '\n'.
+    static constexpr size_t kRows = 17, kCols = 31;
+
+    /// Size in bytes of one rendered image (no terminating NUL is written).
+    static constexpr size_t kImageSize = kRows*kCols;
+
     /// Construct a renderer with its default background board image.
     BoardRenderer();
 
@@ -43,15 +52,37 @@ public:
      */
     void print(std::ostream &os) const;
 
-private:
-    /// A 2D ASCII image, one string per row.
-    typedef std::vector<std::string> Image;
+    /**
+     * @brief Render a snapshot directly into a caller-provided buffer.
+     * @param s   A Board::State as filled by Board::getState().
+     * @param buf Destination of at least kImageSize bytes.
+     *
+     * Performs no allocation and touches no renderer state; safe to call
+     * concurrently from many threads with distinct buffers.
+     */
+    static void renderTo(const Board::State &s, char *buf);
 
-    /// Immutable background board art.
-    static const Image BOARD_IMAGE;
+    /**
+     * @brief Render many snapshots back to back into one output stream.
+     * @param states Array of @p n snapshots.
+     * @param n      Number of snapshots.
+     * @param os     Target stream; receives n*kImageSize bytes.
+     *
+     * Images are staged in a fixed stack buffer and written in large chunks.
+     */
+    static void renderAll(const Board::State *states, size_t n, std::ostream &os);
+
+    /// Convenience overload of renderAll() for a vector of snapshots.
+    static void renderAll(const std::vector<Board::State> &states, std::ostream &os) {
+        renderAll(states.data(), states.size(), os);
+    }
+
+private:
+    /// Immutable background board art, kRows rows of kCols bytes.
+    static const char BOARD_IMAGE[kImageSize+1];
 
-    /// Draw buffer (initialized with BOARD_IMAGE).
-    Image _image=BOARD_IMAGE;
+    /// Draw buffer (reset from BOARD_IMAGE on every render()).
+    char _image[kImageSize];
 
     /**
      * @enum Dir
@@ -63,7 +94,7 @@ private:
     enum class Dir{UP, DOWN};
 
     /// Convenience aliases for directions.
-    const Dir UP=Dir::UP, DOWN=Dir::DOWN;
+    static constexpr Dir UP=Dir::UP, DOWN=Dir::DOWN;
 
     /**
      * @struct Origin
@@ -77,6 +108,7 @@ private:
 
     /**
      * @brief Draw a checker stack at a given origin.
+     * @param img Image buffer of kImageSize bytes.
      * @param s   Side that owns the stack (or NONE).
      * @param cnt Number of checkers on the stack.
      * @param o   Where and in which direction to draw.
@@ -89,10 +121,10 @@ private:
      *
      *  Writing spaces for unused cells ensures the background art is fully overwritten.
      */
-    void renderPoint(Side s, unsigned cnt, const Origin &o);
+    static void renderPoint(char *img, Side s, unsigned cnt, const Origin &o);
 
     /// Characters used when drawing.
-    const char
+    static constexpr char
         WC='X', ///< White checker glyph
         BC='O', ///< Black checker glyph
         NC=' '; ///< Space used to overwrite background for unused cells
@@ -103,7 +135,7 @@ private:
      * Indices 0..11 represent points 1..12 on the top half (draw UP),
      * indices 12..23 represent points 13..24 on the bottom half (draw DOWN).
      */
-    const Origin
+    static constexpr Origin
         PO[24]={
             /*  1 */ {UP, 26, 13},
             /*  2 */ {UP, 24, 13},
@@ -141,7 +173,7 @@ private:
         //   15..16: bottom labels
 
         // Bars at x=14, Off ladders at x=28. Keep each strictly inside its half.
-        const Origin
+        static constexpr Origin
         WHITEBAR = {UP,   14, 7},   // rows 7..3  (upper gutter, drawn upward)
         BLACKBAR = {DOWN, 14, 9},   // rows 9..13 (lower gutter, drawn downward)
 
@@ -12,6 +12,7 @@
 #include <functional>
 #include <memory>
 #include <chrono>   // <-- added
+#include <cstdio>
 
 #include "bg/v1/bg.grpc.pb.h"
 #include "bg/v1/bg.pb.h"
@@ -63,7 +64,7 @@ static BG::Side toSide(proto::Side s){
   }
 }
 
-struct Model { proto::BoardState st; uint64_t ver=0; std::string msg; };
+struct Model { proto::BoardState st; uint64_t ver=0; std::string msg; std::string hint; };
 
 // global flags toggled by signals / reader thread
 static std::atomic<bool> g_resized{false};
@@ -139,7 +140,7 @@ int main(){
     if (fullClear) { clearok(stdscr, TRUE); erase(); }
 
     // header/help
-    mvprintw(0, 0, "bg_tui — Enter=commit · two numbers or 'step FROM PIP' · 'roll' 'set d1 d2' 'undo' 'double' 'take' 'drop' · 'help' · 'quit'");
+    mvprintw(0, 0, "bg_tui — Enter=commit · two numbers or 'step FROM PIP' · 'roll' 'set d1 d2' 'undo' 'double' 'take' 'drop' 'hint' · 'help' · 'quit'");
     wnoutrefresh(stdscr);
 
     // If we don't have a snapshot yet, don't paint an "empty" board.
@@ -205,6 +206,7 @@ int main(){
       "  cubeHolder=" + holderStr;
     
     if (!model.msg.empty()) info += "  ·  " + model.msg;
+    if (!model.hint.empty()) info += "  ·  " + model.hint;
     
     attron(COLOR_PAIR(4));
     addnstr(info.c_str(), COLS - 1); // avoid wrapping
@@ -217,6 +219,7 @@ int main(){
   auto chan = grpc::CreateChannel("127.0.0.1:50051", grpc::InsecureChannelCredentials());
   std::unique_ptr<proto::AuthService::Stub>  auth (proto::AuthService::NewStub(chan));
   std::unique_ptr<proto::MatchService::Stub> match(proto::MatchService::NewStub(chan));
+  std::unique_ptr<proto::HintService::Stub>  hints(proto::HintService::NewStub(chan));
 
   // login
   proto::LoginReq lr; lr.set_username("alice"); lr.set_password("pw");
@@ -298,7 +301,47 @@ int main(){
   paintUI(model, /*fullClear*/true);
   draw_prompt();
 
-  auto send = [&](const proto::Envelope& e){ stream->Write(e); };
+  // Hints stream in on their own thread, each deeper ranking replacing the last.
+  // Any command (or a new hint) cancels the one in flight so the server stops searching.
+  std::unique_ptr<grpc::ClientContext> hintCtx;
+  std::thread hintThread;
+  auto cancelHint = [&](){
+    if (hintCtx) hintCtx->TryCancel();
+    if (hintThread.joinable()) hintThread.join();
+    hintCtx.reset();
+  };
+  auto startHint = [&](){
+    cancelHint();
+    proto::HintRequest rq;
+    { std::lock_guard<std::mutex> lk(mtx); *rq.mutable_state() = model.st; model.hint = "hint: thinking…"; }
+    g_need_repaint = true;
+    hintCtx = std::make_unique<grpc::ClientContext>();
+    hintThread = std::thread([&, rq, ctx = hintCtx.get()](){
+      auto reader = hints->Hint(ctx, rq);
+      proto::HintUpdate u;
+      while (reader->Read(&u)){
+        std::string h = "hint " + std::to_string(u.plies()) + "-ply" + (u.final() ? "" : "…") + ":";
+        for (int i = 0; i < u.plays_size() && i < 3; ++i){
+          char eq[16]; std::snprintf(eq, sizeof eq, "%+.3f", u.plays(i).equity());
+          h += " " + (u.plays(i).text().empty() ? std::string("(no move)") : u.plays(i).text()) + " " + eq + (i+1 < u.plays_size() && i < 2 ? " |" : "");
+        }
+        { std::lock_guard<std::mutex> lk(mtx); model.hint = h; }
+        g_need_repaint = true;
+        if (log) log->log("[evt] hint plies=", u.plies(), " final=", u.final());
+      }
+      Status hs = reader->Finish();
+      if (!hs.ok() && hs.error_code() != grpc::StatusCode::CANCELLED){
+        { std::lock_guard<std::mutex> lk(mtx); model.hint = "hint failed: " + hs.error_message(); }
+        g_need_repaint = true;
+      }
+    });
+  };
+
+  auto send = [&](const proto::Envelope& e){
+    cancelHint();
+    { std::lock_guard<std::mutex> lk(mtx); model.hint.clear(); }
+    stream->Write(e);
+  };
 
   // REPL/main loop — fully non-blocking
   while (running){
@@ -361,7 +404,7 @@ int main(){
       if (line == "quit" || line == "exit") break;
       if (line == "help"){
         std::lock_guard<std::mutex> lk(mtx);
-        model.msg = "two numbers=step, 'step a b', Enter=commit, 'roll', 'set d1 d2', 'undo', 'double', 'take', 'drop', 'snap', 'redraw', 'quit'";
+        model.msg = "two numbers=step, 'step a b', Enter=commit, 'roll', 'set d1 d2', 'undo', 'double', 'take', 'drop', 'hint', 'snap', 'redraw', 'quit'";
         g_need_repaint = true;
         continue;
       }
@@ -416,6 +459,7 @@ int main(){
       if (line == "double"){ proto::Envelope e; e.mutable_header()->set_match_id("m1"); e.mutable_cmd()->mutable_offer_cube(); send(e); if (log) log->log("[cmd] double"); g_need_repaint = true; continue; }
       if (line == "take"){ proto::Envelope e; e.mutable_header()->set_match_id("m1"); e.mutable_cmd()->mutable_take_cube(); send(e); if (log) log->log("[cmd] take"); g_need_repaint = true; continue; }
       if (line == "drop"){ proto::Envelope e; e.mutable_header()->set_match_id("m1"); e.mutable_cmd()->mutable_drop_cube(); send(e); if (log) log->log("[cmd] drop"); g_need_repaint = true; continue; }
+      if (line == "hint"){ startHint(); if (log) log->log("[cmd] hint"); continue; }
       if (line == "snap"){ proto::Envelope e; e.mutable_header()->set_match_id("m1"); e.mutable_cmd()->mutable_request_snapshot(); send(e); if (log) log->log("[cmd] snap"); g_need_repaint = true; continue; }
 
       { std::lock_guard<std::mutex> lk(mtx); model.msg = "unknown command (type 'help')"; }
@@ -436,6 +480,7 @@ int main(){
     draw_prompt();
   }
 
+  cancelHint();
   stream->WritesDone();
   auto st = stream->Finish();
   endwin();
@@ -0,0 +1,339 @@
+/**
+ * @file columnar.cpp
+ * @brief Column file writer and mapped reader.
+ */
+
+#include "columnar.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#ifdef BG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace BG {
+
+namespace {
+
+constexpr char     COL_MAGIC[4] = {'B','G','C','F'};
+constexpr uint32_t COL_VERSION  = 2;
+constexpr size_t   CHUNK_HEADER = 32;
+
+inline uint64_t pad8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+inline bool isFloat(ColType t) { return t==ColType::F32 || t==ColType::F64; }
+
+inline uint64_t loadU(ColType t, const uint8_t *p) {
+    switch (t) {
+        case ColType::U8:  return *p;
+        case ColType::U16: { uint16_t v; std::memcpy(&v, p, 2); return v; }
+        case ColType::U32: { uint32_t v; std::memcpy(&v, p, 4); return v; }
+        default:           { uint64_t v; std::memcpy(&v, p, 8); return v; }
+    }
+}
+
+inline void storeU(ColType t, uint8_t *p, uint64_t v) {
+    switch (t) {
+        case ColType::U8:  *p = uint8_t(v); break;
+        case ColType::U16: { uint16_t x=uint16_t(v); std::memcpy(p, &x, 2); break; }
+        case ColType::U32: { uint32_t x=uint32_t(v); std::memcpy(p, &x, 4); break; }
+        default:           std::memcpy(p, &v, 8); break;
+    }
+}
+
+inline double loadF(ColType t, const uint8_t *p) {
+    if (t==ColType::F32) { float v; std::memcpy(&v, p, 4); return v; }
+    double v; std::memcpy(&v, p, 8); return v;
+}
+
+void encodeDelta(ColType t, const uint8_t *p, uint64_t rows, std::vector<uint8_t> &out) {
+    size_t ts = colTypeSize(t);
+    uint64_t prev = 0;
+    for (uint64_t i=0; i<rows; ++i, p+=ts) {
+        uint64_t v = loadU(t, p);
+        int64_t d = int64_t(v - prev);
+        uint64_t z = (uint64_t(d) << 1) ^ uint64_t(d >> 63);
+        while (z>=0x80) { out.push_back(uint8_t(z|0x80)); z >>= 7; }
+        out.push_back(uint8_t(z));
+        prev = v;
+    }
+}
+
+void decodeDelta(ColType t, std::span<const uint8_t> in, uint64_t rows, uint8_t *out) {
+    size_t ts = colTypeSize(t);
+    const uint8_t *p = in.data(), *end = p + in.size();
+    uint64_t prev = 0;
+    for (uint64_t i=0; i<rows; ++i, out+=ts) {
+        uint64_t z=0; int shift=0;
+        for (;;) {
+            if (p>=end || shift>=64) throw std::runtime_error("columnar: corrupt delta chunk");
+            uint8_t b = *p++;
+            z |= uint64_t(b&0x7F) << shift;
+            if (!(b&0x80)) break;
+            shift += 7;
+        }
+        int64_t d = int64_t(z>>1) ^ -int64_t(z&1);
+        prev += uint64_t(d);
+        storeU(t, out, prev);
+    }
+}
+
+} // namespace
+
+size_t colTypeSize(ColType t) {
+    switch (t) {
+        case ColType::U8:  return 1;
+        case ColType::U16: return 2;
+        case ColType::U32: case ColType::F32: return 4;
+        case ColType::U64: case ColType::F64: return 8;
+    }
+    throw std::invalid_argument("columnar: bad column type");
+}
+
+bool codecAvailable(ColCodec c) {
+    switch (c) {
+        case ColCodec::None: case ColCodec::Delta: return true;
+#ifdef BG_HAVE_ZLIB
+        case ColCodec::Zlib: return true;
+#else
+        case ColCodec::Zlib: return false;
+#endif
+    }
+    return false;
+}
+
+// ===== Writer =================================================================
+
+ColumnWriter::ColumnWriter(const std::string &path, std::vector<ColumnSpec> cols, uint64_t resumeAt)
+    : _path(path), _cols(std::move(cols))
+{
+    for (const ColumnSpec &c : _cols) {
+        colTypeSize(c.type);
+        if (!codecAvailable(c.codec)) throw std::runtime_error(path + ": column codec not available in this build");
+    }
+    if (resumeAt==0) {
+        _f = std::fopen(path.c_str(), "wb");
+        if (!_f) throw std::runtime_error(path + ": " + std::strerror(errno));
+        writeSchema();
+        return;
+    }
+
+    // Resume: the schema on disk must match, then drop anything past the checkpoint.
+    _f = std::fopen(path.c_str(), "r+b");
+    if (!_f) throw std::runtime_error(path + ": " + std::strerror(errno));
+    {
+        ColumnReader r(path);
+        bool same = r.columns().size()==_cols.size();
+        for (size_t i=0; same && i<_cols.size(); ++i)
+            same = r.columns()[i].name==_cols[i].name && r.columns()[i].type==_cols[i].type;
+        if (!same) { std::fclose(_f); _f=nullptr; throw std::runtime_error(path + ": schema does not match"); }
+    }
+    if (::ftruncate(::fileno(_f), off_t(resumeAt))!=0 || ::fseeko(_f, off_t(resumeAt), SEEK_SET)!=0) {
+        int e=errno; std::fclose(_f); _f=nullptr;
+        throw std::runtime_error(path + ": " + std::strerror(e));
+    }
+    _bytes = resumeAt;
+}
+
+ColumnWriter::~ColumnWriter() {
+    if (_f) std::fclose(_f);
+}
+
+void ColumnWriter::writeSchema() {
+    std::vector<uint8_t> h(COL_MAGIC, COL_MAGIC+4);
+    auto u32 = [&](uint32_t v){ for (int i=0; i<4; ++i) h.push_back(uint8_t(v>>(8*i))); };
+    u32(COL_VERSION);
+    u32(uint32_t(_cols.size()));
+    for (const ColumnSpec &c : _cols) {
+        h.push_back(uint8_t(c.type));
+        h.push_back(uint8_t(c.name.size())); h.push_back(uint8_t(c.name.size()>>8));
+        h.insert(h.end(), c.name.begin(), c.name.end());
+    }
+    h.resize(pad8(h.size()), 0);
+    if (std::fwrite(h.data(), 1, h.size(), _f)!=h.size()) throw std::runtime_error(_path + ": write failed");
+    _bytes = h.size();
+}
+
+void ColumnWriter::writeGroup(uint64_t rows, const std::vector<const void*> &data) {
+    if (data.size()!=_cols.size()) throw std::invalid_argument("ColumnWriter: one data pointer per column required");
+    static const uint8_t zeros[8] = {};
+    auto put = [&](const void *p, size_t n){
+        if (n && std::fwrite(p, 1, n, _f)!=n) throw std::runtime_error(_path + ": write failed");
+        _bytes += n;
+    };
+    put(&rows, 8);
+    for (size_t c=0; c<_cols.size(); ++c) {
+        const ColumnSpec &spec = _cols[c];
+        const uint8_t *raw = static_cast<const uint8_t*>(data[c]);
+        size_t ts = colTypeSize(spec.type);
+        uint64_t n = rows*ts;
+
+        // Statistics.
+        uint64_t lo=0, hi=0;
+        if (rows) {
+            if (isFloat(spec.type)) {
+                double mn=INFINITY, mx=-INFINITY;
+                for (uint64_t i=0; i<rows; ++i) {
+                    double v = loadF(spec.type, raw+i*ts);
+                    if (v<mn) mn=v;
+                    if (v>mx) mx=v;
+                }
+                std::memcpy(&lo, &mn, 8); std::memcpy(&hi, &mx, 8);
+            } else {
+                lo = ~uint64_t(0);
+                for (uint64_t i=0; i<rows; ++i) {
+                    uint64_t v = loadU(spec.type, raw+i*ts);
+                    if (v<lo) lo=v;
+                    if (v>hi) hi=v;
+                }
+            }
+        }
+
+        // Encoding; anything that does not shrink is stored plain.
+        ColCodec codec = spec.codec;
+        const uint8_t *body = raw;
+        uint64_t stored = n;
+        _enc.clear();
+        if (codec==ColCodec::Delta && !isFloat(spec.type)) {
+            encodeDelta(spec.type, raw, rows, _enc);
+        }
+#ifdef BG_HAVE_ZLIB
+        else if (codec==ColCodec::Zlib && n>0) {
+            uLongf len = compressBound(uLong(n));
+            _enc.resize(len);
+            if (compress2(_enc.data(), &len, raw, uLong(n), Z_DEFAULT_COMPRESSION)!=Z_OK)
+                throw std::runtime_error(_path + ": zlib compression failed");
+            _enc.resize(len);
+        }
+#endif
+        if (!_enc.empty() && _enc.size()<n) { body = _enc.data(); stored = _enc.size(); }
+        else codec = ColCodec::None;
+
+        uint8_t hdr[CHUNK_HEADER] = {};
+        uint32_t cv = uint32_t(codec);
+        std::memcpy(hdr, &cv, 4);
+        std::memcpy(hdr+8, &stored, 8);
+        std::memcpy(hdr+16, &lo, 8);
+        std::memcpy(hdr+24, &hi, 8);
+        put(hdr, CHUNK_HEADER);
+        put(body, size_t(stored));
+        put(zeros, size_t(pad8(stored)-stored));
+    }
+}
+
+uint64_t ColumnWriter::sync() {
+    if (std::fflush(_f)!=0 || ::fsync(::fileno(_f))!=0) throw std::runtime_error(_path + ": " + std::strerror(errno));
+    return _bytes;
+}
+
+// ===== Reader =================================================================
+
+ColumnReader::ColumnReader(const std::string &path) : _file(path) {
+    const uint8_t *base = reinterpret_cast<const uint8_t*>(_file.data());
+    const uint8_t *p = base, *end = base + _file.size();
+    auto need = [&](size_t n){ if (size_t(end-p)<n) throw std::runtime_error(path + ": truncated column file"); };
+
+    need(12);
+    if (std::memcmp(p, COL_MAGIC, 4)!=0) throw std::runtime_error(path + ": not a column file");
+    uint32_t ver, ncols;
+    std::memcpy(&ver, p+4, 4); std::memcpy(&ncols, p+8, 4);
+    if (ver!=COL_VERSION) throw std::runtime_error(path + ": unsupported column file version " + std::to_string(ver));
+    p += 12;
+    for (uint32_t i=0; i<ncols; ++i) {
+        need(3);
+        ColumnSpec c;
+        c.type = ColType(p[0]);
+        colTypeSize(c.type);
+        size_t len = size_t(p[1]) | size_t(p[2])<<8;
+        p += 3;
+        need(len);
+        c.name.assign(reinterpret_cast<const char*>(p), len);
+        p += len;
+        _cols.push_back(std::move(c));
+    }
+    p = base + pad8(uint64_t(p-base));
+
+    // Groups; stop quietly at a torn tail.
+    while (end-p >= 8) {
+        const uint8_t *g = p;
+        Group grp;
+        std::memcpy(&grp.rows, g, 8); g += 8;
+        bool ok = true;
+        for (size_t c=0; c<_cols.size(); ++c) {
+            if (size_t(end-g) < CHUNK_HEADER) { ok=false; break; }
+            uint32_t cv; uint64_t stored, lo, hi;
+            std::memcpy(&cv, g, 4);
+            std::memcpy(&stored, g+8, 8);
+            std::memcpy(&lo, g+16, 8);
+            std::memcpy(&hi, g+24, 8);
+            g += CHUNK_HEADER;
+            // stored is bounded by the bytes left before padding it, so pad8 cannot wrap.
+            if (stored > uint64_t(end-g) || pad8(stored) > uint64_t(end-g)) { ok=false; break; }
+            // The decoded size rows*ts must follow from stored: exactly for raw
+            // chunks, at least a byte per row for deltas, and at most deflate's
+            // 1032:1 for zlib. Compared by division so a corrupt count cannot wrap.
+            const uint64_t ts = colTypeSize(_cols[c].type);
+            bool fits = true;
+            switch (ColCodec(cv)) {
+                case ColCodec::None:  fits = stored%ts==0 && grp.rows==stored/ts; break;
+                case ColCodec::Delta: fits = grp.rows<=stored; break;
+                case ColCodec::Zlib:  fits = grp.rows <= stored*1032/ts && grp.rows>0; break;
+                default: throw std::runtime_error(path + ": unknown chunk codec");
+            }
+            if (!fits) throw std::runtime_error(path + ": column chunk size does not match its row count");
+
+            Chunk ch;
+            ch.codec = ColCodec(cv);
+            if (isFloat(_cols[c].type)) { std::memcpy(&ch.stats.min, &lo, 8); std::memcpy(&ch.stats.max, &hi, 8); }
+            else { ch.stats.umin = lo; ch.stats.umax = hi; ch.stats.min = double(lo); ch.stats.max = double(hi); }
+            ch.data = { g, size_t(stored) };
+            grp.cols.push_back(ch);
+            g += pad8(stored);
+        }
+        if (!ok) break;
+        _groups.push_back(std::move(grp));
+        p = g;
+    }
+}
+
+std::span<const uint8_t> ColumnReader::read(size_t g, size_t c, std::vector<uint8_t> &buf) const {
+    const Chunk &ch = _groups[g].cols[c];
+    ColType t = _cols[c].type;
+    uint64_t n = _groups[g].rows * colTypeSize(t);
+    switch (ch.codec) {
+        case ColCodec::None:
+            if (ch.data.size()!=n) throw std::runtime_error("columnar: chunk size mismatch");
+            return ch.data;
+        case ColCodec::Delta:
+            buf.resize(size_t(n));
+            decodeDelta(t, ch.data, _groups[g].rows, buf.data());
+            return { buf.data(), buf.size() };
+        case ColCodec::Zlib: {
+#ifdef BG_HAVE_ZLIB
+            buf.resize(size_t(n));
+            uLongf len = uLongf(n);
+            if (uncompress(buf.data(), &len, ch.data.data(), uLong(ch.data.size()))!=Z_OK || len!=n)
+                throw std::runtime_error("columnar: corrupt zlib chunk");
+            return { buf.data(), buf.size() };
+#else
+            throw std::runtime_error("columnar: zlib chunk but built without zlib");
+#endif
+        }
+    }
+    throw std::runtime_error("columnar: unknown chunk codec");
+}
+
+int ColumnReader::find(const std::string &name) const {
+    for (size_t i=0; i<_cols.size(); ++i) if (_cols[i].name==name) return int(i);
+    return -1;
+}
+
+uint64_t ColumnReader::totalRows() const {
+    uint64_t n=0;
+    for (const Group &g : _groups) n += g.rows;
+    return n;
+}
+
+} // namespace BG
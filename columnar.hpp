@@ -0,0 +1,150 @@
+/**
+ * @file columnar.hpp
+ * @brief Minimal column-oriented table files for batch tool output.
+ *
+ * Layout (little-endian):
+ * @code
+ *   "BGCF" u32 version u32 ncols
+ *   { u8 type, u16 nameLen, name }[ncols] pad8                // schema
+ *   { u64 rows, chunk[ncols] }*                               // row groups
+ *   chunk: u32 codec u32 0 u64 stored u64 min u64 max data[stored] pad8
+ * @endcode
+ * Each row group stores every column as its own chunk (8-byte aligned), so a
+ * reader can map the file and scan one column without touching the others.
+ * min/max hold the chunk's value range (integers as u64, floats as the bits
+ * of an f64), which lets a scan skip chunks that cannot match a predicate.
+ * Groups are only ever appended; a torn final group is ignored by the reader.
+ */
+
+#ifndef COLUMNAR_HPP
+#define COLUMNAR_HPP
+
+#include "mappedfile.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+enum class ColType : uint8_t { U8=1, U16, U32, U64, F32, F64 };
+
+/// Size in bytes of one value of @p t.
+size_t colTypeSize(ColType t);
+
+/**
+ * @brief Chunk encoding.
+ *
+ * Delta applies to integer columns only (zigzag deltas as LEB128 varints,
+ * good for ids, counters and sorted keys); float columns asked for Delta
+ * are stored plain. Zlib requires a build with BG_HAVE_ZLIB.
+ */
+enum class ColCodec : uint8_t { None=0, Delta=1, Zlib=2 };
+
+/// True if this build can write and read @p c.
+bool codecAvailable(ColCodec c);
+
+/// Column name, type and the codec used for new chunks.
+struct ColumnSpec {
+    std::string name;
+    ColType type;
+    ColCodec codec = ColCodec::None;
+};
+
+/// Value range of one chunk.
+struct ChunkStats {
+    double min=0, max=0;       ///< as doubles (exact for floats and integers below 2^53)
+    uint64_t umin=0, umax=0;   ///< exact integer range (integer columns)
+};
+
+/**
+ * @class ColumnWriter
+ * @brief Appends row groups to a column file.
+ */
+class ColumnWriter {
+public:
+    /**
+     * @brief Create @p path, or reopen it for appending.
+     * @param resumeAt 0 to create a fresh file; otherwise the byte length of a
+     *                 previous, complete file (e.g., from a checkpoint): the file
+     *                 is truncated to it and its names/types must equal @p cols.
+     * @throws std::runtime_error on I/O errors, a schema mismatch or an unavailable codec.
+     */
+    ColumnWriter(const std::string &path, std::vector<ColumnSpec> cols, uint64_t resumeAt = 0);
+    ~ColumnWriter();
+
+    ColumnWriter(const ColumnWriter&) = delete;
+    ColumnWriter& operator=(const ColumnWriter&) = delete;
+
+    const std::vector<ColumnSpec> &columns() const { return _cols; }
+
+    /**
+     * @brief Append one row group.
+     * @param rows Row count.
+     * @param data One pointer per column to @p rows values of its type.
+     * @throws std::runtime_error on write errors.
+     */
+    void writeGroup(uint64_t rows, const std::vector<const void*> &data);
+
+    /// Flush buffered data and fsync; returns the file length (a safe resume point).
+    uint64_t sync();
+
+private:
+    std::string _path;
+    std::vector<ColumnSpec> _cols;
+    std::FILE *_f=nullptr;
+    uint64_t _bytes=0;
+    std::vector<uint8_t> _enc;     ///< scratch for encoded chunks
+
+    void writeSchema();
+};
+
+/**
+ * @class ColumnReader
+ * @brief Memory-mapped access to a column file's groups.
+ */
+class ColumnReader {
+public:
+    /// @throws std::runtime_error if the file is not a column file, or a chunk's size contradicts its group's row count.
+    explicit ColumnReader(const std::string &path);
+
+    const std::vector<ColumnSpec> &columns() const { return _cols; }
+
+    /// Index of column @p name, or -1.
+    int find(const std::string &name) const;
+
+    size_t groups() const { return _groups.size(); }
+    uint64_t rows(size_t g) const { return _groups[g].rows; }
+    uint64_t totalRows() const;
+
+    ColCodec codec(size_t g, size_t c) const { return _groups[g].cols[c].codec; }
+    const ChunkStats &stats(size_t g, size_t c) const { return _groups[g].cols[c].stats; }
+
+    /**
+     * @brief Decoded bytes of column @p c in group @p g.
+     *
+     * Plain chunks are returned in place (zero copy); encoded chunks are
+     * decoded into @p buf, which the result then points into.
+     * @throws std::runtime_error on a corrupt chunk.
+     */
+    std::span<const uint8_t> read(size_t g, size_t c, std::vector<uint8_t> &buf) const;
+
+    /// Typed read() (T must match the column type's size).
+    template <class T>
+    std::span<const T> column(size_t g, size_t c, std::vector<uint8_t> &buf) const {
+        auto r = read(g, c, buf);
+        return { reinterpret_cast<const T*>(r.data()), r.size()/sizeof(T) };
+    }
+
+private:
+    struct Chunk { ColCodec codec; ChunkStats stats; std::span<const uint8_t> data; };
+    struct Group { uint64_t rows; std::vector<Chunk> cols; };
+    MappedFile _file;
+    std::vector<ColumnSpec> _cols;
+    std::vector<Group> _groups;
+};
+
+} // namespace BG
+
+#endif // COLUMNAR_HPP
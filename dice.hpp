@@ -0,0 +1,79 @@
+/**
+ * @file dice.hpp
+ * @brief Compile-time tables of the 21 distinct rolls for engine loops.
+ */
+
+#ifndef DICE_HPP
+#define DICE_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace BG {
+
+/**
+ * @struct Roll
+ * @brief One distinct roll with its weight out of 36 and its expanded forms.
+ */
+struct Roll {
+    uint8_t hi=0, lo=0;         ///< dice, hi >= lo
+    uint8_t weight=0;           ///< 1 for doubles, 2 otherwise (out of 36)
+    uint8_t n=0;                ///< pips to play: 4 for doubles, 2 otherwise
+    uint8_t pips[4]{};          ///< pip sequence, doubles repeated four times
+    uint8_t orders=0;           ///< distinct die orders: 1 for doubles, 2 otherwise
+    uint8_t order[2][2]{};      ///< {hi, lo} then {lo, hi} (doubles: one order)
+
+    constexpr bool doubles() const { return hi==lo; }
+
+    /// Probability of this roll.
+    constexpr double probability() const { return weight / 36.0; }
+};
+
+namespace detail {
+
+constexpr std::array<Roll, 21> makeRolls() {
+    std::array<Roll, 21> r{};
+    size_t k = 0;
+    for (int hi=1; hi<=6; ++hi) {
+        for (int lo=1; lo<=hi; ++lo, ++k) {
+            Roll &x = r[k];
+            x.hi = uint8_t(hi); x.lo = uint8_t(lo);
+            bool dbl = hi==lo;
+            x.weight = dbl ? 1 : 2;
+            x.n = dbl ? 4 : 2;
+            for (int i=0; i<4; ++i) x.pips[i] = uint8_t(dbl || i==0 ? hi : i==1 ? lo : 0);
+            x.orders = dbl ? 1 : 2;
+            x.order[0][0] = uint8_t(hi); x.order[0][1] = uint8_t(lo);
+            x.order[1][0] = uint8_t(lo); x.order[1][1] = uint8_t(hi);
+        }
+    }
+    return r;
+}
+
+constexpr std::array<std::array<uint8_t, 7>, 7> makeRollIndex(const std::array<Roll, 21> &rolls) {
+    std::array<std::array<uint8_t, 7>, 7> ix{};
+    for (size_t k=0; k<rolls.size(); ++k) {
+        ix[rolls[k].hi][rolls[k].lo] = uint8_t(k);
+        ix[rolls[k].lo][rolls[k].hi] = uint8_t(k);
+    }
+    return ix;
+}
+
+} // namespace detail
+
+/// The 21 distinct rolls, ordered by high die then low die (11, 21, 22, 31, ...).
+inline constexpr std::array<Roll, 21> kRolls = detail::makeRolls();
+
+/// kRollIndex[d1][d2]: position of (d1, d2) in kRolls, either order (dice 1..6).
+inline constexpr std::array<std::array<uint8_t, 7>, 7> kRollIndex = detail::makeRollIndex(kRolls);
+
+/// The Roll for dice (@p d1, @p d2), either order.
+constexpr const Roll &rollOf(int d1, int d2) { return kRolls[kRollIndex[d1][d2]]; }
+
+static_assert([]{ unsigned w=0; for (const Roll &r : kRolls) w += r.weight; return w; }()==36,
+              "roll weights must cover the 36 outcomes");
+static_assert(rollOf(3, 1).hi==3 && rollOf(1, 3).lo==1 && rollOf(4, 4).n==4);
+
+} // namespace BG
+
+#endif // DICE_HPP
@@ -0,0 +1,161 @@
+/**
+ * @file evalcache.cpp
+ * @brief Shared file mapping, creation race and lock-free probing for EvalCache.
+ */
+
+#include "evalcache.hpp"
+#include "positionkey.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BG {
+
+namespace {
+
+constexpr char     CACHE_MAGIC[4] = {'B','G','E','C'};
+constexpr uint32_t CACHE_VERSION  = 1;
+constexpr size_t   CACHE_HEADER   = 64;
+constexpr size_t   CACHE_ENTRIES  = 24;     ///< header offset of the entry count
+constexpr unsigned CACHE_PROBES   = 32;     ///< longest linear probe before giving up
+constexpr uint64_t CACHE_PRESENT  = uint64_t(1) << 32;
+
+struct Slot {
+    uint64_t key;
+    uint64_t value;
+};
+static_assert(sizeof(Slot)==16, "four slots per cache line");
+static_assert(std::atomic_ref<uint64_t>::is_always_lock_free, "slots are shared between processes");
+
+inline uint64_t mix(uint64_t x) {
+    x = (x ^ (x>>30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x>>27)) * 0x94D049BB133111EBull;
+    return x ^ (x>>31);
+}
+
+uint64_t keyOf(const Position &p, unsigned plies, unsigned prune) {
+    uint64_t settings = uint64_t(plies) | uint64_t(prune)<<8 | uint64_t(p.off[0])<<16 | uint64_t(p.off[1])<<24;
+    uint64_t k = mix(PositionId::from(p).hash() ^ mix(settings + 0x9E3779B97F4A7C15ull));
+    return k ? k : 1;
+}
+
+std::runtime_error sysError(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+/// Write an empty cache to a private file and link it in, unless someone else got there first.
+void create(const std::string &path, uint64_t slots, uint64_t fingerprint) {
+    const std::string partial = path + ".partial." + std::to_string(::getpid());
+    int fd = ::open(partial.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd<0) throw sysError(partial);
+    unsigned char hdr[CACHE_HEADER] = {};
+    std::memcpy(hdr, CACHE_MAGIC, 4);
+    std::memcpy(hdr+4, &CACHE_VERSION, 4);
+    std::memcpy(hdr+8, &slots, 8);
+    std::memcpy(hdr+16, &fingerprint, 8);
+    bool ok = ::write(fd, hdr, CACHE_HEADER)==ssize_t(CACHE_HEADER)
+              && ::ftruncate(fd, off_t(CACHE_HEADER + slots*sizeof(Slot)))==0;
+    int e = errno;
+    ::close(fd);
+    if (ok && ::link(partial.c_str(), path.c_str())!=0 && errno!=EEXIST) { ok = false; e = errno; }
+    ::unlink(partial.c_str());
+    if (!ok) { errno = e; throw sysError(path); }
+}
+
+} // namespace
+
+EvalCache::EvalCache(const std::string &path, const Evaluator &ev, uint64_t slots) : _path(path) {
+    const uint64_t fingerprint = weightsFingerprint(ev);
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd<0 && errno==ENOENT) {
+        uint64_t n = 16;
+        while (n<slots) n <<= 1;
+        create(path, n, fingerprint);
+        fd = ::open(path.c_str(), O_RDWR);
+    }
+    if (fd<0) throw sysError(path);
+
+    struct stat st{};
+    unsigned char hdr[CACHE_HEADER];
+    if (::fstat(fd, &st)!=0 || ::pread(fd, hdr, CACHE_HEADER, 0)!=ssize_t(CACHE_HEADER)
+        || std::memcmp(hdr, CACHE_MAGIC, 4)!=0) {
+        ::close(fd);
+        throw std::runtime_error(path + ": not an evaluation cache");
+    }
+    uint32_t ver;
+    uint64_t n, fp;
+    std::memcpy(&ver, hdr+4, 4);
+    std::memcpy(&n, hdr+8, 8);
+    std::memcpy(&fp, hdr+16, 8);
+    std::string why;
+    if (ver!=CACHE_VERSION) why = "unsupported cache version " + std::to_string(ver);
+    else if (n==0 || (n & (n-1)) || CACHE_HEADER + n*sizeof(Slot) > uint64_t(st.st_size)) why = "truncated or corrupt cache";
+    else if (fp!=fingerprint) why = "cache was written for other weights";
+    if (!why.empty()) { ::close(fd); throw std::runtime_error(path + ": " + why); }
+
+    _size = size_t(CACHE_HEADER + n*sizeof(Slot));
+    void *p = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int e = errno;
+    ::close(fd);
+    if (p==MAP_FAILED) { errno = e; throw sysError(path + ": mmap"); }
+    ::madvise(p, _size, MADV_RANDOM);
+    _addr = p;
+    _mask = n-1;
+}
+
+EvalCache::~EvalCache() {
+    if (_addr) ::munmap(_addr, _size);
+}
+
+uint64_t EvalCache::entries() const {
+    auto *count = reinterpret_cast<uint64_t*>(static_cast<char*>(_addr) + CACHE_ENTRIES);
+    return std::atomic_ref<uint64_t>(*count).load(std::memory_order_relaxed);
+}
+
+bool EvalCache::find(const Position &p, unsigned plies, unsigned prune, double &equity) const {
+    const uint64_t key = keyOf(p, plies, prune);
+    Slot *table = reinterpret_cast<Slot*>(static_cast<char*>(_addr) + CACHE_HEADER);
+    for (uint64_t i = key & _mask, n = 0; n<CACHE_PROBES; i = (i+1) & _mask, ++n) {
+        uint64_t k = std::atomic_ref<uint64_t>(table[i].key).load(std::memory_order_acquire);
+        if (k==0) return false;
+        if (k!=key) continue;
+        uint64_t v = std::atomic_ref<uint64_t>(table[i].value).load(std::memory_order_acquire);
+        if (!(v & CACHE_PRESENT)) return false;
+        uint32_t bits = uint32_t(v);
+        float f;
+        std::memcpy(&f, &bits, 4);
+        equity = f;
+        return true;
+    }
+    return false;
+}
+
+void EvalCache::store(const Position &p, unsigned plies, unsigned prune, double equity) {
+    if (entries() >= (_mask+1)/4*3) return;
+    const uint64_t key = keyOf(p, plies, prune);
+    float f = float(equity);
+    uint32_t bits;
+    std::memcpy(&bits, &f, 4);
+    const uint64_t value = CACHE_PRESENT | bits;
+    Slot *table = reinterpret_cast<Slot*>(static_cast<char*>(_addr) + CACHE_HEADER);
+    auto *count = reinterpret_cast<uint64_t*>(static_cast<char*>(_addr) + CACHE_ENTRIES);
+    for (uint64_t i = key & _mask, n = 0; n<CACHE_PROBES; i = (i+1) & _mask, ++n) {
+        std::atomic_ref<uint64_t> k(table[i].key);
+        uint64_t cur = 0;
+        if (k.compare_exchange_strong(cur, key, std::memory_order_acq_rel)) {
+            std::atomic_ref<uint64_t>(*count).fetch_add(1, std::memory_order_relaxed);
+            cur = key;
+        }
+        if (cur!=key) continue;
+        // Ours now, or a racing writer's with the same key: either way the same equity.
+        std::atomic_ref<uint64_t>(table[i].value).store(value, std::memory_order_release);
+        return;
+    }
+}
+
+} // namespace BG
@@ -0,0 +1,78 @@
+/**
+ * @file evalcache.hpp
+ * @brief Persistent, memory-mapped table of searched equities shared by processes and runs.
+ */
+
+#ifndef EVALCACHE_HPP
+#define EVALCACHE_HPP
+
+#include "evaluator.hpp"
+#include <cstdint>
+#include <string>
+
+namespace BG {
+
+/**
+ * @class EvalCache
+ * @brief Insert-only hash table of (position, depth, prune) -> equity in a shared file mapping.
+ *
+ * Every thread and process that maps the same file sees the others'
+ * results, and they outlive the process, so nightly jobs stop recomputing
+ * the same common positions. Slots are two 64-bit atomics: a key (hash
+ * of the PositionId, the off counts and the search settings; 0 = empty)
+ * claimed by compare-and-swap, then the value, published last. No locks
+ * are taken, a reader never waits and a half-written slot reads as a miss.
+ * Keys are 64-bit hashes, so two positions could in principle share one;
+ * at 2^-64 per probe that is accepted, as in any transposition table.
+ *
+ * The file belongs to one set of weights (weightsFingerprint()); opening
+ * it with others throws. It is sized when created (sparse, so untouched
+ * slots cost no disk) and never grows: once three quarters full, or when
+ * a probe runs long, new results are simply not stored.
+ *
+ * File layout (host byte order):
+ * @code
+ *   "BGEC" u32 version u64 slots u64 fingerprint u64 entries   // 64-byte header
+ *   { u64 key; u64 value; } table[slots]                       // slots is a power of two
+ * @endcode
+ * @c value is (1<<32 | float bits of the equity); 0 means not yet written.
+ */
+class EvalCache {
+public:
+    static constexpr uint64_t kDefaultSlots = uint64_t(1) << 22;   ///< 64 MiB
+
+    /**
+     * @brief Open @p path, or create it with @p slots (rounded up to a power of two).
+     *
+     * Creation writes PATH.partial.PID and hard-links it into place, so
+     * processes racing to create the same cache all end up on one file.
+     *
+     * @throws std::runtime_error on I/O errors, a file that is not a cache,
+     *         or a cache written for other weights than @p ev.
+     */
+    EvalCache(const std::string &path, const Evaluator &ev, uint64_t slots = kDefaultSlots);
+    ~EvalCache();
+
+    EvalCache(const EvalCache&) = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+
+    /// Equity stored for @p p (side on roll, before it rolls) searched at @p plies with @p prune.
+    bool find(const Position &p, unsigned plies, unsigned prune, double &equity) const;
+
+    /// Record an equity; safe from any thread or process. Dropped when the table is full.
+    void store(const Position &p, unsigned plies, unsigned prune, double equity);
+
+    uint64_t slots() const { return _mask+1; }
+    uint64_t entries() const;
+    const std::string &path() const { return _path; }
+
+private:
+    std::string _path;
+    void *_addr=nullptr;
+    size_t _size=0;
+    uint64_t _mask=0;
+};
+
+} // namespace BG
+
+#endif // EVALCACHE_HPP
@@ -0,0 +1,118 @@
+/**
+ * @file evaluator.cpp
+ * @brief Feature extraction, linear evaluation and weights file I/O.
+ */
+
+#include "evaluator.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace BG {
+
+namespace {
+
+constexpr char EVAL_MAGIC[4] = {'B','G','E','V'};
+
+// Feature layout (see Evaluator): per-side point units, then the extras.
+constexpr size_t F_OFF  = 200;
+constexpr size_t F_PIPS = 202;
+constexpr size_t F_RACE = 204;
+
+template <class T> void put(std::ostream &o, T v) { o.write(reinterpret_cast<const char*>(&v), sizeof v); }
+template <class T> T get(std::istream &in) {
+    T v{};
+    if (!in.read(reinterpret_cast<char*>(&v), sizeof v)) throw std::runtime_error("evaluator: truncated weights file");
+    return v;
+}
+
+} // namespace
+
+Evaluator::Evaluator() : _w(kOutputs*kStride, 0.f) {
+    // Bootstrap: a pip-race estimate with borne-off counts for the gammon terms.
+    float *win = &_w[0], *wg = &_w[kStride], *lg = &_w[2*kStride];
+    win[F_PIPS] = -10.f; win[F_PIPS+1] = 10.f; win[F_OFF] = 1.f; win[F_OFF+1] = -1.f; win[kInputs] = 0.25f;
+    wg[F_PIPS]  = -6.f;  wg[F_PIPS+1]  = 6.f;  wg[F_OFF+1] = -8.f; wg[kInputs] = -2.5f;
+    lg[F_PIPS]  = 6.f;   lg[F_PIPS+1]  = -6.f; lg[F_OFF]   = -8.f; lg[kInputs] = -2.5f;
+}
+
+void Evaluator::features(const Position &p, float *x) {
+    for (int s=0; s<2; ++s) {
+        float *u = x + s*100;
+        for (int i=0; i<25; ++i, u+=4) {
+            unsigned n = p.checkers[s][i];
+            u[0] = n>=1; u[1] = n>=2; u[2] = n>=3;
+            u[3] = n>3 ? float(n-3)*0.5f : 0.f;
+        }
+        x[F_OFF+s]  = float(p.off[s]) / 15.f;
+        x[F_PIPS+s] = float(p.pips(s)) / 167.f;
+    }
+    x[F_RACE] = p.contact() ? 0.f : 1.f;
+}
+
+Probs Evaluator::evaluate(const Position &p) const {
+    Probs r;
+    if (p.finished(0)) { r.win = 1.f; r.winGammon = p.winMultiplier(0)>=2; return r; }
+    if (p.finished(1)) { r.win = 0.f; r.loseGammon = p.winMultiplier(1)>=2; return r; }
+
+    float x[kInputs];
+    features(p, x);
+    float z[kOutputs];
+    for (size_t o=0; o<kOutputs; ++o) {
+        const float *w = &_w[o*kStride];
+        float acc = w[kInputs];
+        for (size_t i=0; i<kInputs; ++i) acc += w[i]*x[i];
+        z[o] = acc;
+    }
+    r.win = sigmoid(z[0]);
+    // A gammon needs the win first; clamp so the outputs stay consistent.
+    r.winGammon  = std::min(sigmoid(z[1]), r.win);
+    r.loseGammon = std::min(sigmoid(z[2]), 1.f - r.win);
+    if (p.off[1]>0) r.winGammon = 0.f;
+    if (p.off[0]>0) r.loseGammon = 0.f;
+    return r;
+}
+
+Evaluator Evaluator::load(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error(path + ": cannot open weights file");
+    char magic[4];
+    if (!in.read(magic, 4) || std::memcmp(magic, EVAL_MAGIC, 4)!=0) throw std::runtime_error(path + ": not a weights file");
+    uint32_t fmt = get<uint32_t>(in), nin = get<uint32_t>(in), nout = get<uint32_t>(in);
+    if (fmt!=kFormat) throw std::runtime_error(path + ": unsupported weights format " + std::to_string(fmt));
+    if (nin!=kInputs || nout!=kOutputs) throw std::runtime_error(path + ": weights shape does not match this build");
+    Evaluator e;
+    e.generation = get<uint32_t>(in);
+    uint32_t len = get<uint32_t>(in);
+    if (len>4096) throw std::runtime_error(path + ": bad name length");
+    e.name.resize(len);
+    if (!in.read(e.name.data(), len)) throw std::runtime_error(path + ": truncated weights file");
+    if (!in.read(reinterpret_cast<char*>(e._w.data()), std::streamsize(e._w.size()*sizeof(float))))
+        throw std::runtime_error(path + ": truncated weights file");
+    return e;
+}
+
+void Evaluator::save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error(path + ": cannot create weights file");
+    out.write(EVAL_MAGIC, 4);
+    put<uint32_t>(out, kFormat);
+    put<uint32_t>(out, uint32_t(kInputs));
+    put<uint32_t>(out, uint32_t(kOutputs));
+    put<uint32_t>(out, generation);
+    put<uint32_t>(out, uint32_t(name.size()));
+    out.write(name.data(), std::streamsize(name.size()));
+    out.write(reinterpret_cast<const char*>(_w.data()), std::streamsize(_w.size()*sizeof(float)));
+    out.flush();
+    if (!out) throw std::runtime_error(path + ": write failed");
+}
+
+uint64_t weightsFingerprint(const Evaluator &ev) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    const auto *p = reinterpret_cast<const unsigned char*>(ev.weights().data());
+    for (size_t i=0; i<ev.weights().size()*sizeof(float); ++i) h = (h ^ p[i]) * 0x100000001B3ull;
+    return h;
+}
+
+} // namespace BG
@@ -0,0 +1,88 @@
+/**
+ * @file evaluator.hpp
+ * @brief Static position evaluator: raw-board features into three sigmoid outputs.
+ */
+
+#ifndef EVALUATOR_HPP
+#define EVALUATOR_HPP
+
+#include "position.hpp"
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @struct Probs
+ * @brief Cubeless outcome estimates for the side on roll.
+ */
+struct Probs {
+    float win=0.5f;         ///< P(win)
+    float winGammon=0.f;    ///< P(win a gammon or better)
+    float loseGammon=0.f;   ///< P(lose a gammon or worse)
+
+    /// Cubeless equity in points per unit cube.
+    double equity() const { return 2.0*win - 1.0 + winGammon - loseGammon; }
+};
+
+/**
+ * @class Evaluator
+ * @brief Linear model with one sigmoid per output over a fixed feature vector.
+ *
+ * Features per side (own view): for each point and the bar, four units
+ * (n>=1, n>=2, n>=3, (n-3)/2 beyond three); plus off/15, pips/167 and a
+ * race flag. A default-constructed evaluator carries hand-set bootstrap
+ * weights (pip race and borne-off counts) until trained weights are loaded.
+ *
+ * Weights file (little-endian):
+ * @code
+ *   "BGEV" u32 format u32 inputs u32 outputs u32 generation str name
+ *   f32 weights[outputs][inputs+1]   // last column is the bias
+ * @endcode
+ */
+class Evaluator {
+public:
+    static constexpr uint32_t kFormat  = 1;
+    static constexpr size_t   kInputs  = 2*25*4 + 2 + 2 + 1;
+    static constexpr size_t   kOutputs = 3;
+    static constexpr size_t   kStride  = kInputs + 1;
+
+    Evaluator();
+
+    /**
+     * @brief Load weights from a file.
+     * @throws std::runtime_error on I/O errors or a format/shape mismatch.
+     */
+    static Evaluator load(const std::string &path);
+
+    /// @throws std::runtime_error on I/O errors.
+    void save(const std::string &path) const;
+
+    /// Estimates for the side on roll (exact for finished games).
+    Probs evaluate(const Position &p) const;
+
+    /// Fill @p x[kInputs] with the features of @p p.
+    static void features(const Position &p, float *x);
+
+    /// Raw weights, kOutputs rows of kStride floats.
+    std::vector<float> &weights() { return _w; }
+    const std::vector<float> &weights() const { return _w; }
+
+    std::string name = "bootstrap";   ///< free-form label (e.g., training run)
+    uint32_t generation = 0;          ///< bumped by each training save
+
+private:
+    std::vector<float> _w;
+};
+
+/// Hash of an evaluator's raw weights (FNV-1a), for files and jobs tied to one set of weights.
+uint64_t weightsFingerprint(const Evaluator &ev);
+
+/// Logistic function used by the output units.
+inline float sigmoid(float z) { return 1.f / (1.f + std::exp(-z)); }
+
+} // namespace BG
+
+#endif // EVALUATOR_HPP
@@ -0,0 +1,394 @@
+/**
+ * @file gamerecord.cpp
+ * @brief Record encoding/decoding, CRC-checked blocks and replay onto Board.
+ */
+
+#include "gamerecord.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace BG {
+
+// ===== CRC-32 =================================================================
+
+static constexpr std::array<uint32_t,256> makeCrcTable() {
+    std::array<uint32_t,256> t{};
+    for (uint32_t i=0; i<256; ++i) {
+        uint32_t c=i;
+        for (int k=0; k<8; ++k) c = (c&1) ? 0xEDB88320u ^ (c>>1) : c>>1;
+        t[i]=c;
+    }
+    return t;
+}
+static constexpr std::array<uint32_t,256> CRC_TABLE = makeCrcTable();
+
+uint32_t crc32(const void *data, size_t n, uint32_t crc) {
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    while (n--) crc = CRC_TABLE[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// ===== Encoding helpers =======================================================
+
+static const uint8_t FILE_MAGIC[4] = {'B','G','R','C'};
+static const uint8_t FILE_VERSION = 1;
+static const size_t  FILE_HEADER_SIZE = 8;
+
+enum : uint8_t {
+    TAG_GAMESTART=0x10, TAG_OPENING=0x20, TAG_ROLL=0x30, TAG_PLAY=0x40,
+    TAG_DOUBLE=0x50, TAG_TAKE=0x51, TAG_DROP=0x52, TAG_GAMEEND=0x60
+};
+
+static void putVarint(std::vector<uint8_t> &b, uint64_t v) {
+    while (v>=0x80) { b.push_back(uint8_t(v|0x80)); v>>=7; }
+    b.push_back(uint8_t(v));
+}
+
+static void putString(std::vector<uint8_t> &b, const std::string &s) {
+    putVarint(b, s.size());
+    b.insert(b.end(), s.begin(), s.end());
+}
+
+static inline uint8_t packDice(int a, int b) {
+    if (a<1||a>6||b<1||b>6) throw std::invalid_argument("RecordWriter: dice out of range");
+    return uint8_t(a<<3 | b);
+}
+
+static uint64_t getVarint(const uint8_t *&p, const uint8_t *end) {
+    uint64_t v=0;
+    for (int shift=0; shift<64; shift+=7) {
+        if (p>=end) throw RecordError("record: truncated varint");
+        uint8_t c=*p++;
+        v |= uint64_t(c&0x7F) << shift;
+        if (!(c&0x80)) return v;
+    }
+    throw RecordError("record: varint too long");
+}
+
+static uint8_t getByte(const uint8_t *&p, const uint8_t *end) {
+    if (p>=end) throw RecordError("record: truncated event");
+    return *p++;
+}
+
+static void getString(const uint8_t *&p, const uint8_t *end, std::string &s) {
+    uint64_t n = getVarint(p, end);
+    if (n > uint64_t(end-p)) throw RecordError("record: truncated string");
+    s.assign(reinterpret_cast<const char*>(p), size_t(n));
+    p += n;
+}
+
+static void unpackDice(uint8_t v, int &a, int &b) {
+    a = v>>3; b = v&7;
+    if (a<1||a>6||b<1||b>6) throw RecordError("record: dice out of range");
+}
+
+// ===== Writer =================================================================
+
+RecordWriter::RecordWriter(std::ostream &out, bool fileHeader, size_t blockSize)
+    : _out(out), _blockSize(std::min(blockSize, RECORD_MAX_BLOCK/2))
+{
+    _buf.reserve(_blockSize + 64);
+    if (fileHeader) {
+        uint8_t h[FILE_HEADER_SIZE] = {FILE_MAGIC[0],FILE_MAGIC[1],FILE_MAGIC[2],FILE_MAGIC[3], FILE_VERSION, 0,0,0};
+        _out.write(reinterpret_cast<const char*>(h), sizeof h);
+    }
+}
+
+RecordWriter::~RecordWriter() {
+    try { flush(); } catch (...) {}
+}
+
+void RecordWriter::endEvent() {
+    if (_buf.size() >= _blockSize) flush();
+}
+
+void RecordWriter::gameStart(const GameHeader &h) {
+    _buf.push_back(TAG_GAMESTART);
+    putVarint(_buf, h.gameId);
+    putVarint(_buf, h.matchLength);
+    putVarint(_buf, h.scoreWhite);
+    putVarint(_buf, h.scoreBlack);
+    uint8_t flags = (h.crawford ? 1 : 0)
+                  | (h.rules.openingDoublePolicy==Rules::OpeningDoublePolicy::AUTODOUBLE ? 2 : 0)
+                  | (uint8_t(h.rules.variant) << 2);
+    _buf.push_back(flags);
+    putVarint(_buf, h.rules.maxOpeningAutoDoubles);
+    putString(_buf, h.white);
+    putString(_buf, h.black);
+    endEvent();
+}
+
+void RecordWriter::openingRoll(int whiteDie, int blackDie) {
+    uint8_t d = packDice(whiteDie, blackDie);
+    _buf.push_back(TAG_OPENING);
+    _buf.push_back(d);
+    endEvent();
+}
+
+void RecordWriter::roll(int d1, int d2) {
+    uint8_t d = packDice(d1, d2);
+    _buf.push_back(TAG_ROLL);
+    _buf.push_back(d);
+    endEvent();
+}
+
+void RecordWriter::play(const Play &p) {
+    if (p.n>4) throw std::invalid_argument("RecordWriter: play has more than four steps");
+    _buf.push_back(uint8_t(TAG_PLAY | p.n));
+    for (unsigned i=0; i<p.n; ++i) {
+        const Play::Step &s = p.steps[i];
+        if (s.from>24 || s.pip<1 || s.pip>6) throw std::invalid_argument("RecordWriter: step out of range");
+        _buf.push_back(uint8_t(s.from<<3 | s.pip));
+    }
+    endEvent();
+}
+
+void RecordWriter::cubeOffer() { _buf.push_back(TAG_DOUBLE); endEvent(); }
+void RecordWriter::cubeTake()  { _buf.push_back(TAG_TAKE);   endEvent(); }
+void RecordWriter::cubeDrop()  { _buf.push_back(TAG_DROP);   endEvent(); }
+
+void RecordWriter::gameEnd(const GameEnd &e) {
+    if (e.winner==NONE) throw std::invalid_argument("RecordWriter: game end without winner");
+    _buf.push_back(uint8_t(TAG_GAMEEND | (e.winner==BLACK ? 1 : 0)));
+    putVarint(_buf, e.points);
+    _buf.push_back(e.resigned ? 1 : 0);
+    flush(); // game boundaries always close a block
+}
+
+void RecordWriter::write(const RecordEvent &ev) {
+    switch (ev.type) {
+        case RecordEvent::Type::GameStart:   gameStart(ev.header); break;
+        case RecordEvent::Type::OpeningRoll: openingRoll(ev.d1, ev.d2); break;
+        case RecordEvent::Type::Roll:        roll(ev.d1, ev.d2); break;
+        case RecordEvent::Type::Play:        play(ev.play); break;
+        case RecordEvent::Type::Double:      cubeOffer(); break;
+        case RecordEvent::Type::Take:        cubeTake(); break;
+        case RecordEvent::Type::Drop:        cubeDrop(); break;
+        case RecordEvent::Type::GameEnd:     gameEnd(ev.end); break;
+    }
+}
+
+void RecordWriter::flush() {
+    if (_buf.size() > RECORD_MAX_BLOCK) {
+        _buf.clear();
+        throw RecordError("RecordWriter: event larger than the maximum block");
+    }
+    if (!_buf.empty()) {
+        uint8_t hdr[10]; size_t hn=0;
+        uint64_t n=_buf.size();
+        while (n>=0x80) { hdr[hn++]=uint8_t(n|0x80); n>>=7; }
+        hdr[hn++]=uint8_t(n);
+        uint32_t c = crc32(_buf.data(), _buf.size());
+        uint8_t tail[4] = { uint8_t(c), uint8_t(c>>8), uint8_t(c>>16), uint8_t(c>>24) };
+        _out.write(reinterpret_cast<const char*>(hdr), std::streamsize(hn));
+        _out.write(reinterpret_cast<const char*>(_buf.data()), std::streamsize(_buf.size()));
+        _out.write(reinterpret_cast<const char*>(tail), 4);
+        _buf.clear();
+    }
+    _out.flush();
+    if (!_out) throw RecordError("RecordWriter: write failed");
+}
+
+// ===== Reader =================================================================
+
+void RecordReader::checkFileHeader(const uint8_t *h) {
+    if (std::memcmp(h, FILE_MAGIC, 4)!=0) throw RecordError("record: bad magic");
+    if (h[4]!=FILE_VERSION) throw RecordError("record: unsupported version " + std::to_string(h[4]));
+}
+
+RecordReader::RecordReader(std::istream &in) : _in(&in) {
+    uint8_t h[FILE_HEADER_SIZE];
+    if (!_in->read(reinterpret_cast<char*>(h), sizeof h)) throw RecordError("record: missing file header");
+    checkFileHeader(h);
+}
+
+RecordReader::RecordReader(const void *data, size_t size)
+    : _img(static_cast<const uint8_t*>(data)), _imgEnd(_img+size)
+{
+    if (size<FILE_HEADER_SIZE) throw RecordError("record: missing file header");
+    checkFileHeader(_img);
+    _img += FILE_HEADER_SIZE;
+}
+
+bool RecordReader::loadBlock() {
+    uint64_t len=0;
+    const uint8_t *payload=nullptr;
+    uint32_t stored=0;
+
+    if (_in) {
+        int shift=0; int c;
+        for (;;) {
+            c = _in->get();
+            if (c==std::char_traits<char>::eof()) { _torn = shift>0; return false; }
+            len |= uint64_t(c&0x7F) << shift;
+            if (!(c&0x80)) break;
+            if ((shift+=7)>=64) throw RecordError("record: bad block length");
+        }
+        if (len > RECORD_MAX_BLOCK) throw RecordError("record: bad block length");
+        _block.resize(size_t(len)+4);
+        if (!_in->read(reinterpret_cast<char*>(_block.data()), std::streamsize(_block.size()))) {
+            _torn = true; return false;
+        }
+        payload = _block.data();
+    } else {
+        if (_img>=_imgEnd) return false;
+        const uint8_t *p=_img;
+        try { len = getVarint(p, _imgEnd); }
+        catch (const RecordError&) { _torn=true; return false; }
+        if (len > RECORD_MAX_BLOCK) throw RecordError("record: bad block length");
+        if (uint64_t(_imgEnd-p) < 4 || len > uint64_t(_imgEnd-p) - 4) { _torn=true; return false; }
+        payload = p;
+        _img = p + len + 4;
+    }
+
+    const uint8_t *t = payload + len;
+    stored = uint32_t(t[0]) | uint32_t(t[1])<<8 | uint32_t(t[2])<<16 | uint32_t(t[3])<<24;
+    if (crc32(payload, size_t(len))!=stored)
+        throw RecordError("record: checksum mismatch in block " + std::to_string(_blocks));
+    _p = payload; _end = payload+len;
+    ++_blocks;
+    return true;
+}
+
+bool RecordReader::next(RecordEvent &ev) {
+    while (_p>=_end) {
+        if (!loadBlock()) return false;
+    }
+    const uint8_t *p=_p, *end=_end;
+    uint8_t tag = *p++;
+    switch (tag & 0xF0) {
+        case TAG_GAMESTART: {
+            ev.type = RecordEvent::Type::GameStart;
+            GameHeader &h = ev.header;
+            h.gameId      = getVarint(p, end);
+            h.matchLength = unsigned(getVarint(p, end));
+            h.scoreWhite  = unsigned(getVarint(p, end));
+            h.scoreBlack  = unsigned(getVarint(p, end));
+            uint8_t flags = getByte(p, end);
+            h.crawford = flags & 1;
+            h.rules.openingDoublePolicy = (flags & 2) ? Rules::OpeningDoublePolicy::AUTODOUBLE
+                                                      : Rules::OpeningDoublePolicy::REROLL;
+            if (((flags >> 2) & 3) > uint8_t(Variant::Hypergammon)) throw RecordError("record: unknown variant");
+            h.rules.variant = Variant((flags >> 2) & 3);
+            h.rules.maxOpeningAutoDoubles = unsigned(getVarint(p, end));
+            getString(p, end, h.white);
+            getString(p, end, h.black);
+            break;
+        }
+        case TAG_OPENING:
+            ev.type = RecordEvent::Type::OpeningRoll;
+            unpackDice(getByte(p, end), ev.d1, ev.d2);
+            break;
+        case TAG_ROLL:
+            ev.type = RecordEvent::Type::Roll;
+            unpackDice(getByte(p, end), ev.d1, ev.d2);
+            break;
+        case TAG_PLAY: {
+            ev.type = RecordEvent::Type::Play;
+            unsigned n = tag & 0x0F;
+            if (n>4) throw RecordError("record: play with more than four steps");
+            ev.play.n = 0;
+            for (unsigned i=0; i<n; ++i) {
+                uint8_t s = getByte(p, end);
+                int from = s>>3, pip = s&7;
+                if (from>24 || pip<1 || pip>6) throw RecordError("record: step out of range");
+                ev.play.push(from, pip);
+            }
+            break;
+        }
+        case 0x50:
+            if      (tag==TAG_DOUBLE) ev.type = RecordEvent::Type::Double;
+            else if (tag==TAG_TAKE)   ev.type = RecordEvent::Type::Take;
+            else if (tag==TAG_DROP)   ev.type = RecordEvent::Type::Drop;
+            else throw RecordError("record: unknown cube tag");
+            break;
+        case TAG_GAMEEND: {
+            ev.type = RecordEvent::Type::GameEnd;
+            if ((tag&0x0F)>1) throw RecordError("record: bad winner");
+            ev.end.winner = (tag&1) ? BLACK : WHITE;
+            ev.end.points = unsigned(getVarint(p, end));
+            ev.end.resigned = getByte(p, end) & 1;
+            break;
+        }
+        default:
+            throw RecordError("record: unknown event tag");
+    }
+    _p = p;
+    return true;
+}
+
+bool GameReader::next(std::vector<RecordEvent> &events) {
+    events.clear();
+    RecordEvent ev;
+    if (_haveAhead) { ev = std::move(_ahead); _haveAhead = false; }
+    else {
+        do { if (!_in.next(ev)) return false; } while (ev.type!=RecordEvent::Type::GameStart);
+    }
+    events.push_back(std::move(ev));
+    while (_in.next(ev)) {
+        if (ev.type==RecordEvent::Type::GameStart) { _ahead = std::move(ev); _haveAhead = true; break; }
+        bool end = ev.type==RecordEvent::Type::GameEnd;
+        events.push_back(std::move(ev));
+        if (end) break;
+    }
+    return true;
+}
+
+// ===== Replay =================================================================
+
+bool replayEvent(Board &b, const RecordEvent &ev, std::string *err) {
+    auto fail = [&](const std::string &why){ if (err) *err = why; return false; };
+    try {
+        switch (ev.type) {
+            case RecordEvent::Type::GameStart:
+                b.startGame(ev.header.rules);
+                return true;
+            case RecordEvent::Type::OpeningRoll:
+                return b.setOpeningDice(ev.d1, ev.d2) || fail("replay: opening roll is a double");
+            case RecordEvent::Type::Roll:
+                b.setDice(ev.d1, ev.d2);
+                return true;
+            case RecordEvent::Type::Play:
+                for (unsigned i=0; i<ev.play.n; ++i) {
+                    if (!b.applyStep(ev.play.steps[i].from, ev.play.steps[i].pip)) return fail(b.lastError());
+                }
+                if (!b.commitTurn()) return fail(b.lastError());
+                return true;
+            case RecordEvent::Type::Double:
+                return b.offerCube() || fail(b.lastError());
+            case RecordEvent::Type::Take:
+                return b.takeCube() || fail(b.lastError());
+            case RecordEvent::Type::Drop:
+                return b.dropCube() || fail(b.lastError());
+            case RecordEvent::Type::GameEnd:
+                return true;
+        }
+    } catch (const std::exception &ex) {
+        return fail(ex.what());
+    }
+    return fail("replay: unknown event");
+}
+
+bool finishedGame(const Board &b, GameEnd &e) {
+    Side winner = b.countOff(WHITE)==b.checkers() ? WHITE : b.countOff(BLACK)==b.checkers() ? BLACK : NONE;
+    if (winner==NONE) return false;
+    Side loser = winner==WHITE ? BLACK : WHITE;
+
+    unsigned mult = 1;
+    if (b.countOff(loser)==0) {
+        mult = 2;
+        // Backgammon: loser still on the bar or in the winner's home board.
+        bool back = b.countBar(loser)>0;
+        int lo = winner==WHITE ? 1 : 19;
+        for (int p=lo; p<lo+6 && !back; ++p) back = b.countAt(loser, p)>0;
+        if (back) mult = 3;
+    }
+    e.winner = winner;
+    e.points = b.cubeValue()*mult;
+    e.resigned = false;
+    return true;
+}
+
+} // namespace BG
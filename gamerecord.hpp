@@ -0,0 +1,221 @@
+/**
+ * @file gamerecord.hpp
+ * @brief Compact binary game/match records: streaming writer, block reader and Board replay.
+ *
+ * File layout:
+ * @code
+ *   "BGRC" u8 version u8[3] reserved          // file header
+ *   { varint len, payload[len], u32le crc32 }* // blocks
+ * @endcode
+ * A payload is a run of events, each a tag byte (high nibble = type, low
+ * nibble = small argument) followed by its operands:
+ *  - 0x10 GameStart   varint id, len, scoreW, scoreB; u8 flags; str white, black
+ *  - 0x20 OpeningRoll u8 (whiteDie<<3 | blackDie)
+ *  - 0x30 Roll        u8 (d1<<3 | d2)
+ *  - 0x4n Play        n bytes (from<<3 | pip), n = 0..4
+ *  - 0x50/51/52       Double / Take / Drop
+ *  - 0x6w GameEnd     w = winner (0 white, 1 black); varint points; u8 flags
+ *
+ * GameStart flags: bit 0 Crawford, bit 1 opening auto-doubles, bits 2-3
+ * the Variant (0 standard, so older records read unchanged).
+ *
+ * Strings are varint length + bytes; varints are unsigned LEB128. Each block
+ * is CRC-32 checked, so a torn tail (crash mid-append) is detected and stops
+ * the reader without poisoning earlier blocks. A block payload is at most
+ * RECORD_MAX_BLOCK bytes; a longer length is corruption, not a torn tail.
+ */
+
+#ifndef GAMERECORD_HPP
+#define GAMERECORD_HPP
+
+#include "board.hpp"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/// Largest block payload a writer emits and a reader accepts.
+constexpr size_t RECORD_MAX_BLOCK = size_t(16) << 20;
+
+/// Thrown by RecordReader on malformed or corrupt input.
+struct RecordError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Per-game header carried by the GameStart event.
+ */
+struct GameHeader {
+    uint64_t gameId=0;
+    unsigned matchLength=0;           ///< 0 = money game
+    unsigned scoreWhite=0, scoreBlack=0;
+    bool crawford=false;
+    Rules rules{};
+    std::string white, black;         ///< player names (may be empty)
+};
+
+/**
+ * @brief Final result carried by the GameEnd event.
+ */
+struct GameEnd {
+    Side winner=NONE;
+    unsigned points=0;                ///< cube value × (1 single, 2 gammon, 3 backgammon)
+    bool resigned=false;              ///< ended by a dropped cube or a resignation
+};
+
+/**
+ * @brief One decoded record event.
+ */
+struct RecordEvent {
+    enum class Type : uint8_t { GameStart, OpeningRoll, Roll, Play, Double, Take, Drop, GameEnd };
+    Type type=Type::GameStart;
+    GameHeader header;                ///< GameStart
+    int d1=0, d2=0;                   ///< OpeningRoll (white, black) / Roll
+    Play play;                        ///< Play
+    GameEnd end;                      ///< GameEnd
+};
+
+/**
+ * @class RecordWriter
+ * @brief Appends events to a stream, one CRC-checked block at a time.
+ *
+ * Events accumulate in memory and are emitted as a block when the block
+ * reaches @p blockSize bytes, at every gameEnd(), or on flush(). A live
+ * server calls flush() after each committed turn so a crash loses at most
+ * the turn in progress.
+ */
+class RecordWriter {
+public:
+    /**
+     * @param out        Destination (binary mode).
+     * @param fileHeader Write the file header first (false when appending to an existing file).
+     * @param blockSize  Soft payload size that triggers a block flush (capped at half RECORD_MAX_BLOCK).
+     */
+    explicit RecordWriter(std::ostream &out, bool fileHeader=true, size_t blockSize=16*1024);
+
+    /// Flushes any pending block (errors are swallowed; call flush() to observe them).
+    ~RecordWriter();
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    void gameStart(const GameHeader &h);
+    void openingRoll(int whiteDie, int blackDie);
+    void roll(int d1, int d2);
+    void play(const Play &p);
+    void cubeOffer();
+    void cubeTake();
+    void cubeDrop();
+    void gameEnd(const GameEnd &e);
+
+    /// Append a decoded event (e.g., when copying or filtering archives).
+    void write(const RecordEvent &ev);
+
+    /**
+     * @brief Emit the pending block (if any) and flush the stream.
+     * @throws RecordError if the stream is in a failed state, or the pending
+     *         block exceeds RECORD_MAX_BLOCK (a single oversized event).
+     */
+    void flush();
+
+private:
+    std::ostream &_out;
+    size_t _blockSize;
+    std::vector<uint8_t> _buf;
+
+    void endEvent();
+};
+
+/**
+ * @class RecordReader
+ * @brief Iterates the events of a record file, verifying every block.
+ *
+ * Reads either from a stream (block by block) or from a memory image such as
+ * an mmapped file (zero copy).
+ */
+class RecordReader {
+public:
+    /// Read from a stream; the file header is consumed and checked immediately.
+    explicit RecordReader(std::istream &in);
+
+    /// Read from a complete in-memory image (file header included). The memory must outlive the reader.
+    RecordReader(const void *data, size_t size);
+
+    /**
+     * @brief Decode the next event.
+     * @return false at a clean end of input.
+     * @throws RecordError on a bad header, checksum mismatch or malformed event.
+     *
+     * A truncated final block (torn append) also ends input with false;
+     * use truncatedTail() to detect it.
+     */
+    bool next(RecordEvent &ev);
+
+    /// True if input ended inside an incomplete block.
+    bool truncatedTail() const { return _torn; }
+
+    /// Zero-based index of the block the last event came from.
+    uint64_t blockIndex() const { return _blocks ? _blocks-1 : 0; }
+
+private:
+    std::istream *_in=nullptr;
+    const uint8_t *_img=nullptr, *_imgEnd=nullptr;
+    std::vector<uint8_t> _block;          ///< stream mode block storage
+    const uint8_t *_p=nullptr, *_end=nullptr;
+    uint64_t _blocks=0;
+    bool _torn=false;
+
+    bool loadBlock();
+    static void checkFileHeader(const uint8_t *h);
+};
+
+/**
+ * @class GameReader
+ * @brief Groups a RecordReader's events into whole games.
+ *
+ * A game runs from its GameStart to the matching GameEnd; an unfinished game
+ * (no GameEnd) is closed by the next GameStart or the end of input. Events
+ * before the first GameStart are skipped.
+ */
+class GameReader {
+public:
+    explicit GameReader(RecordReader &in) : _in(in) {}
+
+    /**
+     * @brief Read the next game into @p events (cleared first).
+     * @return false at end of input.
+     * @throws RecordError as RecordReader::next().
+     */
+    bool next(std::vector<RecordEvent> &events);
+
+private:
+    RecordReader &_in;
+    RecordEvent _ahead;
+    bool _haveAhead=false;
+};
+
+/**
+ * @brief Apply one event to @p b through the rules-enforcing Board API.
+ * @param b   Board being replayed (GameStart resets it).
+ * @param ev  Event to apply.
+ * @param err Receives a reason when the event is illegal in the current position.
+ * @return true if applied.
+ */
+bool replayEvent(Board &b, const RecordEvent &ev, std::string *err=nullptr);
+
+/**
+ * @brief Detect a game finished by bearing off and score it.
+ * @return true (and fill @p e) if one side has borne off all checkers.
+ */
+bool finishedGame(const Board &b, GameEnd &e);
+
+/// CRC-32 (IEEE 802.3), as used for record blocks.
+uint32_t crc32(const void *data, size_t n, uint32_t crc=0);
+
+} // namespace BG
+
+#endif // GAMERECORD_HPP
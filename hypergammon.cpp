@@ -0,0 +1,242 @@
+/**
+ * @file hypergammon.cpp
+ * @brief Few-checker position numbering, shell-ordered value iteration and mapped lookup.
+ */
+
+#include "hypergammon.hpp"
+#include "dice.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace BG {
+
+namespace {
+
+constexpr char     HYPER_MAGIC[4] = {'B','G','H','Y'};
+constexpr uint32_t HYPER_VERSION  = 1;
+constexpr size_t   HYPER_HEADER   = 64;
+
+unsigned headerCheckers(const MappedFile &f, const std::string &path) {
+    const char *p = f.data();
+    if (f.size()<HYPER_HEADER || std::memcmp(p, HYPER_MAGIC, 4)!=0)
+        throw std::runtime_error(path + ": not a hypergammon table");
+    uint32_t ver, n;
+    std::memcpy(&ver, p+4, 4);
+    std::memcpy(&n, p+8, 4);
+    if (ver!=HYPER_VERSION) throw std::runtime_error(path + ": unsupported table version " + std::to_string(ver));
+    if (n<1 || n>HyperIndex::kMaxCheckers) throw std::runtime_error(path + ": bad checker count");
+    return n;
+}
+
+} // namespace
+
+// ===== HyperIndex ============================================================
+
+HyperIndex::HyperIndex(unsigned checkers) : _n(checkers) {
+    if (checkers<1 || checkers>kMaxCheckers) throw std::invalid_argument("HyperIndex: checkers out of range");
+
+    // _ways[k][m] = C(25-k+m, m), built by the recurrence over the count on index k.
+    _ways.assign(26*(_n+1), 0);
+    for (unsigned m=0; m<=_n; ++m) _ways[25*(_n+1)+m] = 1;
+    for (int k=24; k>=0; --k)
+        for (unsigned m=0; m<=_n; ++m)
+            for (unsigned c=0; c<=m; ++c) _ways[k*(_n+1)+m] += _ways[(k+1)*(_n+1)+m-c];
+
+    std::array<uint8_t, 25> c{};
+    auto gen = [&](auto &&self, int k, unsigned left) -> void {
+        if (k==25) { _layouts.push_back(c); return; }
+        for (unsigned v=0; v<=left; ++v) { c[k] = uint8_t(v); self(self, k+1, left-v); }
+        c[k] = 0;
+    };
+    gen(gen, 0, _n);
+
+    auto pips = [](const std::array<uint8_t, 25> &l){
+        unsigned s=0;
+        for (int i=0; i<25; ++i) s += unsigned(l[i])*unsigned(i+1);
+        return s;
+    };
+    std::stable_sort(_layouts.begin(), _layouts.end(), [&](const auto &a, const auto &b){ return pips(a) < pips(b); });
+    _number.assign(_layouts.size(), 0);
+    for (uint32_t i=0; i<_layouts.size(); ++i) _number[lexRank(_layouts[i].data())] = i;
+}
+
+uint32_t HyperIndex::lexRank(const uint8_t *c) const {
+    uint32_t r=0;
+    unsigned m=_n;
+    for (int k=0; k<25; ++k) {
+        for (unsigned j=0; j<c[k]; ++j) r += _ways[(k+1)*(_n+1)+m-j];
+        m -= c[k];
+    }
+    return r;
+}
+
+bool HyperIndex::covers(const Position &p) const {
+    for (int s=0; s<2; ++s) {
+        unsigned in = p.inPlay(s);
+        if (in==0 || in+p.off[s]!=_n) return false;
+    }
+    return true;
+}
+
+uint32_t HyperIndex::side(const Position &p, int s) const {
+    return _number[lexRank(p.checkers[s].data())];
+}
+
+bool HyperIndex::position(uint64_t i, Position &out) const {
+    const auto &a = _layouts[i / sides()], &b = _layouts[i % sides()];
+    out = Position{};
+    unsigned na=0, nb=0;
+    for (int j=0; j<25; ++j) {
+        if (j<24 && a[j] && b[23-j]) return false;
+        out.checkers[0][j] = a[j]; out.checkers[1][j] = b[j];
+        na += a[j]; nb += b[j];
+    }
+    if (na==0 || nb==0) return false;
+    out.off[0] = uint8_t(_n-na); out.off[1] = uint8_t(_n-nb);
+    return true;
+}
+
+// ===== Solver ================================================================
+
+HyperSolveStats solveHypergammon(const std::string &outPath, const HyperSolveOptions &opt,
+                                 const std::function<void(const HyperSolveStats&)> &progress) {
+    const HyperIndex idx(opt.checkers);
+    const uint32_t N = idx.sides();
+    std::vector<float> eq(idx.size(), 0.f);
+    ThreadPool pool(opt.threads);
+    auto t0 = std::chrono::steady_clock::now();
+
+    // One Bellman backup of position i into @p out; returns |change|, or -1 for
+    // an unnumbered position. Races are exact after the first sweep, so later
+    // sweeps skip them (and leave @p out at the current value).
+    bool contactOnly = false;
+    auto update = [&](uint64_t i, float &out) -> float {
+        Position p;
+        if (!idx.position(i, p)) return -1.f;
+        out = eq[i];
+        if (contactOnly && !p.contact()) return 0.f;
+        thread_local std::vector<Candidate> cands;
+        double sum = 0.0;
+        for (const Roll &r : kRolls) {
+            generatePlays(p, r.hi, r.lo, cands);
+            double best = -1e9;
+            for (const Candidate &c : cands) {
+                double v = c.after.finished(0)
+                         ? double(c.after.winMultiplier(0))
+                         : -double(eq[idx.index(c.after.swapped())]);
+                best = std::max(best, v);
+            }
+            sum += best * r.weight;
+        }
+        out = float(sum / 36.0);
+        return std::fabs(out - eq[i]);
+    };
+
+    HyperSolveStats st;
+    std::vector<float> delta(N), next(N);
+    for (st.sweeps=1; st.sweeps<=opt.maxSweeps; ++st.sweeps) {
+        double maxDelta = 0.0;
+        uint64_t live = 0;
+        auto collect = [&](uint32_t n){
+            for (uint32_t x=0; x<n; ++x) {
+                if (delta[x]<0.f) continue;
+                ++live;
+                maxDelta = std::max(maxDelta, double(delta[x]));
+            }
+        };
+        // Shell m holds the positions whose larger layout number is m. The
+        // mover's number falls, so (m, x) needs only earlier shells or (m, x'),
+        // and (x, m) needs (m, x'): solve the first row, the corner, then the
+        // column. Races in a row or column never read each other, but a hit
+        // can reach a cell of the row being solved, so each parallel pass
+        // reads the table as it was before the pass (new values go to @c next
+        // and are stored after it). That keeps the result the same for any
+        // thread count; the contact cycles converge over sweeps either way.
+        auto store = [&](uint32_t n, auto cell){
+            for (uint32_t x=0; x<n; ++x)
+                if (delta[x]>=0.f) eq[cell(x)] = next[x];
+        };
+        for (uint32_t m=0; m<N; ++m) {
+            const uint64_t row = uint64_t(m)*N;
+            pool.parallelFor(m, [&](size_t x){ delta[x] = update(row + x, next[x]); }, 64);
+            store(m, [&](uint64_t x){ return row + x; });
+            collect(m);
+            delta[0] = update(row + m, next[0]);
+            store(1, [&](uint64_t){ return row + m; });
+            collect(1);
+            pool.parallelFor(m, [&](size_t x){ delta[x] = update(uint64_t(x)*N + m, next[x]); }, 64);
+            store(m, [&](uint64_t x){ return x*N + m; });
+            collect(m);
+        }
+        st.positions = live;
+        st.maxDelta = maxDelta;
+        st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (progress) progress(st);
+        if (maxDelta<opt.tolerance) break;
+        contactOnly = true;
+    }
+    st.sweeps = std::min(st.sweeps, opt.maxSweeps);
+
+    unsigned char hdr[HYPER_HEADER] = {};
+    uint32_t checkers = opt.checkers, sweeps = st.sweeps;
+    float md = float(st.maxDelta);
+    std::memcpy(hdr, HYPER_MAGIC, 4);
+    std::memcpy(hdr+4, &HYPER_VERSION, 4);
+    std::memcpy(hdr+8, &checkers, 4);
+    std::memcpy(hdr+12, &N, 4);
+    std::memcpy(hdr+16, &sweeps, 4);
+    std::memcpy(hdr+20, &md, 4);
+
+    std::string partial = outPath + ".partial";
+    {
+        std::ofstream f(partial, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(hdr), HYPER_HEADER);
+        f.write(reinterpret_cast<const char*>(eq.data()), std::streamsize(eq.size()*sizeof(float)));
+        f.flush();
+        if (!f) throw std::runtime_error(partial + ": write failed");
+    }
+    std::filesystem::rename(partial, outPath);
+    return st;
+}
+
+// ===== HyperTable ============================================================
+
+HyperTable::HyperTable(const std::string &path)
+    : _file(path), _index(headerCheckers(_file, path)) {
+    const char *p = _file.data();
+    uint32_t sides;
+    std::memcpy(&sides, p+12, 4);
+    std::memcpy(&_sweeps, p+16, 4);
+    std::memcpy(&_maxDelta, p+20, 4);
+    if (sides!=_index.sides() || _file.size()!=HYPER_HEADER + _index.size()*sizeof(float))
+        throw std::runtime_error(path + ": truncated or corrupt table");
+    _equity = reinterpret_cast<const float*>(p + HYPER_HEADER);
+}
+
+double HyperTable::playEquity(const Position &after) const {
+    if (after.finished(0)) return double(after.winMultiplier(0));
+    return -equity(after.swapped());
+}
+
+bool HyperTable::rankPlays(const Position &p, int d1, int d2, std::vector<ScoredPlay> &out) const {
+    out.clear();
+    if (!covers(p)) return false;
+    std::vector<Candidate> cands;
+    generatePlays(p, d1, d2, cands);
+    out.reserve(cands.size());
+    for (Candidate &c : cands) {
+        double e = playEquity(c.after);
+        out.push_back({std::move(c), e, 0});
+    }
+    std::stable_sort(out.begin(), out.end(), [](const ScoredPlay &a, const ScoredPlay &b){ return a.equity > b.equity; });
+    return true;
+}
+
+} // namespace BG
@@ -0,0 +1,152 @@
+/**
+ * @file hypergammon.hpp
+ * @brief Exact cubeless equities for few-checker variants, solved by retrograde value iteration.
+ */
+
+#ifndef HYPERGAMMON_HPP
+#define HYPERGAMMON_HPP
+
+#include "mappedfile.hpp"
+#include "search.hpp"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @class HyperIndex
+ * @brief Dense numbering of every position with @c checkers checkers a side.
+ *
+ * One side's layout (0..checkers on each of its 25 indices, the rest
+ * borne off) is numbered in increasing pip count, so a side's number
+ * only falls when it moves. A position is numbered on-roll layout times
+ * sides() plus opponent layout; numbers of impossible positions (both
+ * sides on one point) exist but are never reached.
+ */
+class HyperIndex {
+public:
+    static constexpr unsigned kMaxCheckers = 4;
+
+    /// @throws std::invalid_argument unless 1 <= @p checkers <= kMaxCheckers.
+    explicit HyperIndex(unsigned checkers);
+
+    unsigned checkers() const { return _n; }
+
+    /// Layouts per side, C(25+checkers, checkers).
+    uint32_t sides() const { return uint32_t(_layouts.size()); }
+
+    /// Numbered positions, sides() squared.
+    uint64_t size() const { return uint64_t(sides())*sides(); }
+
+    /// True if @p p has exactly checkers() checkers a side and neither side has finished.
+    bool covers(const Position &p) const;
+
+    /// Number of side @p s's layout in @p p (p must be covered).
+    uint32_t side(const Position &p, int s) const;
+
+    /// Number of @p p (p must be covered).
+    uint64_t index(const Position &p) const { return uint64_t(side(p, 0))*sides() + side(p, 1); }
+
+    /// Position numbered @p i; false when it is impossible or already finished.
+    bool position(uint64_t i, Position &out) const;
+
+private:
+    unsigned _n;
+    std::vector<std::array<uint8_t, 25>> _layouts;   ///< by number
+    std::vector<uint32_t> _number;                   ///< lexicographic rank -> number
+    std::vector<uint32_t> _ways;                     ///< [k*(n+1)+m]: layouts of <= m checkers on indices k..24
+
+    uint32_t lexRank(const uint8_t *c) const;
+};
+
+/**
+ * @struct HyperSolveOptions
+ * @brief Retrograde solver settings.
+ */
+struct HyperSolveOptions {
+    unsigned checkers = 3;      ///< per side; 3 is hypergammon
+    unsigned threads = 0;       ///< 0 = hardware concurrency
+    double tolerance = 1e-6;    ///< stop once no equity moves by more than this in a sweep
+    unsigned maxSweeps = 500;
+};
+
+/**
+ * @struct HyperSolveStats
+ * @brief Progress of solveHypergammon(), reported after every sweep.
+ */
+struct HyperSolveStats {
+    uint64_t positions=0;       ///< live positions solved
+    unsigned sweeps=0;
+    double maxDelta=0.0;        ///< largest change in the last sweep
+    double seconds=0.0;
+};
+
+/**
+ * @brief Solve every position with @c checkers checkers a side and write the table.
+ *
+ * Each position's equity is the average over the 21 rolls of its best
+ * play, a play that bears off the last checker scoring its win multiplier
+ * (gammons and backgammons count). Sweeps run outward in shells of the
+ * larger layout number: the moving side's number always falls, so races
+ * are exact after the first sweep, and later sweeps (Gauss-Seidel, in
+ * place) revisit only contact positions, where hits make cycles. Each row
+ * and column of a shell is solved in parallel against the values from
+ * before that pass, so the table does not depend on the thread count. The table is
+ * written to OUT.partial and renamed into place.
+ *
+ * @param progress Called after each sweep (may be empty).
+ * @throws std::runtime_error on I/O errors, std::invalid_argument on bad options.
+ */
+HyperSolveStats solveHypergammon(const std::string &outPath, const HyperSolveOptions &opt = {},
+                                 const std::function<void(const HyperSolveStats&)> &progress = {});
+
+/**
+ * @class HyperTable
+ * @brief Read-only, memory-mapped table written by solveHypergammon().
+ *
+ * File layout (little-endian):
+ * @code
+ *   "BGHY" u32 version u32 checkers u32 sides u32 sweeps
+ *   f32 maxDelta u8[40] reserved                // 64-byte header
+ *   f32 equity[sides*sides]                     // by HyperIndex number
+ * @endcode
+ */
+class HyperTable {
+public:
+    /// @throws std::runtime_error if @p path is not a readable table.
+    explicit HyperTable(const std::string &path);
+
+    unsigned checkers() const { return _index.checkers(); }
+    unsigned sweeps() const { return _sweeps; }
+    float maxDelta() const { return _maxDelta; }
+    const HyperIndex &index() const { return _index; }
+
+    /// True if the table holds @p p.
+    bool covers(const Position &p) const { return _index.covers(p); }
+
+    /// Cubeless equity for the side on roll of @p p before it rolls (p must be covered).
+    double equity(const Position &p) const { return _equity[_index.index(p)]; }
+
+    /// Equity for the mover of having played to @p after.
+    double playEquity(const Position &after) const;
+
+    /**
+     * @brief Every legal play of (@p d1, @p d2), best first, scored exactly.
+     * @return false (and @p out empty) when the table does not cover @p p.
+     */
+    bool rankPlays(const Position &p, int d1, int d2, std::vector<ScoredPlay> &out) const;
+
+private:
+    MappedFile _file;
+    HyperIndex _index;
+    const float *_equity=nullptr;
+    unsigned _sweeps=0;
+    float _maxDelta=0.f;
+};
+
+} // namespace BG
+
+#endif // HYPERGAMMON_HPP
@@ -0,0 +1,41 @@
+/**
+ * @file mappedfile.cpp
+ * @brief POSIX implementation of MappedFile.
+ */
+
+#include "mappedfile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BG {
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd<0) throw std::runtime_error(path + ": " + std::strerror(errno));
+    struct stat st{};
+    if (::fstat(fd, &st)!=0) {
+        int e=errno; ::close(fd);
+        throw std::runtime_error(path + ": " + std::strerror(e));
+    }
+    _size = static_cast<size_t>(st.st_size);
+    if (_size>0) {
+        void *p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p==MAP_FAILED) {
+            int e=errno; ::close(fd);
+            throw std::runtime_error(path + ": mmap: " + std::strerror(e));
+        }
+        ::madvise(p, _size, MADV_SEQUENTIAL);
+        _addr = p;
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_addr) ::munmap(_addr, _size);
+}
+
+} // namespace BG
@@ -0,0 +1,46 @@
+/**
+ * @file mappedfile.hpp
+ * @brief Read-only memory-mapped file (POSIX mmap) for bulk tools.
+ */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace BG {
+
+/**
+ * @class MappedFile
+ * @brief Maps a whole file read-only for the lifetime of the object.
+ *
+ * Pages are faulted in on demand, so scanning a large archive costs no
+ * copies and no read() buffers. An empty file maps to an empty view.
+ */
+class MappedFile {
+public:
+    /**
+     * @param path File to map.
+     * @throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char *data() const { return static_cast<const char*>(_addr); }
+    size_t size() const { return _size; }
+    std::string_view view() const { return {data(), _size}; }
+
+private:
+    void *_addr=nullptr;
+    size_t _size=0;
+};
+
+} // namespace BG
+
+#endif // MAPPEDFILE_HPP
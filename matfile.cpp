@@ -0,0 +1,387 @@
+/**
+ * @file matfile.cpp
+ * @brief Text match transcript parsing and move-by-move validation on Board.
+ */
+
+#include "matfile.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace BG {
+
+namespace {
+
+using sv = std::string_view;
+
+struct Token { sv text; size_t col; };
+
+/// One column entry of a move line.
+struct Action {
+    enum Kind { Roll, Double, Take, Drop, Win } kind=Roll;
+    size_t col=0;                     ///< offset of the first token in the line
+    int d1=0, d2=0;
+    std::vector<sv> moves;            ///< Roll: move tokens such as "13/7*/4" or "8/3(2)"
+    unsigned value=0;                 ///< Double: new cube value; Win: points
+};
+
+/// One checker hop in the mover's numbering (bar 25, off 0).
+struct Seg { int from, to; };
+
+sv trim(sv s) {
+    while (!s.empty() && std::isspace((unsigned char)s.front())) s.remove_prefix(1);
+    while (!s.empty() && std::isspace((unsigned char)s.back())) s.remove_suffix(1);
+    return s;
+}
+
+bool parseUnsigned(sv s, unsigned &v) {
+    if (s.empty() || s.size()>9) return false;
+    v=0;
+    for (char c : s) {
+        if (c<'0' || c>'9') return false;
+        v = v*10 + unsigned(c-'0');
+    }
+    return true;
+}
+
+std::vector<Token> tokenize(sv line, size_t from) {
+    std::vector<Token> out;
+    size_t i=from;
+    while (i<line.size()) {
+        while (i<line.size() && std::isspace((unsigned char)line[i])) ++i;
+        size_t j=i;
+        while (j<line.size() && !std::isspace((unsigned char)line[j])) ++j;
+        if (j>i) out.push_back({line.substr(i, j-i), i});
+        i=j;
+    }
+    return out;
+}
+
+bool isDice(sv t, int &d1, int &d2) {
+    if (t.size()!=3 || t[2]!=':') return false;
+    if (t[0]<'1' || t[0]>'6' || t[1]<'1' || t[1]>'6') return false;
+    d1=t[0]-'0'; d2=t[1]-'0';
+    return true;
+}
+
+/// Group tokens into column actions; false (with @p why) on anything unrecognized.
+bool parseActions(const std::vector<Token> &toks, std::vector<Action> &out, std::string &why) {
+    for (size_t i=0; i<toks.size(); ++i) {
+        sv t = toks[i].text;
+        Action a; a.col = toks[i].col;
+        if (isDice(t, a.d1, a.d2)) {
+            a.kind = Action::Roll;
+            while (i+1<toks.size() && toks[i+1].text.find('/')!=sv::npos) a.moves.push_back(toks[++i].text);
+        } else if (t=="Doubles") {
+            a.kind = Action::Double;
+            if (i+2<toks.size() && toks[i+1].text=="=>" && parseUnsigned(toks[i+2].text, a.value)) i+=2;
+        } else if (t=="Takes" || t=="Accepts") {
+            a.kind = Action::Take;
+        } else if (t=="Drops" || t=="Passes" || t=="Refuses") {
+            a.kind = Action::Drop;
+        } else if (t=="Wins") {
+            a.kind = Action::Win;
+            if (i+1>=toks.size() || !parseUnsigned(toks[i+1].text, a.value)) { why="bad Wins line"; return false; }
+            ++i;
+            if (i+1<toks.size() && (toks[i+1].text=="point" || toks[i+1].text=="points")) ++i;
+            if (i+2<toks.size() && toks[i+1].text=="and" && toks[i+2].text=="the") i=toks.size();  // "... and the match"
+        } else {
+            why = "unrecognized token '" + std::string(t) + "'";
+            return false;
+        }
+        out.push_back(std::move(a));
+    }
+    return true;
+}
+
+int parsePoint(sv s) {
+    if (s=="bar" || s=="Bar") return 25;
+    if (s=="off" || s=="Off") return 0;
+    unsigned v;
+    if (!parseUnsigned(s, v) || v>25) return -1;
+    return int(v);
+}
+
+/// Expand "13/7*/4" and "8/3(2)" into hops; false if malformed.
+bool parseMove(sv tok, std::vector<Seg> &segs) {
+    unsigned times = 1;
+    if (size_t lp = tok.find('('); lp!=sv::npos) {
+        if (tok.back()!=')' || !parseUnsigned(tok.substr(lp+1, tok.size()-lp-2), times) || times<1 || times>4) return false;
+        tok = tok.substr(0, lp);
+    }
+    std::vector<int> pts;
+    while (!tok.empty()) {
+        size_t sl = tok.find('/');
+        sv p = tok.substr(0, sl);
+        while (!p.empty() && p.back()=='*') p.remove_suffix(1);
+        int v = parsePoint(p);
+        if (v<0) return false;
+        pts.push_back(v);
+        if (sl==sv::npos) break;
+        tok.remove_prefix(sl+1);
+    }
+    if (pts.size()<2) return false;
+    for (unsigned k=0; k<times; ++k)
+        for (size_t i=0; i+1<pts.size(); ++i) {
+            if (pts[i+1]>=pts[i]) return false;
+            segs.push_back({pts[i], pts[i+1]});
+        }
+    return true;
+}
+
+/// Board point for a mover-numbered point (the bar maps to 0).
+inline int toBoard(Side s, int q) {
+    if (q==25) return 0;
+    return s==WHITE ? q : 25-q;
+}
+
+/**
+ * Depth-first assignment of the remaining dice to the hops, in order.
+ * @p pos is the checker's current mover-numbered point within segs[i], or -1
+ * at the start of a hop. Success leaves the turn committed on @p b.
+ */
+bool playSegs(Board &b, Side s, const std::vector<Seg> &segs, size_t i, int pos, Play &p) {
+    if (i==segs.size()) return b.commitTurn();
+    const Seg &g = segs[i];
+    if (pos<0) pos = g.from;
+    if (pos==g.to) return playSegs(b, s, segs, i+1, -1, p);
+
+    std::vector<int> dice = b.diceRemaining();
+    std::sort(dice.begin(), dice.end());
+    dice.erase(std::unique(dice.begin(), dice.end()), dice.end());
+    for (int pip : dice) {
+        int next = pos - pip;
+        if (next<g.to && g.to>0) continue;
+        if (next<0) next = 0;
+        int from = toBoard(s, pos);
+        if (!b.applyStep(from, pip)) continue;
+        p.push(from, pip);
+        if (playSegs(b, s, segs, i, next, p)) return true;
+        b.undoStep();
+        --p.n;
+    }
+    return false;
+}
+
+/**
+ * Parser state for one transcript; games are validated as they are read.
+ */
+class MatParser {
+public:
+    MatParser(const std::string &source, MatImport &out) : _source(source), _out(out) {}
+
+    void line(sv raw, size_t lineNo);
+    void finish() { closeGame(); }
+
+private:
+    const std::string &_source;
+    MatImport &_out;
+
+    unsigned _matchLength=0;
+    bool _crawfordPlayed=false;
+
+    enum class St { Outside, WantScores, Playing, Done, Failed } _st=St::Outside;
+    bool _crawfordMark=false;
+    size_t _lineNo=0;
+    Board _b;
+    MatGame _game;
+
+    void fail(const std::string &why) {
+        _out.errors.push_back(_source + ":" + std::to_string(_lineNo) + ": " + why);
+        _st = St::Failed;
+    }
+    void closeGame() {
+        if (_st==St::Done) _out.games.push_back(std::move(_game));
+        else if (_st==St::Playing) fail("game has no result (no \"Wins\" line)");
+        _game = MatGame{};
+        _st = St::Outside;
+    }
+    void push(RecordEvent::Type t, int d1=0, int d2=0) {
+        RecordEvent ev; ev.type=t; ev.d1=d1; ev.d2=d2;
+        _game.events.push_back(std::move(ev));
+    }
+
+    bool scores(sv s);
+    bool apply(const Action &a, Side side);
+    bool roll(const Action &a, Side side);
+};
+
+void MatParser::line(sv raw, size_t lineNo) {
+    _lineNo = lineNo;
+    if (!raw.empty() && raw.back()=='\r') raw.remove_suffix(1);
+    sv s = trim(raw);
+    if (s.empty() || s.front()==';') return;
+
+    if (s.size()>5 && s.substr(0,5)=="Game " ) {
+        unsigned n;
+        sv rest = trim(s.substr(5));
+        sv num = rest.substr(0, rest.find_first_not_of("0123456789"));
+        if (parseUnsigned(num, n)) {
+            closeGame();
+            _crawfordMark = rest.find("Crawford")!=sv::npos;
+            _st = St::WantScores;
+            return;
+        }
+    }
+    if (_st==St::Outside) {
+        size_t pm = s.find(" point match");
+        unsigned n;
+        if (pm!=sv::npos && parseUnsigned(trim(s.substr(0, pm)), n)) _matchLength = n;
+        return;
+    }
+    if (_st==St::Failed || _st==St::Done) return;
+    if (_st==St::WantScores) {
+        if (!scores(s)) fail("expected player/score line");
+        return;
+    }
+
+    // Move line "  N) left   right", or a bare "Wins" line.
+    size_t lead = raw.find_first_not_of(" \t");
+    size_t paren = raw.find(')');
+    size_t body = 0;
+    bool numbered = false;
+    if (paren!=sv::npos) {
+        unsigned n;
+        numbered = parseUnsigned(trim(raw.substr(lead, paren-lead)), n);
+        if (numbered) body = paren+1;
+    }
+    std::vector<Token> toks = tokenize(raw, body);
+    std::vector<Action> acts;
+    std::string why;
+    if (!parseActions(toks, acts, why)) { fail(why); return; }
+    if (acts.empty()) return;
+    if (acts.size()>2) { fail("more than two actions on one line"); return; }
+
+    // With one entry, its indentation tells which column it sits in.
+    size_t indent = acts[0].col - body;
+    bool leftEmpty = acts.size()==1 && (numbered ? indent>=10 : indent>=20);
+    for (size_t k=0; k<acts.size(); ++k) {
+        Side side = (k==0 && !leftEmpty) ? WHITE : BLACK;
+        if (!apply(acts[k], side)) return;
+    }
+}
+
+bool MatParser::scores(sv s) {
+    // "Name One : 3      Name Two : 1"
+    size_t c1 = s.find(" : ");
+    if (c1==sv::npos) return false;
+    GameHeader h;
+    h.matchLength = _matchLength;
+    h.white = std::string(trim(s.substr(0, c1)));
+    sv rest = trim(s.substr(c1+3));
+    size_t e1 = rest.find_first_not_of("0123456789");
+    if (e1==sv::npos || !parseUnsigned(rest.substr(0, e1), h.scoreWhite)) return false;
+    rest = trim(rest.substr(e1));
+    size_t c2 = rest.rfind(" : ");
+    if (c2==sv::npos || !parseUnsigned(trim(rest.substr(c2+3)), h.scoreBlack)) return false;
+    h.black = std::string(trim(rest.substr(0, c2)));
+
+    if (_matchLength>0 && (h.scoreWhite+1==_matchLength || h.scoreBlack+1==_matchLength)) {
+        h.crawford = _crawfordMark || !_crawfordPlayed;
+        _crawfordPlayed = true;
+    }
+
+    _b.startGame(h.rules);
+    RecordEvent ev; ev.type = RecordEvent::Type::GameStart; ev.header = std::move(h);
+    _game.events.push_back(std::move(ev));
+    _st = St::Playing;
+    return true;
+}
+
+bool MatParser::apply(const Action &a, Side side) {
+    if (_st!=St::Playing) { fail("action after the game ended"); return false; }
+    try {
+        switch (a.kind) {
+            case Action::Roll:
+                return roll(a, side);
+            case Action::Double:
+                if (_b.sideToMove()!=side || !_b.offerCube()) { fail("illegal double: " + _b.lastError()); return false; }
+                if (a.value && a.value!=_b.cubeValue()*2) { fail("cube value mismatch"); return false; }
+                push(RecordEvent::Type::Double);
+                return true;
+            case Action::Take:
+                if (_b.sideToMove()==side || !_b.takeCube()) { fail("illegal take: " + _b.lastError()); return false; }
+                push(RecordEvent::Type::Take);
+                return true;
+            case Action::Drop:
+                if (_b.sideToMove()==side || !_b.dropCube()) { fail("illegal drop: " + _b.lastError()); return false; }
+                push(RecordEvent::Type::Drop);
+                return true;
+            case Action::Win: {
+                RecordEvent ev; ev.type = RecordEvent::Type::GameEnd;
+                if (finishedGame(_b, ev.end)) {
+                    if (ev.end.winner!=side) { fail("winner does not match the final position"); return false; }
+                } else if (_b.gameOver()) {
+                    if (_b.result().winner!=side) { fail("winner does not match the dropped cube"); return false; }
+                    ev.end.winner = side; ev.end.resigned = true;
+                } else {
+                    ev.end.winner = side; ev.end.resigned = true;   // resignation mid-game
+                }
+                ev.end.points = a.value;
+                _game.events.push_back(std::move(ev));
+                _st = St::Done;
+                return true;
+            }
+        }
+    } catch (const std::exception &ex) {
+        fail(ex.what());
+    }
+    return false;
+}
+
+bool MatParser::roll(const Action &a, Side side) {
+    if (_b.phase()==Phase::OpeningRoll) {
+        if (a.d1==a.d2) { fail("doubles on the opening roll"); return false; }
+        int hi = std::max(a.d1, a.d2), lo = std::min(a.d1, a.d2);
+        int w = side==WHITE ? hi : lo, k = side==WHITE ? lo : hi;
+        _b.setOpeningDice(w, k);
+        push(RecordEvent::Type::OpeningRoll, w, k);
+    } else {
+        if (_b.phase()!=Phase::AwaitingRoll || _b.sideToMove()!=side) { fail("roll out of turn"); return false; }
+        _b.setDice(a.d1, a.d2);
+        push(RecordEvent::Type::Roll, a.d1, a.d2);
+    }
+
+    std::vector<Seg> segs;
+    for (sv m : a.moves)
+        if (!parseMove(m, segs)) { fail("bad move '" + std::string(m) + "'"); return false; }
+    if (segs.size()>4) { fail("too many checker moves"); return false; }
+
+    // Try the hops as written first; other orders cover transcripts that list
+    // e.g. a bear-off before the move that makes it legal.
+    std::vector<size_t> order(segs.size());
+    for (size_t i=0; i<order.size(); ++i) order[i]=i;
+    std::vector<Seg> tryOrder(segs.size());
+    do {
+        for (size_t i=0; i<order.size(); ++i) tryOrder[i] = segs[order[i]];
+        Play p;
+        if (playSegs(_b, side, tryOrder, 0, -1, p)) {
+            RecordEvent ev; ev.type = RecordEvent::Type::Play; ev.play = p;
+            _game.events.push_back(std::move(ev));
+            ++_game.turns;
+            return true;
+        }
+    } while (std::next_permutation(order.begin(), order.end()));
+
+    std::string mv;
+    for (sv m : a.moves) { if (!mv.empty()) mv += ' '; mv += m; }
+    fail("illegal play " + std::to_string(a.d1) + std::to_string(a.d2) + ": " + (mv.empty() ? "(none)" : mv));
+    return false;
+}
+
+} // namespace
+
+MatImport parseMatchText(std::string_view text, const std::string &source) {
+    MatImport out;
+    MatParser p(source, out);
+    size_t lineNo = 0;
+    while (!text.empty()) {
+        size_t nl = text.find('\n');
+        p.line(text.substr(0, nl), ++lineNo);
+        if (nl==sv::npos) break;
+        text.remove_prefix(nl+1);
+    }
+    p.finish();
+    return out;
+}
+
+} // namespace BG
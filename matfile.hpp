@@ -0,0 +1,63 @@
+/**
+ * @file matfile.hpp
+ * @brief Parser for the common text match transcript format (.mat/.txt exports).
+ *
+ * The format looks like:
+ * @code
+ *    7 point match
+ *
+ *    Game 1
+ *    Alice : 0                          Bob : 0
+ *     1) 64: 24/18 13/9                 52: 13/11 13/8
+ *     2) 55: 8/3(2) 6/1(2)              Doubles => 2
+ *     3)  Takes                         ...
+ *        Wins 1 point
+ * @endcode
+ * The left column is player 1 and the right column player 2; points are
+ * numbered from the mover's side (bar = 25, off = 0). Player 1 plays WHITE,
+ * whose numbering matches Board's, so player 2's point q is Board point 25-q.
+ */
+
+#ifndef MATFILE_HPP
+#define MATFILE_HPP
+
+#include "gamerecord.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @brief One imported game: record events from GameStart through GameEnd.
+ *
+ * The GameStart header's gameId is left 0 for the caller to assign.
+ */
+struct MatGame {
+    std::vector<RecordEvent> events;
+    size_t turns=0;                   ///< committed plays
+};
+
+/**
+ * @brief Result of parsing one transcript.
+ */
+struct MatImport {
+    std::vector<MatGame> games;       ///< games whose every action validated
+    std::vector<std::string> errors;  ///< "source:line: reason", one per rejected game
+};
+
+/**
+ * @brief Parse a transcript and replay every game through Board.
+ * @param text   Whole file contents (e.g., a MappedFile view).
+ * @param source Name used to prefix error messages.
+ *
+ * Each move is matched to the roll's dice by trying the steps on a Board
+ * with applyStep()/commitTurn(), so only games that are legal move for move
+ * and end in a result are returned. A bad or unfinished game is reported
+ * and skipped; parsing resumes at the next "Game" line.
+ */
+MatImport parseMatchText(std::string_view text, const std::string &source = "");
+
+} // namespace BG
+
+#endif // MATFILE_HPP
@@ -0,0 +1,115 @@
+/**
+ * @file movegen.cpp
+ * @brief Depth-first play generation with duplicate elimination.
+ */
+
+#include "movegen.hpp"
+#include "dice.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace BG {
+
+Play Move::toPlay(Side mover) const {
+    Play p;
+    for (unsigned k=0; k<n; ++k) {
+        int f = steps[k].from;
+        p.push(f==25 ? 0 : (mover==WHITE ? f : 25-f), steps[k].die);
+    }
+    return p;
+}
+
+std::string Move::text() const {
+    std::string s;
+    for (unsigned k=0; k<n; ++k) {
+        if (k) s += ' ';
+        s += steps[k].from==25 ? std::string("bar") : std::to_string(steps[k].from);
+        s += '/';
+        s += steps[k].to==0 ? std::string("off") : std::to_string(steps[k].to);
+    }
+    return s;
+}
+
+bool canStep(const Position &p, int i, int die) {
+    const auto &me = p.checkers[0];
+    if (!me[i]) return false;
+    if (me[Position::kBar] && i!=Position::kBar) return false;
+    int j = i - die;
+    if (j>=0) return p.checkers[1][23-j] < 2;
+
+    // Bearing off: everything home, and an oversized die only from the highest point.
+    for (int k=6; k<25; ++k) if (me[k]) return false;
+    if (j==-1) return true;
+    for (int k=i+1; k<6; ++k) if (me[k]) return false;
+    return true;
+}
+
+void doStep(Position &p, int i, int die) {
+    --p.checkers[0][i];
+    int j = i - die;
+    if (j<0) { ++p.off[0]; return; }
+    ++p.checkers[0][j];
+    uint8_t &o = p.checkers[1][23-j];
+    if (o==1) { o=0; ++p.checkers[1][Position::kBar]; }
+}
+
+namespace {
+
+struct Gen {
+    std::vector<Candidate> &out;
+    const uint8_t *dice;
+    int nd;
+    bool doubles;
+    int maxUsed=0;
+    Move mv{};
+
+    void rec(const Position &p, int used, int top) {
+        bool moved = false;
+        if (used<nd) {
+            int d = dice[used];
+            // With doubles every order of the same steps is equivalent, so only
+            // non-increasing source points are explored.
+            for (int i = doubles ? top : Position::kBar; i>=0; --i) {
+                if (!canStep(p, i, d)) continue;
+                moved = true;
+                Position q = p;
+                doStep(q, i, d);
+                mv.steps[mv.n++] = { int8_t(i+1), int8_t(i-d<0 ? 0 : i-d+1), int8_t(d) };
+                rec(q, used+1, i);
+                --mv.n;
+            }
+        }
+        if (moved || used<maxUsed) return;
+        if (used>maxUsed) { maxUsed = used; out.clear(); }
+        out.push_back({p, mv});
+    }
+};
+
+} // namespace
+
+void generatePlays(const Position &pos, int d1, int d2, std::vector<Candidate> &out) {
+    out.clear();
+    const Roll &r = rollOf(d1, d2);
+    if (r.doubles()) {
+        Gen g{out, r.pips, 4, true};
+        g.rec(pos, 0, Position::kBar);
+    } else {
+        Gen g{out, r.order[0], 2, false};
+        g.rec(pos, 0, Position::kBar);
+        g.dice = r.order[1];
+        g.rec(pos, 0, Position::kBar);
+        if (g.maxUsed==1) {
+            int hi = r.hi;
+            bool hiPlayable = std::any_of(out.begin(), out.end(), [&](const Candidate &c){ return c.move.steps[0].die==hi; });
+            if (hiPlayable)
+                out.erase(std::remove_if(out.begin(), out.end(), [&](const Candidate &c){ return c.move.steps[0].die!=hi; }), out.end());
+        }
+    }
+
+    auto less = [](const Candidate &x, const Candidate &y){ return std::memcmp(&x.after, &y.after, sizeof(Position))<0; };
+    auto same = [](const Candidate &x, const Candidate &y){ return std::memcmp(&x.after, &y.after, sizeof(Position))==0; };
+    std::sort(out.begin(), out.end(), less);
+    out.erase(std::unique(out.begin(), out.end(), same), out.end());
+}
+
+} // namespace BG
@@ -0,0 +1,61 @@
+/**
+ * @file movegen.hpp
+ * @brief Legal play generation on Position (all dice obligations applied).
+ */
+
+#ifndef MOVEGEN_HPP
+#define MOVEGEN_HPP
+
+#include "position.hpp"
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @struct Move
+ * @brief A full play as per-die steps in the mover's numbering (25 = bar, 0 = off).
+ */
+struct Move {
+    struct Step { int8_t from=0, to=0, die=0; };
+    Step steps[4];
+    uint8_t n=0;
+
+    /// Board::applyStep() form for @p mover.
+    Play toPlay(Side mover) const;
+
+    /// "24/18 13/9" style text (empty string for no move).
+    std::string text() const;
+};
+
+/**
+ * @struct Candidate
+ * @brief One legal play and the position it leaves (same side still on roll).
+ */
+struct Candidate {
+    Position after;
+    Move move;
+};
+
+/**
+ * @brief True if the side on roll can move a checker from index @p i with @p die.
+ * @param i Own index 0..23, or Position::kBar.
+ */
+bool canStep(const Position &p, int i, int die);
+
+/// Apply a step that canStep() accepted (hits go to the opponent's bar).
+void doStep(Position &p, int i, int die);
+
+/**
+ * @brief Every distinct legal play for the side on roll.
+ *
+ * Plays must use as many dice as possible and, when only one of two
+ * different dice can be used, the higher one if it is playable. Plays that
+ * reach the same position are reported once. If no checker can move,
+ * @p out holds a single empty play.
+ */
+void generatePlays(const Position &pos, int d1, int d2, std::vector<Candidate> &out);
+
+} // namespace BG
+
+#endif // MOVEGEN_HPP
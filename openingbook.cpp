@@ -0,0 +1,191 @@
+/**
+ * @file openingbook.cpp
+ * @brief Opening book build (level-by-level parallel ranking) and mapped lookup.
+ */
+
+#include "openingbook.hpp"
+#include "dice.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace BG {
+
+namespace {
+
+constexpr char     BOOK_MAGIC[4] = {'B','G','O','B'};
+constexpr uint32_t BOOK_VERSION  = 1;
+constexpr size_t   BOOK_HEADER   = 64;
+constexpr size_t   BOOK_NAME     = 24;
+
+inline uint8_t diceKey(int d1, int d2) { return uint8_t(std::max(d1,d2)*10 + std::min(d1,d2)); }
+
+inline uint64_t slotHash(const PositionId &id, uint8_t dice) {
+    return id.hash() ^ (uint64_t(dice) * 0x9E3779B97F4A7C15ull);
+}
+
+struct IdHash {
+    size_t operator()(const PositionId &id) const { return size_t(id.hash()); }
+};
+
+} // namespace
+
+uint32_t packBookMove(const Move &m) {
+    uint32_t v = 0;
+    for (unsigned k=0; k<m.n; ++k)
+        v |= uint32_t(uint8_t(m.steps[k].from<<3 | m.steps[k].die)) << (8*k);
+    return v;
+}
+
+Move unpackBookMove(uint32_t packed) {
+    Move m;
+    for (unsigned k=0; k<4; ++k) {
+        uint8_t b = uint8_t(packed >> (8*k));
+        if (!b) break;
+        int from = b>>3, die = b&7;
+        m.steps[m.n++] = { int8_t(from), int8_t(from-die<0 ? 0 : from-die), int8_t(die) };
+    }
+    return m;
+}
+
+BookBuildStats buildOpeningBook(const Search &search, const std::string &outPath, const BookOptions &opt) {
+    struct Task { size_t node; const Roll *roll; };
+    struct Result { BookSlot slot; std::vector<Position> children; };
+
+    ThreadPool pool(opt.threads);
+    std::vector<BookSlot> entries;
+    std::unordered_set<PositionId, IdHash> seen;
+    std::vector<Position> level = { Position::initial() };
+    seen.insert(PositionId::from(level.front()));
+
+    for (unsigned move=0; move<opt.depth && !level.empty(); ++move) {
+        std::vector<Task> tasks;
+        for (size_t i=0; i<level.size(); ++i)
+            for (const Roll &r : kRolls) tasks.push_back({i, &r});
+
+        std::vector<Result> results(tasks.size());
+        const bool last = move+1==opt.depth;
+        pool.parallelFor(tasks.size(), [&](size_t t){
+            const Position &p = level[tasks[t].node];
+            std::vector<ScoredPlay> ranked;
+            const Roll &roll = *tasks[t].roll;
+            search.rankPlays(p, roll.hi, roll.lo, opt.plies, ranked);
+
+            Result &r = results[t];
+            PositionId id = PositionId::from(p);
+            r.slot.lo = id.lo; r.slot.hi = id.hi;
+            r.slot.dice = diceKey(roll.hi, roll.lo);
+            r.slot.n = uint8_t(std::min(ranked.size(), BookSlot::kPlays));
+            for (unsigned k=0; k<r.slot.n; ++k)
+                r.slot.plays[k] = { packBookMove(ranked[k].cand.move), float(ranked[k].equity) };
+            if (last) return;
+            for (size_t k=0; k<ranked.size() && k<opt.expand; ++k) {
+                const Position &after = ranked[k].cand.after;
+                if (!after.finished(0)) r.children.push_back(after.swapped());
+            }
+        });
+
+        std::vector<Position> next;
+        for (Result &r : results) {
+            entries.push_back(r.slot);
+            for (const Position &c : r.children)
+                if (seen.insert(PositionId::from(c)).second) next.push_back(c);
+        }
+        level = std::move(next);
+    }
+
+    uint64_t slots = 16;
+    while (slots < 2*entries.size()) slots <<= 1;
+    std::vector<BookSlot> table(slots);
+    for (const BookSlot &e : entries) {
+        uint64_t i = slotHash({e.lo, e.hi}, e.dice) & (slots-1);
+        while (table[i].dice) i = (i+1) & (slots-1);
+        table[i] = e;
+    }
+
+    unsigned char hdr[BOOK_HEADER] = {};
+    uint64_t n = entries.size();
+    uint32_t plies = opt.plies, depth = opt.depth, gen = search.evaluator().generation;
+    std::memcpy(hdr, BOOK_MAGIC, 4);
+    std::memcpy(hdr+4, &BOOK_VERSION, 4);
+    std::memcpy(hdr+8, &slots, 8);
+    std::memcpy(hdr+16, &n, 8);
+    std::memcpy(hdr+24, &plies, 4);
+    std::memcpy(hdr+28, &depth, 4);
+    std::memcpy(hdr+32, &gen, 4);
+    const std::string &name = search.evaluator().name;
+    std::memcpy(hdr+40, name.data(), std::min(name.size(), BOOK_NAME-1));
+
+    std::string partial = outPath + ".partial";
+    {
+        std::ofstream f(partial, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(hdr), BOOK_HEADER);
+        f.write(reinterpret_cast<const char*>(table.data()), std::streamsize(slots*sizeof(BookSlot)));
+        f.flush();
+        if (!f) throw std::runtime_error(partial + ": write failed");
+    }
+    std::filesystem::rename(partial, outPath);
+
+    BookBuildStats st;
+    st.positions = seen.size();
+    st.entries = n;
+    st.slots = slots;
+    return st;
+}
+
+OpeningBook::OpeningBook(const std::string &path) : _file(path) {
+    const char *p = _file.data();
+    if (_file.size()<BOOK_HEADER || std::memcmp(p, BOOK_MAGIC, 4)!=0)
+        throw std::runtime_error(path + ": not an opening book");
+    uint32_t ver, plies, depth;
+    uint64_t slots;
+    std::memcpy(&ver, p+4, 4);
+    if (ver!=BOOK_VERSION) throw std::runtime_error(path + ": unsupported book version " + std::to_string(ver));
+    std::memcpy(&slots, p+8, 8);
+    std::memcpy(&_entries, p+16, 8);
+    std::memcpy(&plies, p+24, 4);
+    std::memcpy(&depth, p+28, 4);
+    std::memcpy(&_generation, p+32, 4);
+    if (slots==0 || (slots & (slots-1)) || BOOK_HEADER + slots*sizeof(BookSlot) > _file.size())
+        throw std::runtime_error(path + ": truncated or corrupt book");
+    _evaluator.assign(p+40, strnlen(p+40, BOOK_NAME));
+    _plies = plies; _depth = depth;
+    _mask = slots-1;
+    _slots = reinterpret_cast<const BookSlot*>(p + BOOK_HEADER);
+}
+
+const BookSlot *OpeningBook::find(const Position &p, int d1, int d2) const {
+    PositionId id = PositionId::from(p);
+    uint8_t dice = diceKey(d1, d2);
+    // At most one pass over the table: a corrupt book with no empty slot must still miss.
+    uint64_t i = slotHash(id, dice) & _mask;
+    for (uint64_t probes=0; probes<=_mask; ++probes, i = (i+1) & _mask) {
+        const BookSlot &s = _slots[i];
+        if (!s.dice) return nullptr;
+        if (s.dice==dice && s.lo==id.lo && s.hi==id.hi) return &s;
+    }
+    return nullptr;
+}
+
+bool OpeningBook::lookup(const Position &p, int d1, int d2, std::vector<ScoredPlay> &out) const {
+    out.clear();
+    const BookSlot *s = find(p, d1, d2);
+    if (!s) return false;
+    for (unsigned k=0; k<s->n; ++k) {
+        ScoredPlay sp;
+        sp.cand.move = unpackBookMove(s->plays[k].move);
+        sp.cand.after = p;
+        for (unsigned j=0; j<sp.cand.move.n; ++j)
+            doStep(sp.cand.after, sp.cand.move.steps[j].from-1, sp.cand.move.steps[j].die);
+        sp.equity = s->plays[k].equity;
+        sp.plies = _plies;
+        out.push_back(sp);
+    }
+    return true;
+}
+
+} // namespace BG
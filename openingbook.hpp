@@ -0,0 +1,134 @@
+/**
+ * @file openingbook.hpp
+ * @brief Precomputed best plays for the first moves, as a mapped hash table.
+ */
+
+#ifndef OPENINGBOOK_HPP
+#define OPENINGBOOK_HPP
+
+#include "mappedfile.hpp"
+#include "positionkey.hpp"
+#include "search.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @struct BookPlay
+ * @brief One booked play: packed steps and its equity for the mover.
+ *
+ * Step k is byte k of @c move: (from<<3 | die), from in the mover's
+ * numbering (25 = bar). The step count is the number of non-zero bytes.
+ */
+struct BookPlay {
+    uint32_t move=0;
+    float equity=0.f;
+};
+
+/**
+ * @struct BookSlot
+ * @brief One hash table slot (64 bytes, one cache line): position, roll and its best plays.
+ *
+ * @c dice is high*10+low; 0 marks an empty slot.
+ */
+struct BookSlot {
+    static constexpr size_t kPlays = 6;
+
+    uint64_t lo=0;              ///< PositionId::lo
+    uint16_t hi=0;              ///< PositionId::hi
+    uint8_t  dice=0;
+    uint8_t  n=0;               ///< plays stored, best first
+    uint32_t reserved=0;
+    BookPlay plays[kPlays];
+};
+static_assert(sizeof(BookSlot)==64, "BookSlot must stay one cache line");
+
+/// Pack a Move into BookPlay::move form.
+uint32_t packBookMove(const Move &m);
+
+/// Inverse of packBookMove().
+Move unpackBookMove(uint32_t packed);
+
+/**
+ * @struct BookOptions
+ * @brief Opening book build settings.
+ */
+struct BookOptions {
+    unsigned depth = 3;     ///< moves from the starting position to cover
+    unsigned plies = 1;     ///< search depth used to rank plays
+    unsigned expand = 2;    ///< best plays per roll whose replies are booked too
+    unsigned threads = 0;   ///< 0 = hardware concurrency
+};
+
+/**
+ * @struct BookBuildStats
+ * @brief Counters reported by buildOpeningBook().
+ */
+struct BookBuildStats {
+    uint64_t positions=0;   ///< distinct positions booked
+    uint64_t entries=0;     ///< (position, roll) slots filled
+    uint64_t slots=0;       ///< table size
+};
+
+/**
+ * @brief Rank every roll of every position reachable in the first moves and write the book.
+ *
+ * Starting from Position::initial(), each position gets all 21 rolls
+ * ranked by @p search at @c plies; the best @c expand plays of each roll
+ * lead to the next move's positions (merged when they transpose). The
+ * table is written to OUT.partial and renamed into place.
+ *
+ * @throws std::runtime_error on I/O errors.
+ */
+BookBuildStats buildOpeningBook(const Search &search, const std::string &outPath,
+                                const BookOptions &opt = {});
+
+/**
+ * @class OpeningBook
+ * @brief Read-only, memory-mapped opening book.
+ *
+ * Open addressing with linear probing at a load factor of at most one
+ * half, so a lookup is usually a single cache line. Positions are keyed
+ * by PositionId (side on roll first), so either colour finds the entry.
+ *
+ * File layout (little-endian):
+ * @code
+ *   "BGOB" u32 version u64 slots u64 entries u32 plies u32 depth
+ *   u32 generation u32 0 char evaluator[24]     // 64-byte header
+ *   BookSlot table[slots]                       // slots is a power of two
+ * @endcode
+ */
+class OpeningBook {
+public:
+    /// @throws std::runtime_error if @p path is not a readable book.
+    explicit OpeningBook(const std::string &path);
+
+    /// Slot for (@p p, @p d1, @p d2), or nullptr if the book does not hold it.
+    const BookSlot *find(const Position &p, int d1, int d2) const;
+
+    /**
+     * @brief Booked plays for (@p p, @p d1, @p d2), best first, with their resulting positions.
+     * @return false (and @p out empty) when the book does not hold the position.
+     */
+    bool lookup(const Position &p, int d1, int d2, std::vector<ScoredPlay> &out) const;
+
+    unsigned plies() const { return _plies; }
+    unsigned depth() const { return _depth; }
+    uint64_t entries() const { return _entries; }
+    const std::string &evaluator() const { return _evaluator; }
+    uint32_t generation() const { return _generation; }
+
+private:
+    MappedFile _file;
+    const BookSlot *_slots=nullptr;
+    uint64_t _mask=0, _entries=0;
+    unsigned _plies=0, _depth=0;
+    uint32_t _generation=0;
+    std::string _evaluator;
+};
+
+} // namespace BG
+
+#endif // OPENINGBOOK_HPP
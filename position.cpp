@@ -0,0 +1,75 @@
+/**
+ * @file position.cpp
+ * @brief Position queries and conversion to/from Board::State.
+ */
+
+#include "position.hpp"
+
+namespace BG {
+
+unsigned Position::pips(int s) const {
+    unsigned n=0;
+    for (int i=0; i<25; ++i) n += unsigned(checkers[s][i])*unsigned(i+1);
+    return n;
+}
+
+unsigned Position::inPlay(int s) const {
+    unsigned n=0;
+    for (int i=0; i<25; ++i) n += checkers[s][i];
+    return n;
+}
+
+bool Position::contact() const {
+    int back0=-1, back1=-1;
+    for (int i=24; i>=0 && back0<0; --i) if (checkers[0][i]) back0=i;
+    for (int i=24; i>=0 && back1<0; --i) if (checkers[1][i]) back1=i;
+    if (back0<0 || back1<0) return false;
+    return back0 + back1 > 23;
+}
+
+unsigned Position::winMultiplier(int s) const {
+    int l = 1-s;
+    if (off[l]>0) return 1;
+    // Loser on the bar or in the winner's home board (loser's points 19..24).
+    for (int i=18; i<25; ++i) if (checkers[l][i]) return 3;
+    return 2;
+}
+
+Position Position::fromState(const Board::State &st, Side onRoll) {
+    Position p;
+    int wr = onRoll==BLACK ? 1 : 0;     // row holding WHITE
+    for (int b=1; b<=24; ++b) {
+        const auto &pt = st.points[b-1];
+        if (!pt.count || pt.side==NONE) continue;
+        // WHITE's own point = board point; BLACK's own point = 25 - board point.
+        int row = pt.side==WHITE ? wr : 1-wr;
+        int own = pt.side==WHITE ? b : 25-b;
+        p.checkers[row][own-1] = uint8_t(pt.count);
+    }
+    p.checkers[wr][kBar]   = uint8_t(st.whitebar);
+    p.checkers[1-wr][kBar] = uint8_t(st.blackbar);
+    p.off[wr]   = uint8_t(st.whiteoff);
+    p.off[1-wr] = uint8_t(st.blackoff);
+    return p;
+}
+
+void Position::toState(Side onRoll, Board::State &st) const {
+    st = Board::State{};
+    int wr = onRoll==BLACK ? 1 : 0;
+    for (int i=0; i<24; ++i) {
+        if (unsigned c = checkers[wr][i])   { auto &pt = st.points[i];    pt.side = WHITE; pt.count = c; }
+        if (unsigned c = checkers[1-wr][i]) { auto &pt = st.points[23-i]; pt.side = BLACK; pt.count = c; }
+    }
+    st.whitebar = checkers[wr][kBar];   st.blackbar = checkers[1-wr][kBar];
+    st.whiteoff = off[wr];              st.blackoff = off[1-wr];
+}
+
+Position Position::initial(Variant variant) {
+    const StartLayout l = StartLayout::of(variant);
+    Position p;
+    for (int s=0; s<2; ++s)
+        for (int i=0; i<24; ++i) p.checkers[s][i] = l.count[i];
+    return p;
+}
+
+} // namespace BG
@@ -0,0 +1,66 @@
+/**
+ * @file position.hpp
+ * @brief Compact on-roll-relative position used by move generation, evaluation and search.
+ */
+
+#ifndef POSITION_HPP
+#define POSITION_HPP
+
+#include "board.hpp"
+#include <array>
+#include <cstdint>
+
+namespace BG {
+
+/**
+ * @struct Position
+ * @brief Checker layout seen from the side on roll.
+ *
+ * checkers[0] belongs to the side on roll, checkers[1] to its opponent.
+ * Each side counts its own points: index i (0..23) is that side's point
+ * i+1, so both move toward index 0; index 24 is the bar. Opponent index j
+ * is the same physical point as own index 23-j.
+ */
+struct Position {
+    static constexpr int kBar = 24;
+
+    std::array<std::array<uint8_t, 25>, 2> checkers{};
+    std::array<uint8_t, 2> off{};
+
+    /// Same position with the other side on roll.
+    Position swapped() const { Position p; p.checkers = {checkers[1], checkers[0]}; p.off = {off[1], off[0]}; return p; }
+
+    /// Pip count of side @p s (bar counts 25).
+    unsigned pips(int s) const;
+
+    /// Checkers of side @p s still in play (board + bar).
+    unsigned inPlay(int s) const;
+
+    /// True once side @p s has borne off everything.
+    bool finished(int s) const { return inPlay(s)==0; }
+
+    /// True while the two armies can still hit each other.
+    bool contact() const;
+
+    /**
+     * @brief Points won by side @p s, which has just borne off its last checker.
+     * @return 1 single, 2 gammon (loser bore off nothing), 3 backgammon
+     *         (gammon with a loser checker on the bar or in the winner's home).
+     */
+    unsigned winMultiplier(int s) const;
+
+    bool operator==(const Position&) const = default;
+
+    /// Project a Board snapshot onto @p onRoll's view.
+    static Position fromState(const Board::State &st, Side onRoll);
+
+    /// Inverse of fromState(); cube is left at 1.
+    void toState(Side onRoll, Board::State &st) const;
+
+    /// Starting position of @p variant.
+    static Position initial(Variant variant = Variant::Standard);
+};
+
+} // namespace BG
+
+#endif // POSITION_HPP
@@ -0,0 +1,280 @@
+/**
+ * @file positionindex.cpp
+ * @brief Parallel external-sort index build and the mapped index reader.
+ */
+
+#include "positionindex.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+namespace BG {
+
+namespace {
+
+constexpr char     INDEX_MAGIC[4] = {'B','G','I','X'};
+constexpr uint32_t INDEX_VERSION  = 2;   // 2: colour-canonical hashes
+constexpr size_t   INDEX_HEADER   = 16;
+
+using Game = std::vector<RecordEvent>;
+using Batch = std::vector<Game>;
+
+inline bool entryLess(const IndexEntry &a, const IndexEntry &b) {
+    if (a.hash!=b.hash) return a.hash<b.hash;
+    if (a.gameId!=b.gameId) return a.gameId<b.gameId;
+    return a.move<b.move;
+}
+
+/// Bounded hand-off of game batches from the archive reader to the workers.
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t cap) : _cap(cap) {}
+
+    void push(Batch b) {
+        std::unique_lock<std::mutex> lk(_mu);
+        _notFull.wait(lk, [&]{ return _q.size()<_cap || _closed; });
+        if (_closed) return;
+        _q.push_back(std::move(b));
+        _notEmpty.notify_one();
+    }
+    bool pop(Batch &b) {
+        std::unique_lock<std::mutex> lk(_mu);
+        _notEmpty.wait(lk, [&]{ return !_q.empty() || _closed; });
+        if (_q.empty()) return false;
+        b = std::move(_q.front()); _q.pop_front();
+        _notFull.notify_one();
+        return true;
+    }
+    void close() {
+        std::lock_guard<std::mutex> lk(_mu);
+        _closed = true;
+        _notEmpty.notify_all(); _notFull.notify_all();
+    }
+
+private:
+    std::mutex _mu;
+    std::condition_variable _notEmpty, _notFull;
+    std::deque<Batch> _q;
+    size_t _cap;
+    bool _closed=false;
+};
+
+std::runtime_error sysError(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+IndexBuildStats buildPositionIndex(const std::vector<std::string> &archives,
+                                   const std::string &outPath,
+                                   const IndexBuildOptions &opt)
+{
+    namespace fs = std::filesystem;
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t runCap = std::max<size_t>(size_t(1)<<16, opt.memoryBytes / sizeof(IndexEntry) / threads);
+
+    fs::path tmp = opt.tmpDir.empty() ? fs::path(outPath + ".runs") : fs::path(opt.tmpDir);
+    fs::create_directories(tmp);
+
+    IndexBuildStats st;
+    std::atomic<uint64_t> games{0}, badGames{0};
+    std::mutex runMu;
+    std::vector<std::string> runs;
+    // Run files (and a directory we made for them) go however the build ends.
+    struct RunFiles {
+        const std::vector<std::string> &runs;
+        fs::path dir;
+        bool ownDir;
+        ~RunFiles() {
+            std::error_code ec;
+            for (const std::string &r : runs) fs::remove(r, ec);
+            if (ownDir) fs::remove(dir, ec);
+        }
+    } runFiles{runs, tmp, opt.tmpDir.empty()};
+    std::exception_ptr failure;
+    std::mutex failMu;
+    auto setFailure = [&](std::exception_ptr e){
+        std::lock_guard<std::mutex> lk(failMu);
+        if (!failure) failure = e;
+    };
+
+    // ---- Phase 1: replay games, sort and spill runs --------------------------
+    BatchQueue queue(2*threads);
+
+    auto spill = [&](std::vector<IndexEntry> &buf){
+        if (buf.empty()) return;
+        std::sort(buf.begin(), buf.end(), entryLess);
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lk(runMu);
+            path = (tmp / ("run-" + std::to_string(runs.size()) + ".bin")).string();
+            runs.push_back(path);
+        }
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(buf.data()), std::streamsize(buf.size()*sizeof(IndexEntry)));
+        if (!f) throw std::runtime_error(path + ": write failed");
+        buf.clear();
+    };
+
+    auto worker = [&]{
+        try {
+            std::vector<IndexEntry> buf;
+            buf.reserve(runCap);
+            Board::State s;
+            Batch batch;
+            while (queue.pop(batch)) {
+                for (const Game &g : batch) {
+                    uint64_t id = g.front().header.gameId;
+                    bool ok = forEachPlayPosition(g, [&](const Board &b, uint32_t move){
+                        b.getState(s);
+                        buf.push_back({positionHash(s, b.sideToMove()), id, move, 0});
+                        if (buf.size()==runCap) spill(buf);
+                    });
+                    ++games;
+                    if (!ok) ++badGames;
+                }
+            }
+            spill(buf);
+        } catch (...) {
+            setFailure(std::current_exception());
+            queue.close();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t=0; t<threads; ++t) pool.emplace_back(worker);
+    try {
+        for (const std::string &path : archives) {
+            MappedFile mf(path);
+            RecordReader rr(mf.data(), mf.size());
+            GameReader gr(rr);
+            Batch batch;
+            Game g;
+            while (gr.next(g)) {
+                batch.push_back(std::move(g));
+                if (batch.size()==256) { queue.push(std::move(batch)); batch = Batch{}; }
+            }
+            if (!batch.empty()) queue.push(std::move(batch));
+        }
+    } catch (...) {
+        setFailure(std::current_exception());
+    }
+    queue.close();
+    for (auto &t : pool) t.join();
+    if (failure) std::rethrow_exception(failure);
+
+    // ---- Phase 2: parallel k-way merge into the mapped output ----------------
+    std::vector<std::unique_ptr<MappedFile>> maps;
+    std::vector<std::span<const IndexEntry>> runSpans;
+    uint64_t total = 0;
+    for (const std::string &r : runs) {
+        maps.push_back(std::make_unique<MappedFile>(r));
+        auto *p = reinterpret_cast<const IndexEntry*>(maps.back()->data());
+        runSpans.emplace_back(p, maps.back()->size()/sizeof(IndexEntry));
+        total += runSpans.back().size();
+    }
+
+    // Hashes are uniform, so equal slices of the hash space balance the merge.
+    const size_t parts = size_t(threads)*4;
+    const uint64_t step = ~uint64_t(0) / parts;
+    auto bound = [&](size_t k) -> uint64_t { return uint64_t(k)*step; };   // first hash of part k
+    std::vector<std::vector<size_t>> cut(parts+1, std::vector<size_t>(runSpans.size()));
+    for (size_t r=0; r<runSpans.size(); ++r) {
+        auto sp = runSpans[r];
+        for (size_t k=0; k<=parts; ++k) {
+            if (k==parts) { cut[k][r] = sp.size(); continue; }
+            uint64_t h = bound(k);
+            cut[k][r] = size_t(std::lower_bound(sp.begin(), sp.end(), h,
+                [](const IndexEntry &e, uint64_t v){ return e.hash<v; }) - sp.begin());
+        }
+    }
+    std::vector<uint64_t> outOff(parts+1, 0);
+    for (size_t k=0; k<parts; ++k) {
+        uint64_t n=0;
+        for (size_t r=0; r<runSpans.size(); ++r) n += cut[k+1][r]-cut[k][r];
+        outOff[k+1] = outOff[k]+n;
+    }
+
+    std::string partial = outPath + ".partial";
+    int fd = ::open(partial.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd<0) throw sysError(partial);
+    size_t bytes = INDEX_HEADER + size_t(total)*sizeof(IndexEntry);
+    if (::ftruncate(fd, off_t(bytes))!=0) { ::close(fd); throw sysError(partial); }
+    void *map = ::mmap(nullptr, bytes, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map==MAP_FAILED) { ::close(fd); throw sysError(partial); }
+    ::close(fd);
+
+    auto *hdr = static_cast<uint8_t*>(map);
+    std::memcpy(hdr, INDEX_MAGIC, 4);
+    std::memcpy(hdr+4, &INDEX_VERSION, 4);
+    std::memcpy(hdr+8, &total, 8);
+    auto *out = reinterpret_cast<IndexEntry*>(hdr + INDEX_HEADER);
+
+    std::atomic<size_t> nextPart{0};
+    auto merger = [&]{
+        struct Cur { const IndexEntry *p, *end; };
+        auto greater = [](const Cur &a, const Cur &b){ return entryLess(*b.p, *a.p); };
+        for (size_t k; (k = nextPart.fetch_add(1)) < parts; ) {
+            std::priority_queue<Cur, std::vector<Cur>, decltype(greater)> heap(greater);
+            for (size_t r=0; r<runSpans.size(); ++r) {
+                const IndexEntry *b = runSpans[r].data()+cut[k][r], *e = runSpans[r].data()+cut[k+1][r];
+                if (b<e) heap.push({b, e});
+            }
+            IndexEntry *dst = out + outOff[k];
+            while (!heap.empty()) {
+                Cur c = heap.top(); heap.pop();
+                *dst++ = *c.p++;
+                if (c.p<c.end) heap.push(c);
+            }
+        }
+    };
+    pool.clear();
+    for (unsigned t=0; t<threads; ++t) pool.emplace_back(merger);
+    for (auto &t : pool) t.join();
+
+    int rc = ::msync(map, bytes, MS_SYNC);
+    ::munmap(map, bytes);
+    if (rc!=0) throw sysError(partial);
+
+    maps.clear();
+    fs::rename(partial, outPath);
+
+    st.games = games; st.positions = total; st.badGames = badGames; st.runs = runs.size();
+    return st;
+}
+
+PositionIndex::PositionIndex(const std::string &path) : _file(path) {
+    const char *p = _file.data();
+    if (_file.size()<INDEX_HEADER || std::memcmp(p, INDEX_MAGIC, 4)!=0)
+        throw std::runtime_error(path + ": not a position index");
+    uint32_t ver; uint64_t n;
+    std::memcpy(&ver, p+4, 4);
+    std::memcpy(&n, p+8, 8);
+    if (ver!=INDEX_VERSION) throw std::runtime_error(path + ": unsupported index version " + std::to_string(ver));
+    if (n > (_file.size()-INDEX_HEADER)/sizeof(IndexEntry)) throw std::runtime_error(path + ": truncated index");
+    _entries = { reinterpret_cast<const IndexEntry*>(p + INDEX_HEADER), size_t(n) };
+}
+
+std::span<const IndexEntry> PositionIndex::find(uint64_t hash) const {
+    auto lo = std::lower_bound(_entries.begin(), _entries.end(), hash,
+        [](const IndexEntry &e, uint64_t v){ return e.hash<v; });
+    auto hi = std::upper_bound(lo, _entries.end(), hash,
+        [](uint64_t v, const IndexEntry &e){ return v<e.hash; });
+    return { lo, hi };
+}
+
+} // namespace BG
@@ -0,0 +1,106 @@
+/**
+ * @file positionindex.hpp
+ * @brief Sorted on-disk index from position hash to (game id, move number).
+ *
+ * File layout (little-endian):
+ * @code
+ *   "BGIX" u32 version u64 count                // header, 16 bytes
+ *   { u64 hash, u64 gameId, u32 move, u32 0 }*  // sorted by (hash, gameId, move)
+ * @endcode
+ * "move" counts the plays of a game from 0; entry (g, m) is the position the
+ * side on roll faced before play m of game g. Hashes are of the canonical
+ * PositionKey, so one query finds a position whichever colour faced it.
+ */
+
+#ifndef POSITIONINDEX_HPP
+#define POSITIONINDEX_HPP
+
+#include "gamerecord.hpp"
+#include "mappedfile.hpp"
+#include "positionkey.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/// One index row.
+struct IndexEntry {
+    uint64_t hash;
+    uint64_t gameId;
+    uint32_t move;
+    uint32_t reserved;
+};
+static_assert(sizeof(IndexEntry)==24, "IndexEntry is an on-disk layout");
+
+/**
+ * @brief Replay @p game, calling @p fn(board, move) before each play.
+ * @return false if an event fails to replay (positions up to it were visited).
+ */
+template <class F>
+bool forEachPlayPosition(const std::vector<RecordEvent> &game, F &&fn) {
+    Board b;
+    uint32_t move = 0;
+    for (const RecordEvent &ev : game) {
+        if (ev.type==RecordEvent::Type::Play) fn(static_cast<const Board&>(b), move++);
+        if (!replayEvent(b, ev)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Options for buildPositionIndex().
+ */
+struct IndexBuildOptions {
+    unsigned threads = 0;                 ///< 0 = hardware concurrency
+    size_t memoryBytes = size_t(1) << 30; ///< total budget for in-memory sort runs
+    std::string tmpDir;                   ///< run files (default: next to the output)
+};
+
+/**
+ * @brief Counters reported by buildPositionIndex().
+ */
+struct IndexBuildStats {
+    uint64_t games=0, positions=0, badGames=0, runs=0;
+};
+
+/**
+ * @brief Build an index over one or more record archives.
+ *
+ * Worker threads replay games and fill per-thread buffers that are sorted and
+ * spilled as run files when full; the runs are then merged in parallel, each
+ * thread filling a disjoint hash range of the memory-mapped output. Peak
+ * memory stays near IndexBuildOptions::memoryBytes regardless of input size.
+ *
+ * @throws std::runtime_error (or RecordError) on I/O or format errors.
+ */
+IndexBuildStats buildPositionIndex(const std::vector<std::string> &archives,
+                                   const std::string &outPath,
+                                   const IndexBuildOptions &opt = {});
+
+/**
+ * @class PositionIndex
+ * @brief Read-only, memory-mapped view of an index file.
+ */
+class PositionIndex {
+public:
+    /// @throws std::runtime_error if the file is missing or not an index.
+    explicit PositionIndex(const std::string &path);
+
+    size_t size() const { return _entries.size(); }
+    std::span<const IndexEntry> entries() const { return _entries; }
+
+    /// Every occurrence of @p hash (empty if none), ordered by game and move.
+    std::span<const IndexEntry> find(uint64_t hash) const;
+
+    std::span<const IndexEntry> find(const PositionKey &k) const { return find(k.hash()); }
+
+private:
+    MappedFile _file;
+    std::span<const IndexEntry> _entries;
+};
+
+} // namespace BG
+
+#endif // POSITIONINDEX_HPP
@@ -0,0 +1,117 @@
+/**
+ * @file positionkey.cpp
+ * @brief PositionKey packing, hashing and hex conversion.
+ */
+
+#include "positionkey.hpp"
+
+namespace BG {
+
+PositionKey PositionKey::from(const Board::State &s, Side onRoll) {
+    // BLACK on roll: read the mirror in place (point 25-p, colours swapped).
+    const bool mirror = onRoll==BLACK;
+    const Side blackSide = mirror ? WHITE : BLACK;
+    PositionKey k;
+    for (int i=0; i<24; ++i) {
+        const auto &pt = s.points[mirror ? 23-i : i];
+        if (pt.count==0 || pt.side==NONE) continue;
+        k.bytes[i] = uint8_t(pt.count | (pt.side==blackSide ? 0x80 : 0));
+    }
+    k.bytes[24] = uint8_t(mirror ? s.blackbar : s.whitebar);
+    k.bytes[25] = uint8_t(mirror ? s.whitebar : s.blackbar);
+    k.bytes[26] = uint8_t(mirror ? s.blackoff : s.whiteoff);
+    k.bytes[27] = uint8_t(mirror ? s.whiteoff : s.blackoff);
+    return k;
+}
+
+void PositionKey::toState(Board::State &s) const {
+    s = Board::State{};
+    for (int i=0; i<24; ++i) {
+        uint8_t b = bytes[i];
+        if ((b & 0x7F)==0) continue;
+        s.points[i].count = b & 0x7F;
+        s.points[i].side = (b & 0x80) ? BLACK : WHITE;
+    }
+    s.whitebar = bytes[24]; s.blackbar = bytes[25];
+    s.whiteoff = bytes[26]; s.blackoff = bytes[27];
+}
+
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27; x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t PositionKey::hash() const {
+    // Little-endian 8-byte words folded through a splitmix finalizer.
+    uint64_t h = 0x6A09E667F3BCC909ull ^ kSize;
+    for (size_t off=0; off<kSize; off+=8) {
+        uint64_t w=0;
+        for (size_t i=0; i<8 && off+i<kSize; ++i) w |= uint64_t(bytes[off+i]) << (8*i);
+        h = mix64(h ^ w) + 0x9E3779B97F4A7C15ull;
+    }
+    return mix64(h);
+}
+
+std::string PositionKey::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(2*kSize, '0');
+    for (size_t i=0; i<kSize; ++i) {
+        out[2*i]   = digits[bytes[i]>>4];
+        out[2*i+1] = digits[bytes[i]&15];
+    }
+    return out;
+}
+
+bool PositionKey::parseHex(std::string_view text, PositionKey &out) {
+    if (text.size()!=2*kSize) return false;
+    auto nib = [](char c) -> int {
+        if (c>='0' && c<='9') return c-'0';
+        if (c>='a' && c<='f') return c-'a'+10;
+        if (c>='A' && c<='F') return c-'A'+10;
+        return -1;
+    };
+    for (size_t i=0; i<kSize; ++i) {
+        int hi = nib(text[2*i]), lo = nib(text[2*i+1]);
+        if (hi<0 || lo<0) return false;
+        out.bytes[i] = uint8_t(hi<<4 | lo);
+    }
+    return true;
+}
+
+PositionId PositionId::from(const Position &p) {
+    PositionId id;
+    unsigned bit = 0;
+    for (int s=0; s<2; ++s) {
+        for (int i=0; i<25; ++i) {
+            for (unsigned n=p.checkers[s][i]; n>0 && bit<80; --n, ++bit) {
+                if (bit<64) id.lo |= uint64_t(1) << bit;
+                else        id.hi |= uint16_t(1u << (bit-64));
+            }
+            ++bit;   // separator
+        }
+    }
+    return id;
+}
+
+uint64_t PositionId::hash() const {
+    return mix64(mix64(lo ^ 0x6A09E667F3BCC909ull) + 0x9E3779B97F4A7C15ull + hi);
+}
+
+Position PositionId::toPosition(unsigned checkers) const {
+    Position p;
+    unsigned bit = 0;
+    auto get = [&](unsigned b){ return b<64 ? ((lo>>b)&1) : ((hi>>(b-64))&1); };
+    for (int s=0; s<2; ++s) {
+        for (int i=0; i<25; ++i) {
+            while (bit<80 && get(bit)) { ++p.checkers[s][i]; ++bit; }
+            ++bit;
+        }
+        unsigned n = p.inPlay(s);
+        p.off[s] = uint8_t(n<checkers ? checkers-n : 0);
+    }
+    return p;
+}
+
+} // namespace BG
@@ -0,0 +1,83 @@
+/**
+ * @file positionkey.hpp
+ * @brief Packed position keys and 64-bit position hashes.
+ */
+
+#ifndef POSITIONKEY_HPP
+#define POSITIONKEY_HPP
+
+#include "board.hpp"
+#include "position.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace BG {
+
+/**
+ * @struct PositionKey
+ * @brief Exact, byte-packed checker position in canonical (WHITE on roll) orientation.
+ *
+ * A position with BLACK on roll is keyed as its Board::State::mirrored()
+ * twin with WHITE on roll, so both colourings of one position share a key
+ * and a hash. Layout: bytes 0..23 are points 1..24 (count, bit 7 set for
+ * BLACK), then white bar, black bar, white off, black off.
+ * Cube and dice are not part of the key.
+ */
+struct PositionKey {
+    static constexpr size_t kSize = 28;
+    std::array<uint8_t, kSize> bytes{};
+
+    /// Build the canonical key for @p s with @p onRoll to move.
+    static PositionKey from(const Board::State &s, Side onRoll);
+
+    /// 64-bit hash of the key (stable across runs and platforms).
+    uint64_t hash() const;
+
+    /// Lower-case hex form (2*kSize characters).
+    std::string hex() const;
+
+    /// Parse hex(); false on bad length or digits.
+    static bool parseHex(std::string_view text, PositionKey &out);
+
+    /// Reconstruct the board in canonical orientation (WHITE on roll).
+    void toState(Board::State &s) const;
+
+    bool operator==(const PositionKey&) const = default;
+};
+
+/**
+ * @struct PositionId
+ * @brief 80-bit packed checker layout of a Position (side on roll first).
+ *
+ * Position is already relative to the side on roll, so the ID is
+ * colour-independent by construction.
+ *
+ * For each side and each of its indices 0..24 (bar last), one 1-bit per
+ * checker followed by a 0-bit; at most 30 + 50 bits for 15 checkers a side.
+ * Borne-off counts are implied by the checker total.
+ */
+struct PositionId {
+    uint64_t lo=0;
+    uint16_t hi=0;
+
+    static PositionId from(const Position &p);
+
+    /// Decode; off counts are @p checkers minus those in play.
+    Position toPosition(unsigned checkers = 15) const;
+
+    /// 64-bit hash of the ID (stable across runs and platforms).
+    uint64_t hash() const;
+
+    bool operator==(const PositionId&) const = default;
+};
+
+/// Shorthand for PositionKey::from(s, onRoll).hash().
+inline uint64_t positionHash(const Board::State &s, Side onRoll) {
+    return PositionKey::from(s, onRoll).hash();
+}
+
+} // namespace BG
+
+#endif // POSITIONKEY_HPP
@@ -0,0 +1,284 @@
+/**
+ * @file rollout.cpp
+ * @brief Rollout dice, trial play-out and parallel aggregation.
+ */
+
+#include "rollout.hpp"
+#include "dice.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace BG {
+
+namespace {
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27; x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+inline uint64_t splitmix(uint64_t &s) { return mix64(s += 0x9E3779B97F4A7C15ull); }
+
+/// Uniform integer in [0, n) from 64 random bits.
+inline unsigned below(uint64_t bits, unsigned n) { return unsigned(((bits >> 32) * n) >> 32); }
+
+inline void outcome(unsigned o, int &d1, int &d2) { d1 = int(o/6) + 1; d2 = int(o%6) + 1; }
+
+/// Best 0-ply play equity for every distinct roll of @p p, in kRolls order.
+void bestByRoll(const Search &search, const Position &p, std::vector<Candidate> &cands, double *best) {
+    for (size_t k=0; k<kRolls.size(); ++k) {
+        generatePlays(p, kRolls[k].hi, kRolls[k].lo, cands);
+        double b = -1e9;
+        for (const Candidate &c : cands) b = std::max(b, search.playEquity(c.after, 0));
+        best[k] = b;
+    }
+}
+
+/// @p p for the other side.
+Probs flippedProbs(const Probs &p) {
+    Probs f;
+    f.win = 1.f - p.win;
+    f.winGammon = p.loseGammon;
+    f.loseGammon = p.winGammon;
+    return f;
+}
+
+RolloutStats flipped(const RolloutStats &s) {
+    RolloutStats f = s;
+    f.sum = -s.sum;
+    f.cfSum = -s.cfSum;
+    std::swap(f.wins, f.losses);
+    std::swap(f.gammons, f.lostGammons);
+    std::swap(f.backgammons, f.lostBackgammons);
+    return f;
+}
+
+} // namespace
+
+RolloutDice::RolloutDice(DiceMode mode, unsigned rotate, uint64_t seed, uint64_t trial)
+    : _mode(mode), _rotate(std::min(rotate, 2u)), _seed(seed), _trial(trial),
+      _rng(mix64(seed ^ mix64(trial + 1))) {}
+
+void RolloutDice::roll(unsigned turn, int &d1, int &d2) {
+    if (turn<_rotate) {
+        uint64_t t = _trial;
+        outcome(unsigned(turn==0 ? t % 36 : (t + t/36) % 36), d1, d2);
+        return;
+    }
+    if (_mode==DiceMode::Random) {
+        outcome(below(splitmix(_rng), 36), d1, d2);
+        return;
+    }
+    // Stratified: slot (trial mod 36) of a permutation shared by this block of 36 trials.
+    uint64_t s = mix64(_seed ^ mix64((uint64_t(turn) << 40) ^ (_trial/36)));
+    uint8_t perm[36];
+    for (unsigned i=0; i<36; ++i) perm[i] = uint8_t(i);
+    for (unsigned i=35; i>0; --i) std::swap(perm[i], perm[below(splitmix(s), i+1)]);
+    outcome(perm[_trial % 36], d1, d2);
+}
+
+void RolloutStats::add(int points, double value, double cubeful) {
+    ++trials;
+    sum += value; sumSq += value*value;
+    cfSum += cubeful; cfSumSq += cubeful*cubeful;
+    if (points>0) { ++wins; gammons += points>=2; backgammons += points>=3; }
+    else          { ++losses; lostGammons += points<=-2; lostBackgammons += points<=-3; }
+}
+
+void RolloutStats::add(const Probs &pr, double value, double cubeful) {
+    ++trials; ++truncated;
+    sum += value; sumSq += value*value;
+    cfSum += cubeful; cfSumSq += cubeful*cubeful;
+    wins += pr.win; gammons += pr.winGammon;
+    losses += 1.0 - pr.win; lostGammons += pr.loseGammon;
+}
+
+void RolloutStats::merge(const RolloutStats &o) {
+    trials += o.trials; sum += o.sum; sumSq += o.sumSq;
+    cfSum += o.cfSum; cfSumSq += o.cfSumSq;
+    doubles += o.doubles; drops += o.drops; truncated += o.truncated;
+    wins += o.wins; gammons += o.gammons; backgammons += o.backgammons;
+    losses += o.losses; lostGammons += o.lostGammons; lostBackgammons += o.lostBackgammons;
+}
+
+Probs RolloutStats::probs() const {
+    Probs p;
+    if (!trials) return p;
+    double n = double(trials);
+    p.win = float(wins/n);
+    p.winGammon = float(gammons/n);
+    p.loseGammon = float(lostGammons/n);
+    return p;
+}
+
+Rollout::Trial Rollout::trial(const Position &start, uint64_t t) const {
+    Trial r{0, 0.0, 0.0, false, false, false, Probs{}};
+    const double unit = double(std::max(1u, _opt.cube));
+    if (start.finished(1)) {
+        r.points = -int(start.winMultiplier(1));
+        r.value = r.cubeful = r.points;
+        return r;
+    }
+
+    RolloutDice dice(_opt.dice, _opt.rotate, _opt.seed, t);
+    std::vector<ScoredPlay> plays;
+    std::vector<Candidate> cands;
+    double best[21];
+    double luck = 0.0, cfLuck = 0.0;    // accumulated for the root side
+    unsigned cube = std::max(1u, _opt.cube);
+    int owner = _opt.cubeOwner;         // -1 centred, else 0 root / 1 opponent
+    bool settled = false;               // cubeful result fixed by a drop
+    Position p = start;
+    for (unsigned turn=0; ; ++turn) {
+        const int mover = int(turn & 1);
+        const double sign = mover ? -1.0 : 1.0;
+
+        if (_opt.truncate && turn==_opt.truncate) {
+            Probs pr = _search.evaluator().evaluate(p);
+            if (mover) pr = flippedProbs(pr);
+            const double eq = pr.equity();
+            r.truncated = true;
+            r.probs = pr;
+            r.value = eq - luck;
+            if (!settled) r.cubeful = eq*double(cube)/unit - cfLuck;
+            return r;
+        }
+
+        if (!settled && (owner<0 || owner==mover)) {
+            const CubePolicy *dbl = _opt.cubePolicy[mover], *tkr = _opt.cubePolicy[1-mover];
+            if (dbl && dbl->offer(p, cube)) {
+                if (!tkr || tkr->take(p, cube)) {
+                    cube *= 2; owner = 1-mover; r.doubled = true;
+                } else {
+                    r.cubeful = sign*double(cube)/unit - cfLuck;
+                    r.dropped = settled = true;
+                }
+            }
+        }
+
+        int d1, d2;
+        dice.roll(turn, d1, d2);
+        if (_opt.luckAdjust) {
+            bestByRoll(_search, p, cands, best);
+            double avg = 0.0;
+            for (size_t k=0; k<kRolls.size(); ++k) avg += best[k] * kRolls[k].weight;
+            double l = sign * (best[kRollIndex[d1][d2]] - avg/36.0);
+            luck += l;
+            if (!settled) cfLuck += l * double(cube)/unit;
+        }
+        _search.hint(p, d1, d2, _opt.plies, 1, plays);
+        const Position &after = plays.front().cand.after;
+        if (after.finished(0)) {
+            int mult = int(after.winMultiplier(0));
+            r.points = mover ? -mult : mult;
+            r.value = double(r.points) - luck;
+            if (!settled) {
+                if (_opt.jacoby && owner<0) mult = 1;
+                r.cubeful = sign*double(mult*cube)/unit - cfLuck;
+            }
+            return r;
+        }
+        p = after.swapped();
+    }
+}
+
+RolloutStats Rollout::trials(const Position &p, uint64_t first, uint64_t count) const {
+    std::vector<Trial> res(count);
+    {
+        ThreadPool pool(_opt.threads);
+        pool.parallelFor(count, [&](size_t i){ res[i] = trial(p, first+i); }, 4);
+    }
+    RolloutStats st;
+    for (const Trial &r : res) record(st, r);
+    return st;
+}
+
+void Rollout::record(RolloutStats &st, const Trial &r) {
+    if (r.truncated) st.add(r.probs, r.value, r.cubeful);
+    else             st.add(r.points, r.value, r.cubeful);
+    st.doubles += r.doubled;
+    st.drops += r.dropped;
+}
+
+bool Rollout::precise(const RolloutStats &st) const {
+    return _opt.stopStdErr>0.0 && st.trials>=std::max<uint64_t>(2, _opt.minTrials) && st.stdErr()<_opt.stopStdErr;
+}
+
+RolloutOptions Rollout::swappedOptions() const {
+    RolloutOptions o = _opt;
+    std::swap(o.cubePolicy[0], o.cubePolicy[1]);
+    if (o.cubeOwner>=0) o.cubeOwner = 1-o.cubeOwner;
+    return o;
+}
+
+RolloutStats Rollout::position(const Position &p) const {
+    if (_opt.stopStdErr<=0.0) return trials(p, 0, _opt.trials);
+    const uint64_t batch = std::max<uint64_t>(1, _opt.batch);
+    RolloutStats st;
+    while (st.trials<_opt.trials && !precise(st))
+        st.merge(trials(p, st.trials, std::min(batch, _opt.trials-st.trials)));
+    return st;
+}
+
+RolloutStats Rollout::play(const Position &after) const {
+    if (after.finished(0)) {
+        RolloutStats st;
+        int pts = int(after.winMultiplier(0));
+        for (uint64_t i=0; i<_opt.trials; ++i) st.add(pts, double(pts), double(pts));
+        return st;
+    }
+    // Roll out from the opponent's side: swap the cube policies and ownership with the roles.
+    return flipped(Rollout(_search, swappedOptions()).position(after.swapped()));
+}
+
+std::vector<RolloutStats> Rollout::compare(const std::vector<Position> &afters) const {
+    const size_t n = afters.size();
+    std::vector<RolloutStats> st(n);
+    std::vector<std::vector<double>> values(n);     // per trial, for paired differences
+    std::vector<char> live(n, 1);
+    const Rollout opp(_search, swappedOptions());
+    const bool sequential = _opt.stopStdErr>0.0 || _opt.pruneSigmas>0.0;
+    const uint64_t batch = sequential ? std::max<uint64_t>(1, _opt.batch) : _opt.trials;
+
+    ThreadPool pool(_opt.threads);
+    std::vector<size_t> run;
+    std::vector<Trial> res;
+    for (uint64_t done=0; done<_opt.trials; ) {
+        const uint64_t count = std::min(batch, _opt.trials-done);
+        run.clear();
+        for (size_t i=0; i<n; ++i) if (live[i]) run.push_back(i);
+        res.resize(run.size()*count);
+        pool.parallelFor(res.size(), [&](size_t k){
+            res[k] = opp.trial(afters[run[k/count]].swapped(), done + k%count);
+        }, 4);
+        for (size_t k=0; k<res.size(); ++k) {
+            Trial r = res[k];
+            r.points = -r.points; r.value = -r.value; r.cubeful = -r.cubeful;
+            r.probs = flippedProbs(r.probs);
+            record(st[run[k/count]], r);
+            values[run[k/count]].push_back(r.value);
+        }
+        done += count;
+        if (!sequential || done<_opt.minTrials) continue;
+
+        size_t lead = run[0];
+        for (size_t i : run) if (st[i].mean()>st[lead].mean()) lead = i;
+        double worstErr = 0.0;
+        size_t left = 1;
+        for (size_t i : run) {
+            if (i==lead) continue;
+            RolloutStats d;             // paired differences leader - i
+            for (uint64_t t=0; t<done; ++t) d.add(1, values[lead][t] - values[i][t], 0.0);
+            if (_opt.pruneSigmas>0.0 && d.mean() > _opt.pruneSigmas*d.stdErr()) { live[i] = 0; continue; }
+            worstErr = std::max(worstErr, d.stdErr());
+            ++left;
+        }
+        if (left==1 || (_opt.stopStdErr>0.0 && worstErr<_opt.stopStdErr)) break;
+    }
+    return st;
+}
+
+} // namespace BG
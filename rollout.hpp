@@ -0,0 +1,252 @@
+/**
+ * @file rollout.hpp
+ * @brief Monte Carlo rollouts with variance-reduced dice.
+ */
+
+#ifndef ROLLOUT_HPP
+#define ROLLOUT_HPP
+
+#include "search.hpp"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace BG {
+
+/// How dice are drawn after the rotated opening turns.
+enum class DiceMode : uint8_t {
+    Random,         ///< independent pseudo-random dice per trial
+    Stratified,     ///< every block of 36 trials sees each outcome once per turn
+};
+
+/**
+ * @class RolloutDice
+ * @brief Dice for one rollout trial, reproducible from (seed, trial).
+ *
+ * The first @c rotate turns (0..2) are not sampled: trial t plays outcome
+ * t mod 36 on the first turn and (t + t/36) mod 36 on the second, so every
+ * 36 trials cover each first roll once and every 1296 cover each pair of
+ * rolls once. Later turns follow the DiceMode; stratified turns use a
+ * fresh pseudo-random permutation of the 36 outcomes per (turn, block of
+ * 36 trials). Outcomes are ordered (d1, d2) pairs, so non-doubles come up
+ * twice as often as doubles, as with real dice.
+ */
+class RolloutDice {
+public:
+    RolloutDice(DiceMode mode, unsigned rotate, uint64_t seed, uint64_t trial);
+
+    /// Dice for turn @p turn (0 = first roll of the trial); turns are asked for in order.
+    void roll(unsigned turn, int &d1, int &d2);
+
+private:
+    DiceMode _mode;
+    unsigned _rotate;
+    uint64_t _seed, _trial, _rng;
+};
+
+/**
+ * @class CubePolicy
+ * @brief Doubling decisions for one side in a cubeful rollout.
+ *
+ * Both calls see the position with the would-be doubler on roll, before
+ * it rolls, and the cube value before doubling. offer() is only asked
+ * when the doubler has access to the cube (centred or owned).
+ */
+class CubePolicy {
+public:
+    virtual ~CubePolicy() = default;
+
+    /// True to double (offerCube).
+    virtual bool offer(const Position &p, unsigned cube) const = 0;
+
+    /// True to take (takeCube), false to drop (dropCube); the taker is the side not on roll.
+    virtual bool take(const Position &p, unsigned cube) const = 0;
+};
+
+/**
+ * @class ThresholdCubePolicy
+ * @brief Money-game cube play from cubeless equity windows.
+ *
+ * Doubles when the doubler's cubeless equity is in [doublePoint, tooGood)
+ * (above tooGood it plays on for the gammon); takes when the taker's
+ * cubeless equity is at least takePoint.
+ */
+class ThresholdCubePolicy : public CubePolicy {
+public:
+    explicit ThresholdCubePolicy(const Search &search, unsigned plies = 0,
+                                 double doublePoint = 0.40, double takePoint = -0.55, double tooGood = 0.95)
+        : _search(search), _plies(plies), _double(doublePoint), _take(takePoint), _tooGood(tooGood) {}
+
+    bool offer(const Position &p, unsigned) const override {
+        double e = _search.equity(p, _plies);
+        return e>=_double && e<_tooGood;
+    }
+    bool take(const Position &p, unsigned) const override { return -_search.equity(p, _plies) >= _take; }
+
+private:
+    const Search &_search;
+    unsigned _plies;
+    double _double, _take, _tooGood;
+};
+
+/**
+ * @struct RolloutStats
+ * @brief Running totals of trial results; mergeable across threads or hosts.
+ *
+ * Cubeless results are in points per unit cube. Cubeful results are in
+ * points divided by the starting cube value, so they compare directly
+ * with the cubeless figures; without cube policies the two coincide.
+ * Outcome tallies are fractional: a truncated trial adds the evaluator's
+ * probabilities where a finished one adds 1 or 0.
+ */
+struct RolloutStats {
+    uint64_t trials=0;
+    double sum=0.0, sumSq=0.0;      ///< of the (luck-adjusted) cubeless result
+    double cfSum=0.0, cfSumSq=0.0;  ///< of the (luck-adjusted) cubeful result
+    double wins=0, gammons=0, backgammons=0, losses=0, lostGammons=0, lostBackgammons=0;
+    uint64_t doubles=0, drops=0;    ///< trials where the cube was turned / a double was dropped
+    uint64_t truncated=0;           ///< trials scored by the evaluator at the cutoff
+
+    /**
+     * @brief Record one trial.
+     * @param points Cubeless game result for the root side (+ won, - lost, 1..3).
+     * @param value  Scored cubeless result (points less luck when adjusted).
+     * @param cubeful Scored cubeful result.
+     */
+    void add(int points, double value, double cubeful);
+
+    /// Record one truncated trial; @p pr is for the root side at the cutoff.
+    void add(const Probs &pr, double value, double cubeful);
+
+    void merge(const RolloutStats &o);
+
+    double mean() const { return trials ? sum/double(trials) : 0.0; }
+    double cubefulMean() const { return trials ? cfSum/double(trials) : 0.0; }
+
+    /// Standard error of mean().
+    double stdErr() const { return stdErrOf(sum, sumSq); }
+
+    /// Standard error of cubefulMean().
+    double cubefulStdErr() const { return stdErrOf(cfSum, cfSumSq); }
+
+    /// Outcome frequencies for the root side (from the raw results, not adjusted).
+    Probs probs() const;
+
+private:
+    double stdErrOf(double s, double sq) const {
+        if (trials<2) return 0.0;
+        double n = double(trials), var = (sq - s*s/n) / (n-1.0);
+        return var>0.0 ? std::sqrt(var/n) : 0.0;
+    }
+};
+
+/**
+ * @struct RolloutOptions
+ * @brief Rollout settings.
+ */
+struct RolloutOptions {
+    uint64_t trials = 1296;
+    unsigned plies = 0;                     ///< checker play depth (Search::hint)
+    DiceMode dice = DiceMode::Stratified;
+    unsigned rotate = 2;                    ///< opening turns rotated through all outcomes (0..2)
+    bool luckAdjust = false;                ///< subtract evaluator-measured luck from each trial
+    uint64_t seed = 1;
+    unsigned threads = 0;                   ///< 0 = hardware concurrency
+
+    /// Cube policies for the root side and its opponent; null never doubles and always takes.
+    const CubePolicy *cubePolicy[2] = {nullptr, nullptr};
+    unsigned cube = 1;                      ///< starting cube value
+    int cubeOwner = -1;                     ///< -1 centred, 0 root side, 1 opponent
+    bool jacoby = false;                    ///< gammons count only once the cube has been turned
+
+    /// Stop each trial after this many turns and score the evaluator's equity; 0 plays to the end.
+    unsigned truncate = 0;
+
+    // Sequential stopping, checked every @c batch trials once @c minTrials have run.
+    double stopStdErr = 0.0;                ///< stop when every standard error (of differences, for compare()) is below this; 0 = off
+    double pruneSigmas = 0.0;               ///< compare(): drop plays trailing the leader by this many standard errors; 0 = off
+    uint64_t minTrials = 144;
+    uint64_t batch = 144;
+};
+
+/**
+ * @class Rollout
+ * @brief Plays games to the end from a position and averages cubeless and cubeful results.
+ *
+ * Checker plays come from Search::hint(), so a book set on the search is
+ * used for early positions. Results are in points for the root side and
+ * do not depend on the thread count.
+ *
+ * Before each roll the side on roll may double if it has cube access and
+ * its policy says so; a take doubles the cube and hands it to the taker,
+ * a drop settles the cubeful result at the current cube value. The game
+ * is still played out for the cubeless result, so one trial feeds both.
+ *
+ * With @c luckAdjust each turn's luck, the 0-ply equity of the best play
+ * for the roll drawn minus its average over all 36 rolls, is subtracted
+ * from the result (signed for the root side, and scaled by the cube for
+ * the cubeful result while it is open). Luck has zero mean, so the
+ * estimate stays unbiased while most dice noise cancels; it costs one
+ * 0-ply ranking of all 21 rolls per turn.
+ *
+ * With @c truncate a trial still running after that many turns is scored
+ * by the 0-ply evaluation of the position reached, before any cube action
+ * there; the cubeful result then takes the cubeless equity times the cube.
+ * This trades the evaluator's bias for far shorter trials.
+ */
+class Rollout {
+public:
+    Rollout(const Search &search, const RolloutOptions &opt) : _search(search), _opt(opt) {}
+
+    /// Root = the side on roll of @p p, before it rolls.
+    RolloutStats position(const Position &p) const;
+
+    /// Root = the side that just played to @p after (opponent to roll).
+    RolloutStats play(const Position &after) const;
+
+    /**
+     * @brief Trials [@p first, @p first + @p count) of position(); for splitting work.
+     * @param p Position with the root side on roll.
+     */
+    RolloutStats trials(const Position &p, uint64_t first, uint64_t count) const;
+
+    /**
+     * @brief Roll out several plays by the same side on shared dice streams.
+     *
+     * Runs @c batch trials of every play still in the running at a time,
+     * with trial t on the same dice for all of them, so differences are
+     * measured on paired results. After each batch past @c minTrials, a
+     * play whose cubeless mean trails the leader's by more than
+     * @c pruneSigmas standard errors of the paired difference is dropped,
+     * and the rollout ends once one play is left or every difference from
+     * the leader has a standard error below @c stopStdErr. Without either
+     * rule it is play() for each of @p afters.
+     *
+     * @return Stats per play, in the order given; dropped plays have fewer trials.
+     */
+    std::vector<RolloutStats> compare(const std::vector<Position> &afters) const;
+
+    const RolloutOptions &options() const { return _opt; }
+
+private:
+    const Search &_search;
+    RolloutOptions _opt;
+
+    struct Trial { int points; double value, cubeful; bool doubled, dropped, truncated; Probs probs; };
+
+    /// One trial from @p p (root on roll).
+    Trial trial(const Position &p, uint64_t t) const;
+
+    /// Add @p r to @p st.
+    static void record(RolloutStats &st, const Trial &r);
+
+    /// Options for rolling out from the opponent's side: cube roles swapped.
+    RolloutOptions swappedOptions() const;
+
+    /// True once the stopping rule is met by @p st after a batch.
+    bool precise(const RolloutStats &st) const;
+};
+
+} // namespace BG
+
+#endif // ROLLOUT_HPP
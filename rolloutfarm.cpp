@@ -0,0 +1,495 @@
+/**
+ * @file rolloutfarm.cpp
+ * @brief Job and stats encoding, socket framing, worker loop and chunk scheduling with checkpoints.
+ */
+
+#include "rolloutfarm.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace BG {
+
+namespace {
+
+constexpr char     JOB_VERSION       = 1;
+constexpr char     CHECKPOINT_MAGIC[4] = {'B','G','R','C'};
+constexpr uint32_t CHECKPOINT_VERSION  = 1;
+constexpr uint32_t MAX_FRAME         = 1u << 20;
+constexpr unsigned WORKER_IDLE       = 3600;    ///< seconds a worker waits on a silent coordinator
+
+// Frame types: coordinator -> worker, then worker -> coordinator.
+constexpr char FRAME_JOB='J', FRAME_CHUNK='C', FRAME_OK='O', FRAME_STATS='S', FRAME_ERROR='E';
+
+// ----- binary fields ---------------------------------------------------------
+
+template <class T> void put(std::string &out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof v);
+}
+
+struct Reader {
+    std::string_view in;
+    const char *what;
+    template <class T> T get() {
+        if (in.size()<sizeof(T)) throw std::runtime_error(std::string(what) + ": truncated");
+        T v;
+        std::memcpy(&v, in.data(), sizeof v);
+        in.remove_prefix(sizeof v);
+        return v;
+    }
+};
+
+// ----- sockets ---------------------------------------------------------------
+
+struct Fd {
+    int fd = -1;
+    explicit Fd(int f = -1) : fd(f) {}
+    ~Fd() { if (fd>=0) ::close(fd); }
+    Fd(const Fd&) = delete;
+    Fd& operator=(const Fd&) = delete;
+};
+
+/// Make blocking sends and receives on @p fd fail with EAGAIN after @p secs (0 = never).
+void setTimeouts(int fd, unsigned secs) {
+    timeval tv{};
+    tv.tv_sec = time_t(secs);
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+}
+
+/// Socket bound (@p listening) or connected to @p address; see serveRollouts(). A connect gives up after @p timeout seconds.
+int openSocket(const std::string &address, bool listening, unsigned timeout = 0) {
+    if (address.find('/')!=std::string::npos) {
+        sockaddr_un sa{};
+        if (address.size()>=sizeof sa.sun_path) throw std::runtime_error(address + ": socket path too long");
+        sa.sun_family = AF_UNIX;
+        std::memcpy(sa.sun_path, address.c_str(), address.size()+1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd<0) throw std::runtime_error(address + ": " + std::strerror(errno));
+        if (listening) ::unlink(address.c_str());
+        else setTimeouts(fd, timeout);
+        int rc = listening ? ::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof sa)
+                           : ::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof sa);
+        if (rc!=0 || (listening && ::listen(fd, 16)!=0)) {
+            int e = errno;
+            ::close(fd);
+            throw std::runtime_error(address + ": " + std::strerror(e));
+        }
+        return fd;
+    }
+
+    // Listening defaults to loopback: serving other hosts takes an explicit "0.0.0.0:port".
+    std::string host = listening ? "127.0.0.1" : "localhost", port = address;
+    if (auto colon = address.rfind(':'); colon!=std::string::npos) {
+        host = address.substr(0, colon);
+        port = address.substr(colon+1);
+    }
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (int rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &res); rc!=0)
+        throw std::runtime_error(address + ": " + ::gai_strerror(rc));
+    int fd = -1, err = 0;
+    for (addrinfo *ai = res; ai && fd<0; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd<0) { err = errno; continue; }
+        int one = 1;
+        if (listening) ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+        else setTimeouts(fd, timeout);
+        int rc = listening ? ::bind(fd, ai->ai_addr, ai->ai_addrlen) : ::connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc!=0 || (listening && ::listen(fd, 16)!=0)) { err = errno; ::close(fd); fd = -1; }
+    }
+    ::freeaddrinfo(res);
+    if (fd<0) throw std::runtime_error(address + ": " + std::strerror(err));
+    return fd;
+}
+
+void sendAll(int fd, const char *p, size_t n) {
+    while (n) {
+        ssize_t k = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (k<0 && errno==EINTR) continue;
+        if (k<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) throw std::runtime_error("send: timed out");
+        if (k<=0) throw std::runtime_error(std::string("send: ") + std::strerror(errno));
+        p += k; n -= size_t(k);
+    }
+}
+
+/// False on a clean end of stream before the first byte.
+bool recvAll(int fd, char *p, size_t n) {
+    for (size_t got=0; got<n; ) {
+        ssize_t k = ::recv(fd, p+got, n-got, 0);
+        if (k<0 && errno==EINTR) continue;
+        if (k<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) throw std::runtime_error("recv: timed out");
+        if (k<0) throw std::runtime_error(std::string("recv: ") + std::strerror(errno));
+        if (k==0) {
+            if (got==0) return false;
+            throw std::runtime_error("recv: connection closed mid-frame");
+        }
+        got += size_t(k);
+    }
+    return true;
+}
+
+// A frame is u32 length (type byte + payload), the type byte, then the payload.
+void sendFrame(int fd, char type, std::string_view payload) {
+    std::string f;
+    put(f, uint32_t(payload.size()+1));
+    f += type;
+    f += payload;
+    sendAll(fd, f.data(), f.size());
+}
+
+bool recvFrame(int fd, char &type, std::string &payload) {
+    uint32_t len;
+    if (!recvAll(fd, reinterpret_cast<char*>(&len), sizeof len)) return false;
+    if (len<1 || len>MAX_FRAME) throw std::runtime_error("recv: bad frame length");
+    std::string f(len, '\0');
+    if (!recvAll(fd, f.data(), len)) throw std::runtime_error("recv: connection closed mid-frame");
+    type = f[0];
+    payload.assign(f, 1);
+    return true;
+}
+
+/// Next frame, which must be of type @p want; a worker's error frame becomes an exception.
+std::string expectFrame(int fd, char want) {
+    char type;
+    std::string payload;
+    if (!recvFrame(fd, type, payload)) throw std::runtime_error("worker closed the connection");
+    if (type==FRAME_ERROR) throw std::runtime_error("worker: " + payload);
+    if (type!=want) throw std::runtime_error("unexpected frame from worker");
+    return payload;
+}
+
+// ----- checkpoints -------------------------------------------------------------
+
+void saveCheckpoint(const std::string &path, const std::string &job, const std::vector<char> &done, const RolloutStats &st) {
+    std::string out(CHECKPOINT_MAGIC, 4);
+    put(out, CHECKPOINT_VERSION);
+    put(out, uint32_t(job.size()));
+    out += job;
+    put(out, uint64_t(done.size()));
+    out.append(done.data(), done.size());
+    std::string stats = encodeStats(st);
+    put(out, uint32_t(stats.size()));
+    out += stats;
+
+    std::string partial = path + ".partial";
+    {
+        std::ofstream f(partial, std::ios::binary | std::ios::trunc);
+        f.write(out.data(), std::streamsize(out.size()));
+        f.flush();
+        if (!f) throw std::runtime_error(partial + ": write failed");
+    }
+    std::filesystem::rename(partial, path);
+}
+
+/// Load @p path into @p done and @p st; false if it does not exist.
+bool loadCheckpoint(const std::string &path, const std::string &job, std::vector<char> &done, RolloutStats &st) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    std::string bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    Reader r{bytes, "checkpoint"};
+    if (bytes.size()<4 || std::memcmp(bytes.data(), CHECKPOINT_MAGIC, 4)!=0)
+        throw std::runtime_error(path + ": not a rollout checkpoint");
+    r.in.remove_prefix(4);
+    if (r.get<uint32_t>()!=CHECKPOINT_VERSION) throw std::runtime_error(path + ": unsupported checkpoint version");
+    uint32_t jobLen = r.get<uint32_t>();
+    if (r.in.substr(0, jobLen)!=job || r.in.size()<jobLen)
+        throw std::runtime_error(path + ": checkpoint is for a different rollout");
+    r.in.remove_prefix(jobLen);
+    uint64_t chunks = r.get<uint64_t>();
+    if (chunks!=done.size() || r.in.size()<chunks) throw std::runtime_error(path + ": corrupt checkpoint");
+    std::memcpy(done.data(), r.in.data(), chunks);
+    r.in.remove_prefix(chunks);
+    uint32_t statsLen = r.get<uint32_t>();
+    if (r.in.size()!=statsLen) throw std::runtime_error(path + ": corrupt checkpoint");
+    st = decodeStats(r.in);
+    return true;
+}
+
+/// Why a worker should refuse @p j, or an empty string if it can run it.
+std::string checkJob(const RolloutJob &j) {
+    const Position &p = j.position;
+    unsigned total[2] = {p.off[0], p.off[1]};
+    for (int s=0; s<2; ++s)
+        for (uint8_t c : p.checkers[s]) total[s] += c;
+    if (total[0]!=total[1] || total[0]==0 || total[0]>15) return "position does not have 1-15 checkers a side";
+    for (int i=0; i<24; ++i)
+        if (p.checkers[0][size_t(i)] && p.checkers[1][size_t(23-i)]) return "position has both sides on one point";
+    if (p.finished(0) || p.finished(1)) return "position is already over";
+    if (j.options.dice!=DiceMode::Random && j.options.dice!=DiceMode::Stratified) return "unknown dice mode";
+    if (j.options.rotate>2) return "rotate is more than 2 turns";
+    if (j.options.cube==0 || (j.options.cube & (j.options.cube-1))) return "cube is not a power of two";
+    if (j.options.cubeOwner<-1 || j.options.cubeOwner>1) return "bad cube owner";
+    return {};
+}
+
+} // namespace
+
+// ===== Encodings ===============================================================
+
+std::string RolloutJob::encode() const {
+    std::string out;
+    out += JOB_VERSION;
+    for (const auto &side : position.checkers) out.append(reinterpret_cast<const char*>(side.data()), side.size());
+    out.append(reinterpret_cast<const char*>(position.off.data()), position.off.size());
+    put(out, options.trials);
+    put(out, uint32_t(options.plies));
+    put(out, uint8_t(options.dice));
+    put(out, uint32_t(options.rotate));
+    put(out, uint8_t(options.luckAdjust));
+    put(out, options.seed);
+    put(out, uint32_t(options.cube));
+    put(out, int32_t(options.cubeOwner));
+    put(out, uint8_t(options.jacoby));
+    put(out, uint32_t(options.truncate));
+    put(out, uint8_t(cubeful));
+    put(out, evaluator);
+    put(out, chunk);
+    return out;
+}
+
+RolloutJob RolloutJob::decode(std::string_view bytes) {
+    Reader r{bytes, "rollout job"};
+    if (r.get<char>()!=JOB_VERSION) throw std::runtime_error("rollout job: unsupported version");
+    RolloutJob j;
+    for (auto &side : j.position.checkers)
+        for (auto &c : side) c = r.get<uint8_t>();
+    for (auto &o : j.position.off) o = r.get<uint8_t>();
+    j.options.trials = r.get<uint64_t>();
+    j.options.plies = r.get<uint32_t>();
+    j.options.dice = DiceMode(r.get<uint8_t>());
+    j.options.rotate = r.get<uint32_t>();
+    j.options.luckAdjust = r.get<uint8_t>()!=0;
+    j.options.seed = r.get<uint64_t>();
+    j.options.cube = r.get<uint32_t>();
+    j.options.cubeOwner = r.get<int32_t>();
+    j.options.jacoby = r.get<uint8_t>()!=0;
+    j.options.truncate = r.get<uint32_t>();
+    j.cubeful = r.get<uint8_t>()!=0;
+    j.evaluator = r.get<uint64_t>();
+    j.chunk = r.get<uint64_t>();
+    if (!r.in.empty()) throw std::runtime_error("rollout job: trailing bytes");
+    if (j.chunk==0) throw std::runtime_error("rollout job: empty chunks");
+    return j;
+}
+
+std::string encodeStats(const RolloutStats &st) {
+    std::string out;
+    put(out, st.trials);
+    for (double v : {st.sum, st.sumSq, st.cfSum, st.cfSumSq,
+                     st.wins, st.gammons, st.backgammons, st.losses, st.lostGammons, st.lostBackgammons})
+        put(out, v);
+    put(out, st.doubles);
+    put(out, st.drops);
+    put(out, st.truncated);
+    return out;
+}
+
+RolloutStats decodeStats(std::string_view bytes) {
+    Reader r{bytes, "rollout stats"};
+    RolloutStats st;
+    st.trials = r.get<uint64_t>();
+    for (double *v : {&st.sum, &st.sumSq, &st.cfSum, &st.cfSumSq,
+                      &st.wins, &st.gammons, &st.backgammons, &st.losses, &st.lostGammons, &st.lostBackgammons})
+        *v = r.get<double>();
+    st.doubles = r.get<uint64_t>();
+    st.drops = r.get<uint64_t>();
+    st.truncated = r.get<uint64_t>();
+    if (!r.in.empty()) throw std::runtime_error("rollout stats: trailing bytes");
+    return st;
+}
+
+// ===== Worker ==================================================================
+
+void serveRollouts(const std::string &address, const Search &search, unsigned threads,
+                   const std::function<void(const std::string&)> &log) {
+    Fd listener(openSocket(address, true));
+    const uint64_t fingerprint = weightsFingerprint(search.evaluator());
+    const ThresholdCubePolicy policy(search);
+    if (log) log("listening on " + address);
+
+    for (;;) {
+        Fd conn(::accept(listener.fd, nullptr, nullptr));
+        if (conn.fd<0) {
+            if (errno==EINTR || errno==ECONNABORTED) continue;
+            throw std::runtime_error(std::string("accept: ") + std::strerror(errno));
+        }
+        // Connections are served one at a time, so a coordinator that hangs must not hold the worker.
+        setTimeouts(conn.fd, WORKER_IDLE);
+        uint64_t chunks = 0;
+        try {
+            bool haveJob = false;
+            RolloutJob job;
+            char type;
+            std::string payload;
+            while (recvFrame(conn.fd, type, payload)) {
+                if (type==FRAME_JOB) {
+                    std::string why;
+                    try {
+                        job = RolloutJob::decode(payload);
+                        why = checkJob(job);
+                    } catch (const std::exception &ex) {
+                        why = ex.what();
+                    }
+                    if (!why.empty()) {
+                        sendFrame(conn.fd, FRAME_ERROR, "bad job: " + why);
+                        break;
+                    }
+                    if (job.evaluator!=fingerprint) {
+                        sendFrame(conn.fd, FRAME_ERROR, "evaluator weights differ from the coordinator's");
+                        break;
+                    }
+                    job.options.threads = threads;
+                    job.options.stopStdErr = job.options.pruneSigmas = 0.0;
+                    job.options.cubePolicy[0] = job.options.cubePolicy[1] = job.cubeful ? &policy : nullptr;
+                    haveJob = true;
+                    sendFrame(conn.fd, FRAME_OK, {});
+                } else if (type==FRAME_CHUNK && haveJob) {
+                    Reader r{payload, "chunk"};
+                    uint64_t first = r.get<uint64_t>(), count = r.get<uint64_t>();
+                    if (count==0 || count>job.chunk || first>=job.options.trials || count>job.options.trials-first) {
+                        sendFrame(conn.fd, FRAME_ERROR, "chunk outside the job's trials");
+                        break;
+                    }
+                    RolloutStats st = Rollout(search, job.options).trials(job.position, first, count);
+                    sendFrame(conn.fd, FRAME_STATS, encodeStats(st));
+                    ++chunks;
+                } else {
+                    sendFrame(conn.fd, FRAME_ERROR, "unexpected frame");
+                    break;
+                }
+            }
+            if (log) log("connection closed after " + std::to_string(chunks) + " chunks");
+        } catch (const std::exception &ex) {
+            if (log) log(std::string("connection dropped: ") + ex.what());
+        }
+    }
+}
+
+// ===== Coordinator =============================================================
+
+RolloutStats farmRollout(const RolloutJob &job, const std::vector<std::string> &workers,
+                         const std::string &checkpoint,
+                         const std::function<void(const FarmProgress&)> &progress,
+                         unsigned timeout) {
+    if (job.chunk==0) throw std::invalid_argument("farmRollout: empty chunks");
+    const std::string jobBytes = job.encode();
+    const uint64_t trials = job.options.trials;
+    const uint64_t chunks = (trials + job.chunk - 1) / job.chunk;
+
+    std::vector<char> done(chunks, 0);
+    RolloutStats total;
+    if (!checkpoint.empty()) loadCheckpoint(checkpoint, jobBytes, done, total);
+    std::deque<uint64_t> queue;
+    for (uint64_t c=0; c<chunks; ++c) if (!done[c]) queue.push_back(c);
+
+    std::mutex mu;
+    std::condition_variable cv;
+    uint64_t left = queue.size(), inFlight = 0;
+    unsigned alive = 0;
+    std::string lastError;
+    std::exception_ptr fatal;
+
+    auto report = [&]{
+        if (!progress) return;
+        FarmProgress fp;
+        fp.chunks = chunks;
+        fp.done = chunks - left;
+        fp.workers = alive;
+        fp.stats = total;
+        progress(fp);
+    };
+
+    // Connect up front so an unreachable address is known before any work starts.
+    std::vector<std::unique_ptr<Fd>> conns;
+    std::vector<std::string> names;
+    for (const std::string &w : workers) {
+        try {
+            auto c = std::make_unique<Fd>(openSocket(w, false, timeout));
+            sendFrame(c->fd, FRAME_JOB, jobBytes);
+            expectFrame(c->fd, FRAME_OK);
+            conns.push_back(std::move(c));
+            names.push_back(w);
+        } catch (const std::exception &ex) {
+            lastError = w + ": " + ex.what();
+        }
+    }
+    if (left && conns.empty()) throw std::runtime_error("no rollout worker available (" + lastError + ")");
+    alive = unsigned(conns.size());
+    report();
+
+    auto work = [&](int fd, const std::string &name) {
+        std::unique_lock<std::mutex> lk(mu);
+        for (;;) {
+            // Wait while other workers hold the last chunks: one may fail and hand its chunk back.
+            cv.wait(lk, [&]{ return !queue.empty() || left==0 || inFlight==0; });
+            if (queue.empty()) break;
+            const uint64_t c = queue.front();
+            queue.pop_front();
+            ++inFlight;
+            lk.unlock();
+
+            std::string stats;
+            try {
+                std::string req;
+                put(req, c*job.chunk);
+                put(req, std::min(job.chunk, trials - c*job.chunk));
+                sendFrame(fd, FRAME_CHUNK, req);
+                stats = expectFrame(fd, FRAME_STATS);
+            } catch (const std::exception &ex) {
+                lk.lock();
+                queue.push_front(c);
+                --inFlight; --alive;
+                lastError = name + ": " + ex.what();
+                cv.notify_all();
+                return;
+            }
+
+            lk.lock();
+            --inFlight;
+            try {
+                total.merge(decodeStats(stats));
+                done[c] = 1;
+                --left;
+                if (!checkpoint.empty()) saveCheckpoint(checkpoint, jobBytes, done, total);
+                report();
+            } catch (...) {
+                // Not the worker's fault: stop handing out chunks and rethrow after the join.
+                if (!fatal) fatal = std::current_exception();
+                queue.clear();
+            }
+            cv.notify_all();
+        }
+        --alive;
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i=0; i<conns.size(); ++i) threads.emplace_back(work, conns[i]->fd, names[i]);
+    for (auto &t : threads) t.join();
+    if (fatal) std::rethrow_exception(fatal);
+
+    if (left) {
+        std::string where = checkpoint.empty() ? "" : "; progress is saved in " + checkpoint;
+        throw std::runtime_error("all rollout workers failed with " + std::to_string(left) + " of "
+                                 + std::to_string(chunks) + " chunks left (" + lastError + ")" + where);
+    }
+    if (!checkpoint.empty() && chunks==0) saveCheckpoint(checkpoint, jobBytes, done, total);
+    return total;
+}
+
+} // namespace BG
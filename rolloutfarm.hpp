@@ -0,0 +1,96 @@
+/**
+ * @file rolloutfarm.hpp
+ * @brief Rollouts split into chunks of trials, run by worker processes over sockets, with checkpoints.
+ */
+
+#ifndef ROLLOUTFARM_HPP
+#define ROLLOUTFARM_HPP
+
+#include "rollout.hpp"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @struct RolloutJob
+ * @brief Everything a worker needs to run any chunk of one position rollout.
+ *
+ * Trials depend only on (seed, trial number), so chunks can run anywhere,
+ * in any order, and merge to the totals of one local rollout up to
+ * floating-point rounding (sums are added in completion order). Cube
+ * policies cannot be sent: with @c cubeful each worker gives both sides
+ * a 0-ply ThresholdCubePolicy of its own search. The stopping options and
+ * the thread count are not sent either; a chunk always runs in full.
+ */
+struct RolloutJob {
+    Position position;          ///< root side on roll
+    RolloutOptions options;
+    bool cubeful = false;
+    uint64_t evaluator = 0;     ///< weightsFingerprint() the workers must match
+    uint64_t chunk = 1296;      ///< trials per work unit; a multiple of 36 keeps dice strata whole
+
+    /// Compact binary form (host byte order); also identifies the job in checkpoints.
+    std::string encode() const;
+
+    /// @throws std::runtime_error on a malformed encoding.
+    static RolloutJob decode(std::string_view bytes);
+};
+
+/// Binary form of @p st for the wire and checkpoints.
+std::string encodeStats(const RolloutStats &st);
+
+/// @throws std::runtime_error on a malformed encoding.
+RolloutStats decodeStats(std::string_view bytes);
+
+/**
+ * @brief Run a rollout worker on @p address until the process is killed.
+ *
+ * The address is a Unix socket path when it contains '/', otherwise
+ * "[host:]port" for TCP. Connections are served one at a time: a job,
+ * then any number of chunks, each answered with its stats. Chunks run on
+ * @p threads threads with @p search, which must stay alive. A job with an
+ * illegal position or options, or a chunk outside its trials, is refused
+ * with an error; a connection silent for an hour is dropped.
+ *
+ * @param log Called with one line per connection and error (may be empty).
+ * @throws std::runtime_error if the address cannot be listened on.
+ */
+void serveRollouts(const std::string &address, const Search &search, unsigned threads,
+                   const std::function<void(const std::string&)> &log = {});
+
+/**
+ * @struct FarmProgress
+ * @brief State of farmRollout(), reported after each chunk.
+ */
+struct FarmProgress {
+    uint64_t chunks=0, done=0;  ///< chunks in the job / merged so far (including resumed ones)
+    unsigned workers=0;         ///< connections still working
+    RolloutStats stats;         ///< merged so far
+};
+
+/**
+ * @brief Farm a rollout out to @p workers (serveRollouts() addresses) and merge the results.
+ *
+ * Each worker connection pulls the next unfinished chunk until none are
+ * left. A chunk whose worker fails, or does not answer within @p timeout
+ * seconds (connecting, or running one chunk), goes back to the queue and
+ * the worker is dropped. After every merged chunk the progress is written to
+ * @p checkpoint (when not empty) through a temporary file and a rename;
+ * if the checkpoint already exists for the same job, finished chunks are
+ * skipped, so an interrupted rollout resumes where it stopped.
+ *
+ * @throws std::runtime_error if the checkpoint belongs to another job, no
+ *         worker can be reached, or all of them fail with chunks left
+ *         (the checkpoint keeps what was done).
+ */
+RolloutStats farmRollout(const RolloutJob &job, const std::vector<std::string> &workers,
+                         const std::string &checkpoint = {},
+                         const std::function<void(const FarmProgress&)> &progress = {},
+                         unsigned timeout = 600);
+
+} // namespace BG
+
+#endif // ROLLOUTFARM_HPP
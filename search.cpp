@@ -0,0 +1,134 @@
+/**
+ * @file search.cpp
+ * @brief Search implementation.
+ */
+
+#include "search.hpp"
+#include "dice.hpp"
+#include "evalcache.hpp"
+#include "hypergammon.hpp"
+#include "openingbook.hpp"
+#include <algorithm>
+
+namespace BG {
+
+double Search::playEquity(const Position &after, unsigned plies) const {
+    bool stopped = false;
+    return playEquity(after, plies, {}, stopped);
+}
+
+double Search::equity(const Position &p, unsigned plies) const {
+    bool stopped = false;
+    return equity(p, plies, {}, stopped);
+}
+
+double Search::playEquity(const Position &after, unsigned plies,
+                          const std::function<bool()> &stop, bool &stopped) const {
+    if (after.finished(0)) return double(after.winMultiplier(0));
+    return -equity(after.swapped(), plies, stop, stopped);
+}
+
+double Search::equity(const Position &p, unsigned plies,
+                      const std::function<bool()> &stop, bool &stopped) const {
+    if (plies==0) return _ev.evaluate(p).equity();
+    // Prune only shapes the search below the first ply.
+    const unsigned prune = plies>1 ? _prune : 0;
+    double cached;
+    if (_cache && _cache->find(p, plies, prune, cached)) return cached;
+
+    std::vector<Candidate> cands;
+    std::vector<std::pair<double, size_t>> order;
+    double sum = 0.0;
+    for (const Roll &r : kRolls) {
+        // A one-ply roll is a few static evaluations; deeper ones can take seconds.
+        if (plies>1 && stop && stop()) stopped = true;
+        if (stopped) return 0.0;
+        generatePlays(p, r.hi, r.lo, cands);
+        double best;
+        if (cands.size()==1) {
+            best = playEquity(cands[0].after, plies-1, stop, stopped);
+        } else {
+            order.clear();
+            for (size_t i=0; i<cands.size(); ++i) order.emplace_back(playEquity(cands[i].after, 0), i);
+            if (plies==1) {
+                best = std::max_element(order.begin(), order.end())->first;
+            } else {
+                size_t keep = std::min<size_t>(_prune, order.size());
+                std::partial_sort(order.begin(), order.begin()+keep, order.end(),
+                                  [](auto &a, auto &b){ return a.first > b.first; });
+                best = -1e9;
+                for (size_t k=0; k<keep && !stopped; ++k)
+                    best = std::max(best, playEquity(cands[order[k].second].after, plies-1, stop, stopped));
+            }
+        }
+        if (stopped) return 0.0;
+        sum += best * r.weight;
+    }
+    if (_cache) _cache->store(p, plies, prune, sum / 36.0);
+    return sum / 36.0;
+}
+
+void Search::rankPlays(const Position &p, int d1, int d2, unsigned plies, std::vector<ScoredPlay> &out) const {
+    std::vector<Candidate> cands;
+    generatePlays(p, d1, d2, cands);
+    out.clear();
+    out.reserve(cands.size());
+    for (Candidate &c : cands) {
+        double e = playEquity(c.after, 0);
+        out.push_back({std::move(c), e, 0});
+    }
+    auto better = [](const ScoredPlay &a, const ScoredPlay &b){ return a.equity > b.equity; };
+    std::sort(out.begin(), out.end(), better);
+    if (plies==0 || out.size()<2) return;
+
+    size_t keep = std::min<size_t>(_prune, out.size());
+    for (size_t k=0; k<keep; ++k) {
+        out[k].equity = playEquity(out[k].cand.after, plies);
+        out[k].plies = plies;
+    }
+    std::stable_sort(out.begin(), out.begin()+keep, better);
+}
+
+void Search::hint(const Position &p, int d1, int d2, unsigned plies, size_t n, std::vector<ScoredPlay> &out) const {
+    if (!(_exact && _exact->rankPlays(p, d1, d2, out))
+        && !(_book && _book->plies()>=plies && n<=BookSlot::kPlays && _book->lookup(p, d1, d2, out)))
+        rankPlays(p, d1, d2, plies, out);
+    if (out.size()>n) out.resize(n);
+}
+
+unsigned Search::deepen(const Position &p, int d1, int d2, unsigned maxPlies, size_t n,
+                        const std::function<bool(const std::vector<ScoredPlay>&)> &report,
+                        const std::function<bool()> &stop) const {
+    std::vector<ScoredPlay> out, best;
+    auto send = [&]{
+        best.assign(out.begin(), out.begin() + std::min(n, out.size()));
+        return report(best);
+    };
+    if ((_exact && _exact->rankPlays(p, d1, d2, out))
+        || (_book && _book->plies()>=maxPlies && n<=BookSlot::kPlays && _book->lookup(p, d1, d2, out))) {
+        send();
+        return out.empty() ? 0 : out.front().plies;
+    }
+
+    rankPlays(p, d1, d2, 0, out);
+    if (!send() || out.size()<2) return 0;
+    auto better = [](const ScoredPlay &a, const ScoredPlay &b){ return a.equity > b.equity; };
+    const size_t keep = std::min<size_t>(_prune, out.size());
+    std::vector<ScoredPlay> pass;
+    for (unsigned plies=1; plies<=maxPlies; ++plies) {
+        pass.assign(out.begin(), out.begin()+keep);
+        bool stopped = false;
+        for (ScoredPlay &sp : pass) {
+            if (stop && stop()) return plies-1;
+            sp.equity = playEquity(sp.cand.after, plies, stop, stopped);
+            if (stopped) return plies-1;
+            sp.plies = plies;
+        }
+        std::stable_sort(pass.begin(), pass.end(), better);
+        std::copy(pass.begin(), pass.end(), out.begin());
+        if (!send()) return plies;
+    }
+    return maxPlies;
+}
+
+} // namespace BG
@@ -0,0 +1,120 @@
+/**
+ * @file search.hpp
+ * @brief Expectimax n-ply search over Evaluator, with forward pruning.
+ */
+
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include "evaluator.hpp"
+#include "movegen.hpp"
+#include <functional>
+#include <vector>
+
+namespace BG {
+
+class EvalCache;
+class HyperTable;
+class OpeningBook;
+
+/**
+ * @struct ScoredPlay
+ * @brief A candidate play with its equity for the mover.
+ */
+struct ScoredPlay {
+    Candidate cand;
+    double equity=0.0;
+    unsigned plies=0;       ///< depth the equity was computed at
+};
+
+/**
+ * @class Search
+ * @brief Cubeless equity by averaging over the 21 rolls and taking the best play.
+ *
+ * Depth 0 is the static evaluation. At depth n>0 each roll's plays are
+ * screened at depth 0 and only the best @c prune are searched deeper.
+ * Equities are in points per unit cube from the perspective stated on each
+ * call; finished games score their exact win multiplier.
+ */
+class Search {
+public:
+    explicit Search(const Evaluator &ev, unsigned prune = 8) : _ev(ev), _prune(prune) {}
+
+    /// Equity for the side on roll of @p p before it rolls.
+    double equity(const Position &p, unsigned plies) const;
+
+    /// Equity for the mover of having played to @p after (opponent now to roll).
+    double playEquity(const Position &after, unsigned plies) const;
+
+    /**
+     * @brief Score every legal play of (@p d1, @p d2), best first.
+     *
+     * All plays are scored at depth 0; the best @c prune are rescored at
+     * @p plies and the list is re-sorted.
+     */
+    void rankPlays(const Position &p, int d1, int d2, unsigned plies, std::vector<ScoredPlay> &out) const;
+
+    /**
+     * @brief The best @p n plays of (@p d1, @p d2), best first, for bots and hints.
+     *
+     * Answered exactly from the solved table when one is set and covers the
+     * position; else from the opening book when one is set, it holds the
+     * position at @p plies or deeper and @p n is no more than the
+     * BookSlot::kPlays plays it stores; otherwise by rankPlays().
+     */
+    void hint(const Position &p, int d1, int d2, unsigned plies, size_t n, std::vector<ScoredPlay> &out) const;
+
+    /**
+     * @brief Anytime hint: rank the plays at 0, 1, ... @p maxPlies plies, reporting each finished depth.
+     *
+     * Each pass rescores the best @c prune plays of depth 0 and re-sorts
+     * them, so the ranking reported at depth d is rankPlays() at d. A table
+     * or book answer (as in hint(), the book only when it is at least
+     * @p maxPlies deep and stores @p n plays) is final and reported alone. @p stop is polled
+     * before each play and, inside the search, before each roll two or
+     * more plies from the leaves, so even a 3-ply pass yields within about
+     * one 1-ply search; a stop abandons the pass in progress.
+     *
+     * @param report Gets the best @p n plays after each depth; returns false to stop.
+     * @return The deepest depth reported.
+     */
+    unsigned deepen(const Position &p, int d1, int d2, unsigned maxPlies, size_t n,
+                    const std::function<bool(const std::vector<ScoredPlay>&)> &report,
+                    const std::function<bool()> &stop = {}) const;
+
+    /// Book consulted by hint(); nullptr (the default) disables it. Not owned.
+    void setBook(const OpeningBook *book) { _book = book; }
+    const OpeningBook *book() const { return _book; }
+
+    /// Solved few-checker table consulted first by hint(); nullptr (the default) disables it. Not owned.
+    void setExact(const HyperTable *table) { _exact = table; }
+    const HyperTable *exact() const { return _exact; }
+
+    /**
+     * @brief Persistent store of searched equities; nullptr (the default) disables it. Not owned.
+     *
+     * equity() at one ply or more looks the position up first and stores
+     * what it computes, so every caller (rankPlays(), hints, rollouts)
+     * reuses results from other threads, processes and earlier runs. The
+     * cache must have been opened for this search's evaluator.
+     */
+    void setCache(EvalCache *cache) { _cache = cache; }
+    EvalCache *cache() const { return _cache; }
+
+    const Evaluator &evaluator() const { return _ev; }
+
+private:
+    /// equity() / playEquity() that give up, setting @p stopped, once @p stop returns true; nothing is cached then.
+    double equity(const Position &p, unsigned plies, const std::function<bool()> &stop, bool &stopped) const;
+    double playEquity(const Position &after, unsigned plies, const std::function<bool()> &stop, bool &stopped) const;
+
+    const Evaluator &_ev;
+    unsigned _prune;
+    const OpeningBook *_book = nullptr;
+    const HyperTable *_exact = nullptr;
+    EvalCache *_cache = nullptr;
+};
+
+} // namespace BG
+
+#endif // SEARCH_HPP
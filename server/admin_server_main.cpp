@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <grpcpp/grpcpp.h>
@@ -10,20 +11,30 @@ int main(int argc, char** argv) {
   std::string addr = "0.0.0.0:50051";
   if (argc >= 2) addr = argv[1];
 
-  BG::Logger logger{"logs/admin-server.log"};
-  BG::AuthManager auth;
-  BG::MatchRegistry registry(logger);
+  try {
+    BG::Logger logger{"logs/admin-server.log"};
+    // Accounts persist in BG_ADMIN_USERS (default users.db); unknown users
+    // are registered on their first login.
+    BG::AuthOptions auth_opt;
+    const char* users = std::getenv("BG_ADMIN_USERS");
+    auth_opt.store_path = users ? users : "users.db";
+    BG::AuthManager auth(auth_opt);
+    BG::MatchRegistry registry(logger);
 
-  BG::AuthServiceImpl  auth_service(auth, logger);
-  BG::MatchServiceImpl match_service(registry, logger);
+    BG::AuthServiceImpl  auth_service(auth, logger);
+    BG::MatchServiceImpl match_service(registry, logger);
 
-  grpc::ServerBuilder builder;
-  builder.AddListeningPort(addr, grpc::InsecureServerCredentials());
-  builder.RegisterService(&auth_service);
-  builder.RegisterService(&match_service);
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(addr, grpc::InsecureServerCredentials());
+    builder.RegisterService(&auth_service);
+    builder.RegisterService(&match_service);
 
-  std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
-  std::cout << "bg_admin listening on " << addr << "\n";
-  server->Wait();
+    std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    std::cout << "bg_admin listening on " << addr << "\n";
+    server->Wait();
+  } catch (const std::exception& ex){
+    std::cerr << "bg_admin: " << ex.what() << "\n";
+    return 1;
+  }
   return 0;
 }
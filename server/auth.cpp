@@ -1,17 +1,283 @@
 #include "auth.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
 
 namespace BG {
 
-bool AuthManager::login(const std::string& user, const std::string& pass, User& out) {
-  if (user.empty() || pass.empty()) return false; // stub rule
+namespace {
+
+constexpr unsigned kScryptR = 8, kScryptP = 1;
+constexpr size_t kSaltBytes = 16, kHashBytes = 32;
+
+std::string randomBytes(size_t n){
+  std::string s(n, '\0');
+  if (RAND_bytes(reinterpret_cast<unsigned char*>(s.data()), int(n)) != 1)
+    throw std::runtime_error("auth: no random bytes");
+  return s;
+}
+
+std::string toHex(const std::string& s){
+  static const char digits[] = "0123456789abcdef";
+  std::string out;
+  for (unsigned char c : s){ out += digits[c >> 4]; out += digits[c & 15]; }
+  return out;
+}
+
+bool fromHex(const std::string& h, std::string& out){
+  auto nib = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  };
+  if (h.size() % 2) return false;
+  out.clear();
+  for (size_t i = 0; i < h.size(); i += 2){
+    int hi = nib(h[i]), lo = nib(h[i+1]);
+    if (hi < 0 || lo < 0) return false;
+    out += char(hi << 4 | lo);
+  }
+  return true;
+}
+
+bool validName(const std::string& user){
+  if (user.empty() || user.size() > 64) return false;
+  for (unsigned char c : user) if (c <= ' ' || c == 0x7f) return false;
+  return true;
+}
+
+} // namespace
+
+const char* loginResultText(LoginResult r){
+  switch (r){
+    case LoginResult::Ok:              return "ok";
+    case LoginResult::BadCredentials:  return "bad credentials";
+    case LoginResult::AlreadyLoggedIn: return "already logged in";
+    case LoginResult::Busy:            return "login queue full, retry shortly";
+  }
+  return "?";
+}
+
+AuthManager::AuthManager(AuthOptions opt) : opt_(std::move(opt)), session_key_(randomBytes(32)) {
+  load_();
+  for (unsigned i = 0; i < std::max(1u, opt_.workers); ++i)
+    workers_.emplace_back([this]{
+      std::unique_lock<std::mutex> lk(pool_mu_);
+      for (;;){
+        pool_cv_.wait(lk, [&]{ return stop_ || !jobs_.empty(); });
+        if (jobs_.empty()) return;   // stopping and drained
+        auto job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lk.unlock();
+        (*job)();
+        lk.lock();
+      }
+    });
+}
+
+AuthManager::~AuthManager(){
+  {
+    std::lock_guard<std::mutex> lk(pool_mu_);
+    stop_ = true;
+  }
+  pool_cv_.notify_all();
+  for (auto& t : workers_) t.join();
+}
+
+bool AuthManager::runHashed_(std::function<void()> job){
+  auto task = std::make_shared<std::packaged_task<void()>>(std::move(job));
+  auto done = task->get_future();
+  {
+    std::lock_guard<std::mutex> lk(pool_mu_);
+    if (jobs_.size() >= opt_.max_queued) return false;
+    jobs_.push_back(task);
+  }
+  pool_cv_.notify_one();
+  if (done.wait_for(opt_.queue_wait) == std::future_status::timeout){
+    // Still queued: withdraw it. Already running: it finishes within one hash.
+    std::lock_guard<std::mutex> lk(pool_mu_);
+    auto it = std::find(jobs_.begin(), jobs_.end(), task);
+    if (it != jobs_.end()){ jobs_.erase(it); return false; }
+  }
+  done.get();   // rethrows a failed hash
+  return true;
+}
+
+AuthManager::Record AuthManager::hashNew_(const std::string& pass) const {
+  Record rec;
+  rec.log_n = opt_.scrypt_log_n; rec.r = kScryptR; rec.p = kScryptP;
+  rec.salt = randomBytes(kSaltBytes);
+  rec.hash.assign(kHashBytes, '\0');
+  const uint64_t n = uint64_t(1) << rec.log_n;
+  if (EVP_PBE_scrypt(pass.data(), pass.size(),
+                     reinterpret_cast<const unsigned char*>(rec.salt.data()), rec.salt.size(),
+                     n, rec.r, rec.p, 2 * 128 * n * rec.r * rec.p,
+                     reinterpret_cast<unsigned char*>(rec.hash.data()), rec.hash.size()) != 1)
+    throw std::runtime_error("auth: scrypt failed");
+  return rec;
+}
+
+bool AuthManager::verify_(const Record& rec, const std::string& pass) const {
+  std::string got(rec.hash.size(), '\0');
+  const uint64_t n = uint64_t(1) << rec.log_n;
+  if (EVP_PBE_scrypt(pass.data(), pass.size(),
+                     reinterpret_cast<const unsigned char*>(rec.salt.data()), rec.salt.size(),
+                     n, rec.r, rec.p, 2 * 128 * n * rec.r * rec.p,
+                     reinterpret_cast<unsigned char*>(got.data()), got.size()) != 1)
+    throw std::runtime_error("auth: scrypt failed");
+  return CRYPTO_memcmp(got.data(), rec.hash.data(), got.size()) == 0;
+}
+
+std::string AuthManager::sessionDigest_(const std::string& user, const std::string& pass) const {
+  std::string msg = user;
+  msg += '\0';
+  msg += pass;
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned len = 0;
+  HMAC(EVP_sha256(), session_key_.data(), int(session_key_.size()),
+       reinterpret_cast<const unsigned char*>(msg.data()), msg.size(), md, &len);
+  OPENSSL_cleanse(msg.data(), msg.size());
+  return std::string(reinterpret_cast<char*>(md), len);
+}
+
+LoginResult AuthManager::login(const std::string& user, const std::string& pass, User& out) {
+  if (user.empty() || pass.empty()) return LoginResult::BadCredentials;
+  const std::string digest = sessionDigest_(user, pass);
+  std::optional<Record> rec;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (logged_.count(user)) return LoginResult::AlreadyLoggedIn;
+    auto s = sessions_.find(user);
+    if (s != sessions_.end()){
+      if (s->second.expires <= std::chrono::steady_clock::now()) sessions_.erase(s);
+      else if (s->second.digest.size() == digest.size() &&
+               CRYPTO_memcmp(s->second.digest.data(), digest.data(), digest.size()) == 0){
+        logged_.insert(user);
+        out.id = user;
+        out.name = user;
+        return LoginResult::Ok;
+      }
+      // A wrong password leaves the session alone: it must not log the real owner out of the cache.
+    }
+    auto u = users_.find(user);
+    if (u != users_.end()) rec = u->second;
+    else if (!opt_.auto_register || !validName(user)) return LoginResult::BadCredentials;
+  }
+
+  bool ok = false;
+  Record fresh;
+  if (!runHashed_([&]{ if (rec) ok = verify_(*rec, pass); else { fresh = hashNew_(pass); ok = true; } }))
+    return LoginResult::Busy;
+  if (!ok) return LoginResult::BadCredentials;
+
+  std::string err;
+  if (!rec && !add_(user, fresh, err)) return LoginResult::BadCredentials;  // registered meanwhile
   std::lock_guard<std::mutex> lock(mu_);
-  if (logged_.find(user) != logged_.end()) return false; // already logged in
+  if (logged_.count(user)) return LoginResult::AlreadyLoggedIn;
   logged_.insert(user);
+  const auto now = std::chrono::steady_clock::now();
+  std::erase_if(sessions_, [&](const auto& kv){ return kv.second.expires <= now; });
+  sessions_[user] = {digest, now + opt_.session_ttl};
   out.id = user;
   out.name = user;
+  return LoginResult::Ok;
+}
+
+bool AuthManager::registerUser(const std::string& user, const std::string& pass, std::string& err_out) {
+  if (!validName(user) || pass.empty()){ err_out = "invalid user name or empty password"; return false; }
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (users_.count(user)){ err_out = "user exists"; return false; }
+  }
+  Record rec;
+  if (!runHashed_([&]{ rec = hashNew_(pass); })){ err_out = loginResultText(LoginResult::Busy); return false; }
+  return add_(user, rec, err_out);
+}
+
+bool AuthManager::add_(const std::string& user, const Record& rec, std::string& err_out) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!users_.emplace(user, rec).second){ err_out = "user exists"; return false; }
+  }
+  // The name is claimed; the disk write happens without holding up logins.
+  try {
+    append_(user, rec);
+  } catch (const std::exception& ex){
+    std::lock_guard<std::mutex> lock(mu_);
+    users_.erase(user);
+    err_out = ex.what();
+    return false;
+  }
   return true;
 }
 
+void AuthManager::append_(const std::string& user, const Record& rec) {
+  if (opt_.store_path.empty()) return;
+  std::lock_guard<std::mutex> lk(file_mu_);
+  std::ofstream out(opt_.store_path, std::ios::app);
+  if (out.tellp() == 0) out << "bg_users 1\n";
+  writeRecord_(out, user, rec);
+  out.flush();
+  if (!out) throw std::runtime_error(opt_.store_path + ": write failed");
+}
+
+void AuthManager::writeRecord_(std::ostream& out, const std::string& user, const Record& rec) {
+  out << user << " scrypt " << rec.log_n << ' ' << rec.r << ' ' << rec.p << ' '
+      << toHex(rec.salt) << ' ' << toHex(rec.hash) << "\n";
+}
+
+void AuthManager::load_() {
+  if (opt_.store_path.empty()) return;
+  // Only a store that is really absent means "start empty": treating an
+  // unreadable one that way would let the first registration overwrite it.
+  std::error_code ec;
+  if (!std::filesystem::exists(opt_.store_path, ec)){
+    if (ec) throw std::runtime_error(opt_.store_path + ": " + ec.message());
+    return;
+  }
+  std::ifstream in(opt_.store_path);
+  if (!in) throw std::runtime_error(opt_.store_path + ": cannot open user store");
+  std::string line, user, scheme, salt, hash;
+  if (!std::getline(in, line) || line != "bg_users 1")
+    throw std::runtime_error(opt_.store_path + ": not a user store");
+  bool torn = false;
+  while (std::getline(in, line)){
+    if (in.eof() && !line.empty()){ torn = true; break; }   // last append cut short
+    if (line.empty()) continue;
+    std::istringstream ls(line);
+    Record rec;
+    if (!(ls >> user >> scheme >> rec.log_n >> rec.r >> rec.p >> salt >> hash) || scheme != "scrypt" ||
+        rec.log_n < 1 || rec.log_n > 24 || !fromHex(salt, rec.salt) || !fromHex(hash, rec.hash) || rec.hash.empty())
+      throw std::runtime_error(opt_.store_path + ": bad user line: " + user);
+    users_[user] = std::move(rec);
+  }
+  if (in.bad()) throw std::runtime_error(opt_.store_path + ": read failed");
+  in.close();
+  // Rewrite without the partial line so later appends start on a line of their own.
+  if (torn) save_();
+}
+
+void AuthManager::save_() const {
+  if (opt_.store_path.empty()) return;
+  const std::string tmp = opt_.store_path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    out << "bg_users 1\n";
+    for (const auto& [user, rec] : users_) writeRecord_(out, user, rec);
+    out.flush();
+    if (!out) throw std::runtime_error(tmp + ": write failed");
+  }
+  std::filesystem::rename(tmp, opt_.store_path);
+}
+
 void AuthManager::logout(const std::string& user) {
   std::lock_guard<std::mutex> lock(mu_);
   logged_.erase(user);
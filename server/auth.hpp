@@ -1,8 +1,18 @@
 #pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
 #include <optional>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <mutex>
+#include <vector>
 
 namespace BG {
 
@@ -12,29 +22,114 @@ struct User {
   std::string name;  ///< display name (same as id for now)
 };
 
+/** AuthManager settings. */
+struct AuthOptions {
+  std::string store_path;           ///< users file; empty = in memory only
+  bool auto_register = true;        ///< first login of an unknown user creates the account
+  unsigned workers = 2;             ///< password-hashing threads
+  size_t max_queued = 8;            ///< logins waiting for a hashing thread before refusing
+  std::chrono::milliseconds queue_wait{1000}; ///< longest a login waits for a hashing thread
+  std::chrono::seconds session_ttl{300}; ///< how long a verified login skips hashing
+  unsigned scrypt_log_n = 14;       ///< scrypt cost N = 2^log_n with r=8, p=1 (16 MiB per hash)
+};
+
+enum class LoginResult { Ok, BadCredentials, AlreadyLoggedIn, Busy };
+
+/** Short reason for the client ("ok", "bad credentials", ...). */
+const char* loginResultText(LoginResult r);
+
 /**
- * @brief In-memory login registry with stub validation.
- *        Thread-safe. No persistence (yet).
+ * @brief Login registry backed by a persistent user store with scrypt password hashes.
+ *
+ * Hashing is memory-hard on purpose (tens of milliseconds, 16 MiB), so it
+ * never runs on the caller's thread: it goes to a small dedicated pool with
+ * a bounded FIFO queue. A login burst after an outage therefore waits its
+ * turn on @c workers threads; once @c max_queued logins are waiting further
+ * ones get LoginResult::Busy at once, and a queued login that no thread has
+ * picked up within @c queue_wait is withdrawn and gets Busy too. A caller
+ * is thus held for at most @c queue_wait plus one hash, and at most
+ * @c workers + @c max_queued callers are held at a time.
+ * Verified (user, password) pairs are remembered as keyed digests for
+ * @c session_ttl, so a client reconnecting soon after skips the pool.
+ *
+ * Store file (text; each new account is appended as one line, so
+ * registering never rewrites or locks out the others; a line cut short
+ * by a crash is dropped at the next start):
+ *   bg_users 1
+ *   <user> scrypt <log_n> <r> <p> <salt-hex> <hash-hex>
+ *
+ * Thread-safe.
  */
 class AuthManager {
 public:
-  AuthManager() = default;
+  AuthManager() : AuthManager(AuthOptions{}) {}
+
+  /** @throws std::runtime_error if the store exists but cannot be read. */
+  explicit AuthManager(AuthOptions opt);
+  ~AuthManager();
+
+  AuthManager(const AuthManager&) = delete;
+  AuthManager& operator=(const AuthManager&) = delete;
 
   /**
-   * @brief Validate credentials (stub) and add user to logged-in set.
-   *        For now: returns true iff both user & pass are non-empty AND user not already logged in.
+   * @brief Verify credentials and add the user to the logged-in set.
+   *        Blocks until a hashing thread has checked the password (unless
+   *        a recent session matches), or returns Busy as described above.
+   *        Unknown users are registered with this password when
+   *        @c auto_register is set.
    */
-  bool login(const std::string& user, const std::string& pass, User& out);
+  LoginResult login(const std::string& user, const std::string& pass, User& out);
 
-  /** Remove user from logged-in set (idempotent). */
+  /**
+   * @brief Create an account (hashed on the pool) and save the store.
+   * @return false with @p err_out set if the name is taken or invalid,
+   *         the pool is full, or the store cannot be written.
+   */
+  bool registerUser(const std::string& user, const std::string& pass, std::string& err_out);
+
+  /** Remove user from logged-in set (idempotent). Its session stays cached until it expires. */
   void logout(const std::string& user);
 
   /** Is user currently logged in? */
   bool isLoggedIn(const std::string& user) const;
 
 private:
+  struct Record {
+    unsigned log_n = 0, r = 0, p = 0;
+    std::string salt, hash;          ///< raw bytes
+  };
+  struct Session {
+    std::string digest;              ///< keyed SHA-256 of user and password
+    std::chrono::steady_clock::time_point expires;
+  };
+
+  /** Run @p job on the hashing pool and wait; false if the queue is full or no thread took it in time. */
+  bool runHashed_(std::function<void()> job);
+  Record hashNew_(const std::string& pass) const;
+  bool verify_(const Record& rec, const std::string& pass) const;
+  std::string sessionDigest_(const std::string& user, const std::string& pass) const;
+  /** Add @p user with @p rec and append it to the store; false (err_out set) on a name clash or I/O error. Takes mu_ itself. */
+  bool add_(const std::string& user, const Record& rec, std::string& err_out);
+  void append_(const std::string& user, const Record& rec);
+  static void writeRecord_(std::ostream& out, const std::string& user, const Record& rec);
+  void load_();
+  /** Rewrite the whole store through PATH.tmp and a rename (startup only). */
+  void save_() const;
+
+  AuthOptions opt_;
+  std::string session_key_;          ///< random per process
+
   mutable std::mutex mu_;
+  std::mutex file_mu_;               ///< serialises appends; never held with mu_
   std::unordered_set<std::string> logged_;
+  std::unordered_map<std::string, Record> users_;
+  std::unordered_map<std::string, Session> sessions_;
+
+  std::mutex pool_mu_;
+  std::condition_variable pool_cv_;
+  std::deque<std::shared_ptr<std::packaged_task<void()>>> jobs_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
 };
 
 } // namespace BG
@@ -0,0 +1,26 @@
+#include <csignal>
+#include <iostream>
+#include <string>
+#include "logger.hpp"
+#include "tui_gateway.hpp"
+
+static BG::TuiGateway* g_gateway = nullptr;
+extern "C" void on_stop(int){ if (g_gateway) g_gateway->stop(); }
+
+int main(int argc, char** argv) {
+  BG::TuiGateway::Options opt;
+  if (argc >= 2) opt.port = static_cast<uint16_t>(std::stoul(argv[1]));
+  if (argc >= 3) opt.server = argv[2];
+  if (argc >= 4) opt.match_id = argv[3];
+
+  std::signal(SIGPIPE, SIG_IGN);
+
+  BG::Logger logger{"logs/gateway.log"};
+  BG::TuiGateway gateway(opt, logger);
+  g_gateway = &gateway;
+  std::signal(SIGINT, on_stop);
+  std::signal(SIGTERM, on_stop);
+
+  std::cout << "bg_gateway listening on port " << opt.port << " (server " << opt.server << ")\n";
+  return gateway.run();
+}
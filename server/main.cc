@@ -7,16 +7,28 @@
 #include <ctime>
 #include <iomanip>
 #include <algorithm> // std::remove
+#include <atomic>
+#include <filesystem>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <thread>
 
 #include "bg/v1/bg.grpc.pb.h"
 #include "bg/v1/bg.pb.h"
 
 #include "../board.hpp"
+#include "../gamerecord.hpp"
+#include "../evalcache.hpp"
+#include "../openingbook.hpp"
+#include "../search.hpp"
 
 using grpc::Server;
 using grpc::ServerBuilder;
 using grpc::ServerContext;
 using grpc::ServerReaderWriter;
+using grpc::ServerWriter;
 using grpc::Status;
 
 namespace proto = ::bg::v1;
@@ -42,25 +54,141 @@ struct Logger {
 };
 // ---------------------------------
 
+// One Stream subscriber. Sends only queue envelopes; a writer thread per
+// subscriber drains the queue, so a slow or half-open client stalls nobody
+// else. A subscriber stuck in one Write for kWriteTimeout, or kMaxQueued
+// envelopes behind, is cancelled: its Read fails and the handler reaps it.
+// Transport keepalive (see main) does the same for idle dead connections.
+struct Subscriber {
+  static constexpr auto kWriteTimeout = std::chrono::seconds(10);
+  static constexpr size_t kMaxQueued = 64;
+
+  ServerContext* ctx;
+  ServerReaderWriter<proto::Envelope, proto::Envelope>* rw;
+
+  Subscriber(ServerContext* c, ServerReaderWriter<proto::Envelope, proto::Envelope>* s)
+    : ctx(c), rw(s), writer_([this]{ run(); }) {}
+
+  // Queue ev; false (and the stream cancelled) if this subscriber is dead.
+  bool push(const proto::Envelope& ev){
+    std::lock_guard<std::mutex> lk(mu_);
+    if (closed_) return false;
+    if (out_.size() >= kMaxQueued ||
+        (writing_ && std::chrono::steady_clock::now() - writeStart_ > kWriteTimeout)){
+      kill_();
+      return false;
+    }
+    out_.push_back(ev);
+    cv_.notify_all();
+    return true;
+  }
+
+  // The reader loop is done: drop what is queued, give a write in flight
+  // kWriteTimeout to finish (then cancel it) and stop the writer.
+  void finish(){
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      closed_ = true;
+      std::deque<proto::Envelope>().swap(out_);
+      cv_.notify_all();
+      if (!cv_.wait_for(lk, kWriteTimeout, [&]{ return !writing_; })) ctx->TryCancel();
+    }
+    writer_.join();
+  }
+
+private:
+  void run(){
+    std::unique_lock<std::mutex> lk(mu_);
+    for (;;){
+      cv_.wait(lk, [&]{ return closed_ || !out_.empty(); });
+      if (closed_) return;
+      proto::Envelope ev = std::move(out_.front());
+      out_.pop_front();
+      writing_ = true;
+      writeStart_ = std::chrono::steady_clock::now();
+      lk.unlock();
+      bool ok = rw->Write(ev);
+      lk.lock();
+      writing_ = false;
+      cv_.notify_all();
+      if (!ok){ kill_(); return; }
+    }
+  }
+
+  void kill_(){
+    closed_ = true;
+    std::deque<proto::Envelope>().swap(out_);
+    ctx->TryCancel();
+    cv_.notify_all();
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<proto::Envelope> out_;
+  bool closed_ = false, writing_ = false;
+  std::chrono::steady_clock::time_point writeStart_;
+  std::thread writer_;   // last: starts after the rest is initialised
+};
+
 // A single in-memory match ("m1") with one Board and many subscribers.
 struct Match {
   BGNS::Board board;
   uint64_t version = 0;
 
   std::mutex mtx;
-  std::vector< ServerReaderWriter<proto::Envelope, proto::Envelope>* > subs;
+  std::vector< std::shared_ptr<Subscriber> > subs;
 
   std::unique_ptr<Logger> log;
 
+  // Optional binary game record, appended as turns are committed (BG_SERVER_RECORD=path).
+  std::unique_ptr<std::ofstream> recOut;
+  std::unique_ptr<BGNS::RecordWriter> rec;
+  uint64_t gameId = 0;
+  BGNS::Play pending;  // steps applied so far this turn
+
   Match(){
     if (std::getenv("BG_SERVER_LOG"))
       log = std::make_unique<Logger>("bg_server.log");
 
+    if (const char* path = std::getenv("BG_SERVER_RECORD")){
+      std::error_code ec;
+      bool fresh = !std::filesystem::exists(path, ec) || std::filesystem::file_size(path, ec) == 0;
+      recOut = std::make_unique<std::ofstream>(path, std::ios::binary | std::ios::app);
+      if (*recOut) rec = std::make_unique<BGNS::RecordWriter>(*recOut, fresh);
+      else if (log) log->log("[rec] cannot open ", path);
+    }
+
     // Start a new game: opening doubles are rerolled, no auto-doubles.
     BGNS::Rules rules{};
     rules.openingDoublePolicy = BGNS::Rules::OpeningDoublePolicy::REROLL;
     rules.maxOpeningAutoDoubles = 0;
     board.startGame(rules);
+
+    BGNS::GameHeader h;
+    h.gameId = ++gameId;
+    h.rules = rules;
+    record([&](BGNS::RecordWriter& w){ w.gameStart(h); });
+  }
+
+  // Run f against the record writer; a failing record is disabled, never fatal to play.
+  template<typename F> void record(F&& f){
+    if (!rec) return;
+    try { f(*rec); }
+    catch (const std::exception& ex){
+      if (log) log->log("[rec] disabled: ", ex.what());
+      rec.reset();
+    }
+  }
+
+  // After a successful commit: append the turn, close the game if it was borne off.
+  void recordCommit(){
+    record([&](BGNS::RecordWriter& w){
+      w.play(pending);
+      BGNS::GameEnd end;
+      if (BGNS::finishedGame(board, end)) w.gameEnd(end);
+      else w.flush();
+    });
+    pending = BGNS::Play{};
   }
 
   // Convert the current board to proto::BoardState
@@ -105,21 +233,21 @@ struct Match {
     return out;
   }
 
-  void sendError(ServerReaderWriter<proto::Envelope, proto::Envelope>* rw, int code, const std::string& msg){
+  void sendError(Subscriber& sub, int code, const std::string& msg){
     proto::Envelope ev;
     auto* e = ev.mutable_evt()->mutable_error();
     e->set_code(code);
     e->set_message(msg);
-    rw->Write(ev);
+    sub.push(ev);
     if (log) log->log("[err] code=", code, " msg=", msg);
   }
 
-  void sendSnapshot(ServerReaderWriter<proto::Envelope, proto::Envelope>* rw){
+  void sendSnapshot(Subscriber& sub){
     proto::Envelope ev;
     auto* snap = ev.mutable_evt()->mutable_snapshot();
     snap->set_version(++version);
     *snap->mutable_state() = toProtoState();
-    rw->Write(ev);
+    sub.push(ev);
   }
 
   void broadcastSnapshot(){
@@ -127,7 +255,12 @@ struct Match {
     auto* snap = ev.mutable_evt()->mutable_snapshot();
     snap->set_version(++version);
     *snap->mutable_state() = toProtoState();
-    for (auto* s : subs) s->Write(ev);
+    // Dead subscribers leave the list at once; their handlers free the rest.
+    size_t before = subs.size();
+    subs.erase(std::remove_if(subs.begin(), subs.end(),
+                              [&](const std::shared_ptr<Subscriber>& s){ return !s->push(ev); }),
+               subs.end());
+    if (log && subs.size() != before) log->log("[sub] dropped ", before - subs.size(), " dead subscriber(s)");
   }
 
   void broadcastMsg(const char* m){
@@ -153,12 +286,13 @@ public:
 
 class MatchServiceImpl final : public proto::MatchService::Service {
 public:
-  Status Stream(ServerContext*,
+  Status Stream(ServerContext* ctx,
                 ServerReaderWriter<proto::Envelope, proto::Envelope>* rw) override
   {
+    auto sub = std::make_shared<Subscriber>(ctx, rw);
     {
       std::lock_guard<std::mutex> lk(g_match.mtx);
-      g_match.subs.push_back(rw);
+      g_match.subs.push_back(sub);
     }
 
     proto::Envelope in;
@@ -171,14 +305,14 @@ public:
       // join
       if (cmd.has_join_match()){
         g_match.broadcastMsg("[cmd] join_match");
-        g_match.sendSnapshot(rw);
+        g_match.sendSnapshot(*sub);
         continue;
       }
 
       // snapshot request
       if (cmd.has_request_snapshot()){
         g_match.broadcastMsg("[cmd] request_snapshot");
-        g_match.sendSnapshot(rw);
+        g_match.sendSnapshot(*sub);
         continue;
       }
 
@@ -186,16 +320,18 @@ public:
       if (cmd.has_roll_dice()){
         try{
           if (g_match.board.phase()==BGNS::Phase::OpeningRoll){
-            auto wb = g_match.board.rollOpening(); (void)wb;
+            auto wb = g_match.board.rollOpening();
+            g_match.record([&](BGNS::RecordWriter& w){ w.openingRoll(wb.first, wb.second); });
             g_match.broadcastMsg("[cmd] roll (opening)");
             g_match.broadcastSnapshot();
           } else {
-            g_match.board.rollDice();
+            auto dd = g_match.board.rollDice();
+            g_match.record([&](BGNS::RecordWriter& w){ w.roll(dd.first, dd.second); });
             g_match.broadcastMsg("[cmd] roll");
             g_match.broadcastSnapshot();
           }
         } catch (const std::exception& ex){
-          g_match.sendError(rw, 409, ex.what());
+          g_match.sendError(*sub, 409, ex.what());
         }
         continue;
       }
@@ -206,19 +342,22 @@ public:
         int d2 = cmd.set_dice().d2();
         try{
           if (g_match.board.phase()==BGNS::Phase::OpeningRoll){
-            bool ok = g_match.board.setOpeningDice(d1,d2);
-            g_match.broadcastMsg("[cmd] set (opening)");
-            if (!ok){
-              g_match.sendError(rw, 409, "opening doubles — reroll required");
+            // Rejected opening doubles leave the board untouched: nothing to record.
+            if (!g_match.board.setOpeningDice(d1,d2)){
+              g_match.sendError(*sub, 409, "opening doubles — reroll required");
+              continue;
             }
+            g_match.record([&](BGNS::RecordWriter& w){ w.openingRoll(d1, d2); });
+            g_match.broadcastMsg("[cmd] set (opening)");
             g_match.broadcastSnapshot();
           } else {
             g_match.board.setDice(d1,d2);
+            g_match.record([&](BGNS::RecordWriter& w){ w.roll(d1, d2); });
             g_match.broadcastMsg("[cmd] set");
             g_match.broadcastSnapshot();
           }
         } catch (const std::exception& ex){
-          g_match.sendError(rw, 409, ex.what());
+          g_match.sendError(*sub, 409, ex.what());
         }
         continue;
       }
@@ -229,8 +368,9 @@ public:
         int pip  = cmd.apply_step().pip();
         bool ok = g_match.board.applyStep(from, pip);
         if (!ok){
-          g_match.sendError(rw, 409, g_match.board.lastError());
+          g_match.sendError(*sub, 409, g_match.board.lastError());
         } else {
+          if (g_match.pending.n < 4) g_match.pending.push(from, pip);
           g_match.broadcastMsg("[cmd] step");
           g_match.broadcastSnapshot();
         }
@@ -241,8 +381,9 @@ public:
       if (cmd.has_undo_step()){
         bool ok = g_match.board.undoStep();
         if (!ok){
-          g_match.sendError(rw, 409, "undoStep failed");
+          g_match.sendError(*sub, 409, "undoStep failed");
         } else {
+          if (g_match.pending.n > 0) --g_match.pending.n;
           g_match.broadcastMsg("[cmd] undo");
           g_match.broadcastSnapshot();
         }
@@ -253,8 +394,9 @@ public:
       if (cmd.has_commit_turn()){
         bool ok = g_match.board.commitTurn();
         if (!ok){
-          g_match.sendError(rw, 409, g_match.board.lastError());
+          g_match.sendError(*sub, 409, g_match.board.lastError());
         } else {
+          g_match.recordCommit();
           g_match.broadcastMsg("[cmd] commit");
           g_match.broadcastSnapshot();
         }
@@ -263,35 +405,163 @@ public:
 
       // doubling cube
       if (cmd.has_offer_cube()){
-        if (!g_match.board.offerCube()) g_match.sendError(rw, 409, g_match.board.lastError());
-        else { g_match.broadcastMsg("[cmd] double"); g_match.broadcastSnapshot(); }
+        if (!g_match.board.offerCube()) g_match.sendError(*sub, 409, g_match.board.lastError());
+        else {
+          g_match.record([](BGNS::RecordWriter& w){ w.cubeOffer(); w.flush(); });
+          g_match.broadcastMsg("[cmd] double"); g_match.broadcastSnapshot();
+        }
         continue;
       }
       if (cmd.has_take_cube()){
-        if (!g_match.board.takeCube()) g_match.sendError(rw, 409, g_match.board.lastError());
-        else { g_match.broadcastMsg("[cmd] take"); g_match.broadcastSnapshot(); }
+        if (!g_match.board.takeCube()) g_match.sendError(*sub, 409, g_match.board.lastError());
+        else {
+          g_match.record([](BGNS::RecordWriter& w){ w.cubeTake(); w.flush(); });
+          g_match.broadcastMsg("[cmd] take"); g_match.broadcastSnapshot();
+        }
         continue;
       }
       if (cmd.has_drop_cube()){
-        if (!g_match.board.dropCube()) g_match.sendError(rw, 409, g_match.board.lastError());
-        else { g_match.broadcastMsg("[cmd] drop"); g_match.broadcastSnapshot(); }
+        if (!g_match.board.dropCube()) g_match.sendError(*sub, 409, g_match.board.lastError());
+        else {
+          auto r = g_match.board.result();
+          BGNS::GameEnd end; end.winner = r.winner; end.points = r.finalCube; end.resigned = true;
+          g_match.record([&](BGNS::RecordWriter& w){ w.cubeDrop(); w.gameEnd(end); });
+          g_match.broadcastMsg("[cmd] drop"); g_match.broadcastSnapshot();
+        }
         continue;
       }
 
       // unknown -> snapshot (helps debugging)
-      g_match.sendSnapshot(rw);
+      g_match.sendSnapshot(*sub);
     }
 
-    // remove subscriber
+    // remove subscriber (a broadcast may have already) and stop its writer
     {
       std::lock_guard<std::mutex> lk(g_match.mtx);
       auto& v = g_match.subs;
-      v.erase(std::remove(v.begin(), v.end(), rw), v.end());
+      v.erase(std::remove(v.begin(), v.end(), sub), v.end());
     }
+    sub->finish();
     return Status::OK;
   }
 };
 
+// Streams hint rankings as the search deepens: 0-ply at once, then each
+// deeper pass, until max_plies, the time budget, or the client cancels.
+// The search polls both per roll, so a 3-ply pass gives up within a 1-ply
+// search of either rather than running to completion on the RPC thread.
+// BG_SERVER_WEIGHTS / BG_SERVER_BOOK select trained weights and a book;
+// BG_SERVER_CACHE names an evaluation cache shared with batch jobs.
+class HintServiceImpl final : public proto::HintService::Service {
+public:
+  static constexpr unsigned kDefaultPlies = 2, kMaxPlies = 3;
+  static constexpr unsigned kDefaultPlays = 5, kMaxPlays = 20;
+  static constexpr uint32_t kBudgetMs = 10000;   // also the cap on budget_ms
+  static constexpr unsigned kMaxDeep = 4;        // concurrent hints of 2+ plies
+  static constexpr unsigned kCheckers = 15;
+
+  HintServiceImpl(){
+    try {
+      if (const char* w = std::getenv("BG_SERVER_WEIGHTS")) ev_ = BGNS::Evaluator::load(w);
+      if (const char* b = std::getenv("BG_SERVER_BOOK")) book_ = std::make_unique<BGNS::OpeningBook>(b);
+      if (const char* c = std::getenv("BG_SERVER_CACHE")) cache_ = std::make_unique<BGNS::EvalCache>(c, ev_);
+    } catch (const std::exception& ex){
+      std::cerr << "bg_server: hints: " << ex.what() << "\n";
+    }
+    search_ = std::make_unique<BGNS::Search>(ev_);
+    search_->setBook(book_.get());
+    search_->setCache(cache_.get());
+  }
+
+  Status Hint(ServerContext* ctx, const proto::HintRequest* req, ServerWriter<proto::HintUpdate>* w) override {
+    const auto& st = req->state();
+    if (st.points_size()!=24)
+      return Status(grpc::StatusCode::INVALID_ARGUMENT, "state needs 24 points");
+    BGNS::Side side = st.side_to_move()==proto::WHITE ? BGNS::WHITE : st.side_to_move()==proto::BLACK ? BGNS::BLACK : BGNS::NONE;
+    if (side==BGNS::NONE)
+      return Status(grpc::StatusCode::INVALID_ARGUMENT, "no side to move");
+    const auto& dice = st.dice_remaining();
+    bool fresh = dice.size()==2 || (dice.size()==4 && dice[0]==dice[1] && dice[1]==dice[2] && dice[2]==dice[3]);
+    if (!fresh || dice[0]<1 || dice[0]>6 || dice[1]<1 || dice[1]>6)
+      return Status(grpc::StatusCode::FAILED_PRECONDITION, "hints need the roll before any step is played");
+
+    // Position keys keep only what a legal position needs, so an illegal
+    // state could alias a legal one in the shared evaluation cache.
+    BGNS::Board::State bs{};
+    uint64_t total[2] = {st.white_bar() + uint64_t(st.white_off()), st.black_bar() + uint64_t(st.black_off())};
+    for (int i=0; i<24; ++i){
+      const auto& pt = st.points(i);
+      if (!pt.count()) continue;
+      if (pt.side()!=proto::WHITE && pt.side()!=proto::BLACK)
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, "checkers on a point without a side");
+      total[pt.side()==proto::WHITE ? 0 : 1] += pt.count();
+      bs.points[i].count = pt.count();
+      bs.points[i].side = pt.side()==proto::WHITE ? BGNS::WHITE : BGNS::BLACK;
+    }
+    if (total[0]!=kCheckers || total[1]!=kCheckers)
+      return Status(grpc::StatusCode::INVALID_ARGUMENT, "each side needs 15 checkers on points, bar and off");
+    bs.whitebar = st.white_bar(); bs.blackbar = st.black_bar();
+    bs.whiteoff = st.white_off(); bs.blackoff = st.black_off();
+    const BGNS::Position pos = BGNS::Position::fromState(bs, side);
+
+    const unsigned maxPlies = req->max_plies() ? std::min(req->max_plies(), kMaxPlies) : kDefaultPlies;
+    // Deep hints hold an RPC thread for up to kBudgetMs; refuse beyond kMaxDeep at once.
+    struct Slot {
+      std::atomic<unsigned>* n = nullptr;
+      ~Slot(){ if (n) n->fetch_sub(1); }
+    } slot;
+    if (maxPlies>1){
+      if (deep_.fetch_add(1) >= kMaxDeep){
+        deep_.fetch_sub(1);
+        return Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "too many hints in progress, retry shortly");
+      }
+      slot.n = &deep_;
+    }
+    const size_t n = req->max_plays() ? std::min(req->max_plays(), kMaxPlays) : kDefaultPlays;
+    const uint32_t budget = req->budget_ms() ? std::min(req->budget_ms(), kBudgetMs) : kBudgetMs;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget);
+
+    proto::HintUpdate last;
+    bool gone = false;
+    auto send = [&](const std::vector<BGNS::ScoredPlay>& plays){
+      last.Clear();
+      last.set_plies(plays.empty() ? 0 : plays.front().plies);
+      last.set_final(plays.size()<2 || plays.front().plies>=maxPlies);
+      for (const auto& sp : plays){
+        auto* hp = last.add_plays();
+        hp->set_text(sp.cand.move.text());
+        hp->set_equity(sp.equity);
+        hp->set_plies(sp.plies);
+        BGNS::Play play = sp.cand.move.toPlay(side);
+        for (unsigned k=0; k<play.n; ++k){
+          auto* step = hp->add_steps();
+          step->set_from(play.steps[k].from);
+          step->set_pip(play.steps[k].pip);
+        }
+      }
+      gone = !w->Write(last);
+      return !gone;
+    };
+    auto stop = [&]{ return ctx->IsCancelled() || std::chrono::steady_clock::now()>=deadline; };
+    search_->deepen(pos, dice[0], dice[1], maxPlies, n, send, stop);
+
+    if (ctx->IsCancelled()) return Status::CANCELLED;
+    // Out of time, or an exact/book answer: mark the last ranking final.
+    if (!gone && !last.final()){
+      last.set_final(true);
+      w->Write(last);
+    }
+    return Status::OK;
+  }
+
+private:
+  BGNS::Evaluator ev_;
+  std::unique_ptr<BGNS::OpeningBook> book_;
+  std::unique_ptr<BGNS::EvalCache> cache_;
+  std::unique_ptr<BGNS::Search> search_;
+  std::atomic<unsigned> deep_{0};
+};
+
 // ---------------- main ----------------
 
 int main(int argc, char** argv){
@@ -300,11 +570,19 @@ int main(int argc, char** argv){
   std::string addr("0.0.0.0:50051");
   AuthServiceImpl auth;
   MatchServiceImpl match;
+  HintServiceImpl hint;
 
   ServerBuilder builder;
   builder.AddListeningPort(addr, grpc::InsecureServerCredentials());
+  // Ping every connection, busy or idle, and close it when a ping goes
+  // unanswered: half-open clients then fail their streams within ~30 s.
+  builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIME_MS, 20000);
+  builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, 10000);
+  builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+  builder.AddChannelArgument(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
   builder.RegisterService(&auth);
   builder.RegisterService(&match);
+  builder.RegisterService(&hint);
   std::unique_ptr<Server> server(builder.BuildAndStart());
 
   if (g_match.log) g_match.log->log("[server] listening on ", addr);
@@ -23,13 +23,15 @@ Status AuthServiceImpl::Login(::grpc::ServerContext*,
     return Status::OK;
   }
   User u;
-  if (auth_.login(req->user(), req->pass(), u)) {
+  LoginResult r = auth_.login(req->user(), req->pass(), u);
+  if (r == LoginResult::Ok) {
     log_.info(EventType::UserLogin, u.id, "login via RPC");
     resp->set_ok(true);
     return Status::OK;
   }
+  if (r == LoginResult::Busy) log_.error(req->user(), "login refused: hashing queue full");
   resp->set_ok(false);
-  resp->set_reason("bad creds or already logged in");
+  resp->set_reason(loginResultText(r));
   return Status::OK;
 }
 
@@ -61,13 +61,14 @@ int main(){
       if (args.size() < 3) { std::cout << "usage: login <user> <pass>\n"; continue; }
       if (current) { std::cout << "already logged in as '"<<current->id<<"'\n"; continue; }
       User u;
-      if (auth.login(args[1], args[2], u)) {
+      LoginResult r = auth.login(args[1], args[2], u);
+      if (r == LoginResult::Ok) {
         current = u;
         logger.info(EventType::UserLogin, u.id, "login ok (smoke)");
         std::cout << "logged in as '" << u.id << "'\n";
       } else {
-        logger.error(args[1], "login failed (stub or already logged in)");
-        std::cout << "login failed (bad creds or already logged in)\n";
+        logger.error(args[1], std::string("login failed: ") + loginResultText(r));
+        std::cout << "login failed (" << loginResultText(r) << ")\n";
       }
       continue;
     }
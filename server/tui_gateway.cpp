@@ -0,0 +1,537 @@
+#include "tui_gateway.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "../board.hpp"
+#include "../ansi_renderer.hpp"
+
+namespace BG {
+
+namespace proto = ::bg::v1;
+
+namespace {
+
+// Screen rows (1-based): title, board, status, prompt.
+constexpr int kTitleRow  = 1;
+constexpr int kBoardTop  = 2;
+constexpr int kStatusRow = kBoardTop + AnsiRenderer::kHeight + 1;
+constexpr int kPromptRow = kStatusRow + 1;
+constexpr size_t kMaxLine = 120;
+
+// Telnet (RFC 854/857/858): we echo and suppress go-ahead ourselves.
+constexpr unsigned char IAC = 255, DONT = 254, DO = 253, WONT = 252, WILL = 251, SB = 250, SE = 240;
+constexpr unsigned char OPT_ECHO = 1, OPT_SGA = 3;
+
+Side toSide(proto::Side s){
+  switch (s) {
+    case proto::WHITE: return WHITE;
+    case proto::BLACK: return BLACK;
+    default:           return NONE;
+  }
+}
+
+void fillBoardState(const proto::BoardState& p, Board::State& out){
+  for (int i = 0; i < 24; ++i){
+    out.points[i].count = 0; out.points[i].side = NONE;
+    if (i < p.points_size()){
+      const auto& pt = p.points(i);
+      out.points[i].count = pt.count();
+      out.points[i].side  = toSide(pt.side());
+    }
+  }
+  out.whitebar = p.white_bar(); out.blackbar = p.black_bar();
+  out.whiteoff = p.white_off(); out.blackoff = p.black_off();
+}
+
+const char* sideName(proto::Side s){
+  switch (s){
+    case proto::WHITE: return "WHITE";
+    case proto::BLACK: return "BLACK";
+    default:           return "NONE";
+  }
+}
+
+const char* phaseName(proto::Phase p){
+  switch (p){
+    case proto::OPENING_ROLL:  return "OpeningRoll";
+    case proto::AWAITING_ROLL: return "AwaitingRoll";
+    case proto::MOVING:        return "Moving";
+    case proto::CUBE_OFFERED:  return "CubeOffered";
+    default:                   return "Unknown";
+  }
+}
+
+std::string trim(const std::string& s){
+  auto a = s.find_first_not_of(" \t\r\n");
+  if (a == std::string::npos) return "";
+  auto b = s.find_last_not_of(" \t\r\n");
+  return s.substr(a, b - a + 1);
+}
+
+bool setNonBlocking(int fd){
+  int fl = fcntl(fd, F_GETFL, 0);
+  return fl >= 0 && fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
+void moveTo(std::string& out, int row){
+  out += "\x1b[" + std::to_string(row) + ";1H\x1b[2K";
+}
+
+} // anon
+
+// ---------------------------------------------------------------------------
+// One Stream RPC per session. Callbacks run on gRPC threads and only post to
+// the gateway's inbound queue; the poll loop owns all session state.
+// ---------------------------------------------------------------------------
+class TuiGateway::Stream final
+    : public ::grpc::ClientBidiReactor<proto::Envelope, proto::Envelope> {
+public:
+  Stream(TuiGateway& gw, uint64_t sid) : gw_(gw), sid_(sid) {}
+
+  void start(proto::MatchService::Stub& stub){
+    stub.async()->Stream(&ctx_, this);
+    StartRead(&in_);
+    StartCall();
+  }
+
+  /** Queue a message; at most one write is in flight at a time. */
+  void send(const proto::Envelope& e){
+    const proto::Envelope* first = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (finished_) return;
+      out_.push_back(e);
+      if (writing_) return;
+      writing_ = true;
+      first = &out_.front();
+    }
+    StartWrite(first);
+  }
+
+  void cancel(){ ctx_.TryCancel(); }
+
+  void OnReadDone(bool ok) override {
+    if (!ok) return; // OnDone follows
+    Inbound ev;
+    ev.sid = sid_;
+    ev.env = in_;
+    gw_.post(std::move(ev));
+    StartRead(&in_);
+  }
+
+  void OnWriteDone(bool ok) override {
+    const proto::Envelope* next = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      out_.pop_front();
+      if (!ok) { finished_ = true; writing_ = false; out_.clear(); return; }
+      if (out_.empty()) { writing_ = false; return; }
+      next = &out_.front();
+    }
+    StartWrite(next);
+  }
+
+  void OnDone(const ::grpc::Status& s) override {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      finished_ = true;
+    }
+    Inbound ev;
+    ev.sid = sid_;
+    ev.done = true;
+    ev.status = s.ok() ? "stream closed" : s.error_message();
+    gw_.post(std::move(ev)); // the loop destroys us once it sees this
+  }
+
+private:
+  TuiGateway& gw_;
+  const uint64_t sid_;
+  ::grpc::ClientContext ctx_;
+  proto::Envelope in_;
+
+  std::mutex mu_;
+  std::deque<proto::Envelope> out_;  // references stay valid across push_back
+  bool writing_ = false;
+  bool finished_ = false;
+};
+
+// ---------------------------------------------------------------------------
+// Per-terminal state. Kept small: the renderer's two frames dominate (~5 KB).
+// ---------------------------------------------------------------------------
+struct TuiGateway::Session {
+  uint64_t id = 0;
+  int fd = -1;
+  std::string user;                 ///< empty until the player names themselves
+  Stream* stream = nullptr;         ///< owned by streams_
+  std::string ibuf, outbuf;
+  int telnet = 0;                   ///< IAC parser state
+  bool lastCR = false;
+  bool haveState = false;
+  proto::BoardState st;
+  std::string msg;
+  const char* dead = nullptr;       ///< close reason; reaped by the loop
+  AnsiRenderer board{kBoardTop, 1};
+};
+
+// ---------------------------------------------------------------------------
+
+TuiGateway::TuiGateway(Options opt, Logger& log) : opt_(std::move(opt)), log_(log) {}
+
+TuiGateway::~TuiGateway(){
+  if (listen_fd_ >= 0) ::close(listen_fd_);
+  if (wake_rd_ >= 0) ::close(wake_rd_);
+  if (wake_wr_ >= 0) ::close(wake_wr_);
+}
+
+void TuiGateway::stop(){
+  stop_ = true;
+  wake();
+}
+
+void TuiGateway::wake(){
+  if (wake_wr_ < 0) return;
+  char c = 1;
+  ssize_t n = ::write(wake_wr_, &c, 1);
+  (void)n; // a full pipe already guarantees a wakeup
+}
+
+void TuiGateway::post(Inbound ev){
+  {
+    std::lock_guard<std::mutex> lk(in_mu_);
+    inbound_.push_back(std::move(ev));
+  }
+  wake();
+}
+
+int TuiGateway::run(){
+  int p[2];
+  if (::pipe(p) != 0) { log_.error("-", "gateway: pipe failed"); return 1; }
+  wake_rd_ = p[0]; wake_wr_ = p[1];
+  setNonBlocking(wake_rd_); setNonBlocking(wake_wr_);
+
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) { log_.error("-", "gateway: socket failed"); return 1; }
+  int one = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(opt_.port);
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 ||
+      ::listen(listen_fd_, 128) != 0) {
+    log_.error("-", "gateway: cannot listen on port " + std::to_string(opt_.port) + ": " + std::strerror(errno));
+    return 1;
+  }
+  setNonBlocking(listen_fd_);
+
+  chan_ = ::grpc::CreateChannel(opt_.server, ::grpc::InsecureChannelCredentials());
+  stub_ = proto::MatchService::NewStub(chan_);
+  log_.info(EventType::System, "-", "gateway listening on port " + std::to_string(opt_.port) +
+            ", server " + opt_.server);
+
+  std::vector<pollfd> fds;
+  std::vector<uint64_t> sids;
+  while (!stop_) {
+    fds.clear(); sids.clear();
+    fds.push_back({wake_rd_, POLLIN, 0});
+    fds.push_back({listen_fd_, short(sessions_.size() < opt_.max_sessions ? POLLIN : 0), 0});
+    for (auto& [sid, s] : sessions_) {
+      fds.push_back({s->fd, short(POLLIN | (s->outbuf.empty() ? 0 : POLLOUT)), 0});
+      sids.push_back(sid);
+    }
+
+    if (::poll(fds.data(), fds.size(), 1000) < 0) {
+      if (errno == EINTR) continue;
+      log_.error("-", std::string("gateway: poll: ") + std::strerror(errno));
+      break;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      char buf[256];
+      while (::read(wake_rd_, buf, sizeof buf) > 0) {}
+      drainInbound();
+    }
+    if (fds[1].revents & POLLIN) accept_();
+
+    for (size_t i = 2; i < fds.size(); ++i) {
+      auto it = sessions_.find(sids[i-2]);
+      if (it == sessions_.end()) continue;
+      Session& s = *it->second;
+      if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) onReadable(s);
+      if (!s.dead && (fds[i].revents & POLLOUT)) flush(s);
+    }
+
+    std::vector<std::pair<uint64_t, const char*>> reap;
+    for (auto& [sid, s] : sessions_) if (s->dead) reap.emplace_back(sid, s->dead);
+    for (auto& [sid, why] : reap) close(sid, why);
+  }
+
+  // Shut down: hang up terminals, then wait for every RPC to report OnDone.
+  std::vector<uint64_t> all;
+  for (auto& [sid, s] : sessions_) all.push_back(sid);
+  for (auto sid : all) close(sid, "gateway shutting down");
+  while (!streams_.empty()) {
+    pollfd w{wake_rd_, POLLIN, 0};
+    ::poll(&w, 1, 100);
+    char buf[256];
+    while (::read(wake_rd_, buf, sizeof buf) > 0) {}
+    drainInbound();
+  }
+  log_.info(EventType::System, "-", "gateway stopped");
+  return 0;
+}
+
+void TuiGateway::accept_(){
+  for (;;) {
+    int fd = ::accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) return; // EAGAIN or transient error; poll again
+    if (sessions_.size() >= opt_.max_sessions) {
+      static const char full[] = "gateway full, try later\r\n";
+      ssize_t n = ::send(fd, full, sizeof full - 1, 0); (void)n;
+      ::close(fd);
+      continue;
+    }
+    setNonBlocking(fd);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+    auto s = std::make_unique<Session>();
+    s->id = next_sid_++;
+    s->fd = fd;
+    const unsigned char nego[] = { IAC, WILL, OPT_ECHO, IAC, WILL, OPT_SGA };
+    s->outbuf.append(reinterpret_cast<const char*>(nego), sizeof nego);
+    s->msg = "welcome — enter a name to join " + opt_.match_id;
+    Session& ref = *s;
+    sessions_.emplace(s->id, std::move(s));
+    repaint(ref, /*full*/true);
+  }
+}
+
+void TuiGateway::onReadable(Session& s){
+  unsigned char buf[512];
+  for (;;) {
+    ssize_t n = ::recv(s.fd, buf, sizeof buf, 0);
+    if (n == 0) { s.dead = "hangup"; return; }
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) s.dead = "read error";
+      return;
+    }
+
+    bool promptDirty = false;
+    for (ssize_t i = 0; i < n; ++i) {
+      unsigned char c = buf[i];
+      switch (s.telnet) {                 // strip telnet negotiation
+        case 1:                           // after IAC (IAC IAC, a literal 255, is dropped)
+          if (c == WILL || c == WONT || c == DO || c == DONT) { s.telnet = 2; continue; }
+          s.telnet = (c == SB) ? 3 : 0;
+          continue;
+        case 2: s.telnet = 0; continue;   // option byte
+        case 3: if (c == IAC) s.telnet = 4; continue;
+        case 4: s.telnet = (c == SE) ? 0 : 3; continue;
+        default: break;
+      }
+      if (c == IAC) { s.telnet = 1; continue; }
+
+      if (c == '\n' && s.lastCR) { s.lastCR = false; continue; }
+      s.lastCR = (c == '\r');
+      if (c == '\r' || c == '\n') {
+        std::string line = trim(s.ibuf);
+        s.ibuf.clear();
+        onLine(s, line);
+        if (s.dead) return;
+        promptDirty = true;
+        continue;
+      }
+      if (c == 8 || c == 127) { if (!s.ibuf.empty()) s.ibuf.pop_back(); promptDirty = true; continue; }
+      if (c == 27) { s.ibuf.clear(); promptDirty = true; continue; }
+      if (c < 32 || c > 126) continue;
+      if (s.ibuf.size() < kMaxLine) { s.ibuf.push_back(char(c)); promptDirty = true; }
+    }
+
+    if (promptDirty) {
+      moveTo(s.outbuf, kPromptRow);
+      s.outbuf += s.user.empty() ? "name: " : "> ";
+      s.outbuf += s.ibuf;
+      flush(s);
+    }
+  }
+}
+
+void TuiGateway::openStream(Session& s){
+  auto st = std::make_unique<Stream>(*this, s.id);
+  s.stream = st.get();
+  streams_.emplace(s.id, std::move(st));
+  s.stream->start(*stub_);
+
+  proto::Envelope j;
+  j.mutable_cmd()->mutable_join_match()->set_match_id(opt_.match_id);
+  j.mutable_cmd()->mutable_join_match()->set_role(proto::JoinMatch::PLAYER);
+  send(s, j);
+  proto::Envelope rq;
+  rq.mutable_cmd()->mutable_request_snapshot();
+  send(s, rq);
+}
+
+void TuiGateway::send(Session& s, proto::Envelope& e){
+  if (!s.stream) { s.msg = "not connected to server"; return; }
+  auto* h = e.mutable_header();
+  h->set_proto_version(1);
+  h->set_match_id(opt_.match_id);
+  h->set_user_id(s.user);
+  s.stream->send(e);
+}
+
+void TuiGateway::onLine(Session& s, const std::string& line){
+  if (s.user.empty()) {
+    if (line.empty()) return;
+    s.user = line.substr(0, 32);
+    log_.info(EventType::UserLogin, s.user, "gateway session " + std::to_string(s.id));
+    s.msg = "connected (type 'help')";
+    openStream(s);
+    repaint(s, false);
+    return;
+  }
+
+  if (line == "quit" || line == "exit") { s.dead = "quit"; return; }
+  if (line == "redraw") { repaint(s, true); return; }
+  if (line == "help") {
+    s.msg = "two numbers=step, 'step a b', Enter=commit, 'roll', 'set d1 d2', 'undo', 'double', 'take', 'drop', 'snap', 'redraw', 'quit'";
+    repaint(s, false);
+    return;
+  }
+
+  proto::Envelope e;
+  auto* cmd = e.mutable_cmd();
+  int a = 0, b = 0;
+  std::istringstream is(line.rfind("step ", 0) == 0 ? line.substr(5) :
+                        line.rfind("set ", 0) == 0  ? line.substr(4) : line);
+  if (line.empty())                          cmd->mutable_commit_turn();
+  else if (line == "roll")                   cmd->mutable_roll_dice();
+  else if (line == "undo")                   cmd->mutable_undo_step();
+  else if (line == "double")                 cmd->mutable_offer_cube();
+  else if (line == "take")                   cmd->mutable_take_cube();
+  else if (line == "drop")                   cmd->mutable_drop_cube();
+  else if (line == "snap")                   cmd->mutable_request_snapshot();
+  else if (line.rfind("set ", 0) == 0) {
+    if (!(is >> a >> b)) { s.msg = "bad set syntax: 'set d1 d2'"; repaint(s, false); return; }
+    cmd->mutable_set_dice()->set_d1(a);
+    cmd->mutable_set_dice()->set_d2(b);
+  }
+  else if (is >> a >> b) {                   // 'step a b' or two-number shorthand
+    cmd->mutable_apply_step()->set_from(a);
+    cmd->mutable_apply_step()->set_pip(b);
+  }
+  else { s.msg = "unknown command (type 'help')"; repaint(s, false); return; }
+
+  send(s, e);
+  log_.info(EventType::Command, s.user, line.empty() ? "commit" : line);
+}
+
+void TuiGateway::drainInbound(){
+  std::deque<Inbound> batch;
+  {
+    std::lock_guard<std::mutex> lk(in_mu_);
+    batch.swap(inbound_);
+  }
+  for (auto& ev : batch) {
+    auto it = sessions_.find(ev.sid);
+    Session* s = (it == sessions_.end()) ? nullptr : it->second.get();
+
+    if (ev.done) {
+      streams_.erase(ev.sid);
+      if (s) {
+        s->stream = nullptr;
+        s->msg = "server: " + ev.status + " (reconnect to retry)";
+        repaint(*s, false);
+      }
+      continue;
+    }
+    if (!s || !ev.env.has_evt()) continue;
+
+    const auto& e = ev.env.evt();
+    if (e.has_snapshot()) { s->st = e.snapshot().state(); s->haveState = true; s->msg = "snapshot"; }
+    else if (e.has_dice_set())       s->msg = "dice set";
+    else if (e.has_step_applied())   s->msg = "step applied";
+    else if (e.has_step_undone())    s->msg = "step undone";
+    else if (e.has_turn_committed()) s->msg = "turn committed";
+    else if (e.has_error())
+      s->msg = "error " + std::to_string(e.error().code()) + ": " + e.error().message();
+    repaint(*s, false);
+  }
+}
+
+void TuiGateway::repaint(Session& s, bool full){
+  std::string& out = s.outbuf;
+  if (full) {
+    out += "\x1b[0m\x1b[2J";
+    s.board.invalidate();
+    moveTo(out, kTitleRow);
+    out += "bg_gateway — Enter=commit · two numbers or 'step FROM PIP' · 'roll' 'set d1 d2' 'undo' · 'help' · 'quit'";
+  }
+
+  std::string info;
+  if (s.haveState) {
+    Board::State b{};
+    fillBoardState(s.st, b);
+    s.board.render(b, out);
+
+    info = std::string("phase=") + phaseName(s.st.phase()) + "  side=" + sideName(s.st.side_to_move()) + "  dice=[";
+    for (int i = 0; i < s.st.dice_remaining_size(); ++i) {
+      if (i) info += ",";
+      info += std::to_string(s.st.dice_remaining(i));
+    }
+    info += std::string("]  cubeHolder=") + sideName(s.st.cube_holder());
+    if (!s.msg.empty()) info += "  ·  ";
+  }
+  info += s.msg;
+
+  moveTo(out, kStatusRow);
+  out += "\x1b[32m" + info + "\x1b[0m";
+  moveTo(out, kPromptRow);
+  out += s.user.empty() ? "name: " : "> ";
+  out += s.ibuf;
+  flush(s);
+}
+
+void TuiGateway::flush(Session& s){
+#if defined(MSG_NOSIGNAL)
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;   // SIGPIPE is ignored by the gateway's main()
+#endif
+  size_t off = 0;
+  while (off < s.outbuf.size()) {
+    ssize_t n = ::send(s.fd, s.outbuf.data() + off, s.outbuf.size() - off, flags);
+    if (n > 0) { off += size_t(n); continue; }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n < 0 && errno == EINTR) continue;
+    s.dead = "write error";
+    break;
+  }
+  s.outbuf.erase(0, off);
+  if (s.outbuf.size() > opt_.max_outbuf) s.dead = "terminal too slow";
+}
+
+void TuiGateway::close(uint64_t sid, const char* why){
+  auto it = sessions_.find(sid);
+  if (it == sessions_.end()) return;
+  Session& s = *it->second;
+  if (s.stream) s.stream->cancel(); // Stream lingers in streams_ until OnDone
+  ::close(s.fd);
+  log_.info(EventType::System, s.user.empty() ? "-" : s.user,
+            "gateway session " + std::to_string(sid) + " closed: " + why);
+  sessions_.erase(it);
+}
+
+} // namespace BG
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <grpcpp/grpcpp.h>
+#include "logger.hpp"
+
+#include "bg/v1/bg.grpc.pb.h"
+#include "bg/v1/bg.pb.h"
+
+namespace BG {
+
+/**
+ * @brief Terminal gateway: serves many telnet/raw-TCP players from one process.
+ *
+ * One thread polls every terminal socket; each session keeps a line editor,
+ * the last snapshot and an AnsiRenderer frame pair (a few KB in total) and
+ * receives ANSI diffs instead of full repaints. All sessions share a single
+ * gRPC channel to the game server, each holding one callback-driven Stream
+ * RPC multiplexed over it, so no thread is parked per player.
+ */
+class TuiGateway {
+public:
+  struct Options {
+    uint16_t    port = 4000;                   ///< local TCP port for terminals
+    std::string server = "127.0.0.1:50051";    ///< game server address
+    std::string match_id = "m1";               ///< match every session joins
+    size_t      max_sessions = 4096;           ///< further connections are refused
+    size_t      max_outbuf = 256 * 1024;       ///< slow terminals beyond this are dropped
+  };
+
+  TuiGateway(Options opt, Logger& log);
+  ~TuiGateway();
+
+  /** Listen and serve until stop(). Returns non-zero on startup failure. */
+  int run();
+
+  /** Ask run() to return. Thread-safe and async-signal-safe. */
+  void stop();
+
+private:
+  class Stream;
+  struct Session;
+
+  /** Event posted from gRPC callback threads to the poll loop. */
+  struct Inbound {
+    uint64_t sid = 0;
+    bool done = false;          ///< stream finished (Stream may be destroyed)
+    std::string status;         ///< final status text when done
+    ::bg::v1::Envelope env;
+  };
+
+  void post(Inbound ev);                // any thread
+  void wake();                          // any thread
+  void drainInbound();                  // loop thread
+  void accept_();
+  void onReadable(Session& s);
+  void onLine(Session& s, const std::string& line);
+  void openStream(Session& s);
+  void send(Session& s, ::bg::v1::Envelope& e);
+  void repaint(Session& s, bool full);
+  void flush(Session& s);
+  void close(uint64_t sid, const char* why);
+
+  Options opt_;
+  Logger& log_;
+  std::shared_ptr<::grpc::Channel> chan_;
+  std::unique_ptr<::bg::v1::MatchService::Stub> stub_;
+
+  int listen_fd_ = -1;
+  int wake_rd_ = -1, wake_wr_ = -1;
+  std::atomic<bool> stop_{false};
+
+  uint64_t next_sid_ = 1;
+  std::unordered_map<uint64_t, std::unique_ptr<Session>> sessions_;
+  std::unordered_map<uint64_t, std::unique_ptr<Stream>>  streams_;   ///< live until OnDone
+
+  std::mutex in_mu_;
+  std::deque<Inbound> inbound_;
+};
+
+} // namespace BG
@@ -0,0 +1,181 @@
+/**
+ * @file tdtrain.cpp
+ * @brief Self-play TD(lambda) workers, shared-weight updates and evaluator benchmarking.
+ */
+
+#include "tdtrain.hpp"
+#include "arena.hpp"
+#include "rollout.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace BG {
+
+namespace {
+
+constexpr size_t K = Evaluator::kOutputs;
+constexpr size_t S = Evaluator::kStride;
+
+/// Raw sigmoid outputs (no gammon clamping) for features @p x.
+void rawOutputs(const std::vector<float> &w, const float *x, float *y) {
+    for (size_t o=0; o<K; ++o) {
+        const float *r = &w[o*S];
+        float acc = r[Evaluator::kInputs];
+        for (size_t i=0; i<Evaluator::kInputs; ++i) acc += r[i]*x[i];
+        y[o] = sigmoid(acc);
+    }
+}
+
+} // namespace
+
+struct TDTrainer::Worker {
+    Evaluator local;
+    std::vector<float> trace[2];
+    std::array<float, K> prev[2];
+    bool have[2];
+    std::vector<ScoredPlay> plays;
+    float x[Evaluator::kInputs];
+
+    explicit Worker(const Evaluator &proto) : local(proto) {
+        trace[0].assign(K*S, 0.f); trace[1].assign(K*S, 0.f);
+    }
+};
+
+TDTrainer::TDTrainer(const Evaluator &init, const TrainOptions &opt)
+    : _opt(opt), _proto(init), _w(init.weights()) {}
+
+void TDTrainer::load(std::vector<float> &local) const {
+    for (size_t i=0; i<_w.size(); ++i) local[i] = std::atomic_ref<float>(_w[i]).load(std::memory_order_relaxed);
+}
+
+void TDTrainer::add(size_t i, float delta) {
+    std::atomic_ref<float> r(_w[i]);
+    r.store(r.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+Evaluator TDTrainer::snapshot() const {
+    Evaluator e = _proto;
+    load(e.weights());
+    e.generation = _proto.generation + _generation.load();
+    return e;
+}
+
+void TDTrainer::playGame(uint64_t game, Worker &w) {
+    RolloutDice dice(DiceMode::Random, 0, _opt.seed, game);
+    Search search(w.local);
+    for (int s=0; s<2; ++s) { std::fill(w.trace[s].begin(), w.trace[s].end(), 0.f); w.have[s] = false; }
+
+    // w += alpha * delta_o * trace_o for each output o of side s.
+    auto update = [&](int s, const float *target) {
+        for (size_t o=0; o<K; ++o) {
+            float step = _opt.alpha * (target[o] - w.prev[s][o]);
+            if (step==0.f) continue;
+            const float *e = &w.trace[s][o*S];
+            for (size_t i=0; i<S; ++i) if (e[i]!=0.f) add(o*S+i, step*e[i]);
+        }
+    };
+
+    Position p = Position::initial();
+    for (unsigned turn=0; turn<_opt.maxTurns; ++turn) {
+        const int s = int(turn & 1);
+        load(w.local.weights());
+
+        float y[K];
+        Evaluator::features(p, w.x);
+        rawOutputs(w.local.weights(), w.x, y);
+        if (w.have[s]) update(s, y);
+        for (size_t o=0; o<K; ++o) {
+            float g = y[o]*(1.f-y[o]);
+            float *e = &w.trace[s][o*S];
+            for (size_t i=0; i<Evaluator::kInputs; ++i) e[i] = _opt.lambda*e[i] + g*w.x[i];
+            e[Evaluator::kInputs] = _opt.lambda*e[Evaluator::kInputs] + g;
+            w.prev[s][o] = y[o];
+        }
+        w.have[s] = true;
+
+        int d1, d2;
+        dice.roll(turn, d1, d2);
+        search.hint(p, d1, d2, 0, 1, w.plays);
+        const Position &after = w.plays.front().cand.after;
+        if (after.finished(0)) {
+            bool gammon = after.winMultiplier(0)>=2;
+            float winZ[K]  = {1.f, gammon ? 1.f : 0.f, 0.f};
+            float loseZ[K] = {0.f, 0.f, gammon ? 1.f : 0.f};
+            update(s, winZ);
+            if (w.have[1-s]) update(1-s, loseZ);
+            _turns += turn+1;
+            return;
+        }
+        p = after.swapped();
+    }
+    _turns += _opt.maxTurns;
+}
+
+void TDTrainer::run(const std::function<void(const TrainProgress&)> &onSnapshot) {
+    unsigned threads = _opt.threads ? _opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    auto t0 = std::chrono::steady_clock::now();
+    std::mutex snapMu;
+    std::exception_ptr failure;
+    std::atomic<bool> stop{false};
+
+    auto takeSnapshot = [&]{
+        std::lock_guard<std::mutex> lk(snapMu);
+        ++_generation;
+        Evaluator e = snapshot();
+        TrainProgress pr;
+        pr.games = _done.load(); pr.turns = _turns.load();
+        pr.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        pr.snapshot = &e;
+        onSnapshot(pr);
+    };
+
+    auto worker = [&]{
+        try {
+            Worker w(_proto);
+            for (uint64_t g; !stop && (g = _next.fetch_add(1)) < _opt.games; ) {
+                playGame(g, w);
+                uint64_t done = ++_done;
+                if (_opt.snapshotEvery && done % _opt.snapshotEvery==0 && done<_opt.games) takeSnapshot();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(snapMu);
+            if (!failure) failure = std::current_exception();
+            stop = true;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t=0; t<threads; ++t) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+    if (failure) std::rethrow_exception(failure);
+    takeSnapshot();
+}
+
+double benchmarkEvaluators(const Evaluator &a, const Evaluator &b, uint64_t games, uint64_t seed,
+                           unsigned threads, unsigned maxTurns) {
+    uint64_t pairs = (games+1)/2;
+    std::vector<int> points(2*pairs, 0);
+    Search sa(a), sb(b);
+    {
+        ThreadPool pool(threads);
+        pool.parallelFor(2*pairs, [&](size_t g){
+            RolloutDice dice(DiceMode::Random, 0, seed, g/2);
+            ArenaPlayer side[2];                // side[0] moves first
+            side[0].search = g%2 ? &sb : &sa;
+            side[1].search = g%2 ? &sa : &sb;
+            unsigned turn = 0;
+            ArenaGame r = playArenaGame(side, dice, turn, maxTurns);
+            points[g] = g%2 ? -r.points : r.points;
+        });
+    }
+    long total = 0;
+    for (int v : points) total += v;
+    return double(total) / double(points.size());
+}
+
+} // namespace BG
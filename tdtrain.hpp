@@ -0,0 +1,100 @@
+/**
+ * @file tdtrain.hpp
+ * @brief TD(lambda) self-play training of Evaluator weights, Hogwild style.
+ */
+
+#ifndef TDTRAIN_HPP
+#define TDTRAIN_HPP
+
+#include "evaluator.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @struct TrainOptions
+ * @brief Self-play training settings.
+ */
+struct TrainOptions {
+    uint64_t games = 100000;        ///< self-play games to train on
+    unsigned threads = 0;           ///< 0 = hardware concurrency
+    float alpha = 0.01f;            ///< learning rate
+    float lambda = 0.7f;            ///< trace decay
+    uint64_t snapshotEvery = 10000; ///< games between snapshots (0 = only at the end)
+    unsigned maxTurns = 5000;       ///< abandon (without a final update) games longer than this
+    uint64_t seed = 1;
+};
+
+/**
+ * @struct TrainProgress
+ * @brief Passed to the snapshot callback.
+ */
+struct TrainProgress {
+    uint64_t games=0;               ///< games finished so far
+    uint64_t turns=0;               ///< turns played so far
+    double seconds=0.0;             ///< since run() started
+    const Evaluator *snapshot=nullptr;
+};
+
+/**
+ * @class TDTrainer
+ * @brief Many threads play greedy 0-ply self-play games and update one shared weight vector.
+ *
+ * Each side learns from its own consecutive positions (before its rolls):
+ * the three outputs move toward their value at the side's next turn and,
+ * at the end, toward the actual result, through per-side eligibility
+ * traces over the raw sigmoid units.
+ *
+ * Updates are Hogwild: every thread reads and adds to the shared weights
+ * with relaxed atomic loads and stores and no lock, so concurrent updates
+ * to one weight may occasionally overwrite each other. With sparse
+ * features that loss is rare and costs far less than serialising threads.
+ * Threads refresh a private copy of the weights before every move.
+ */
+class TDTrainer {
+public:
+    /// Start from @p init (its name and generation carry over to snapshots).
+    TDTrainer(const Evaluator &init, const TrainOptions &opt);
+
+    /**
+     * @brief Train; @p onSnapshot runs every @c snapshotEvery games and once at the end.
+     *
+     * The callback runs on the worker thread that crossed the boundary
+     * while the others keep training; the snapshot's generation is bumped
+     * each time. Exceptions from it stop training and are rethrown.
+     */
+    void run(const std::function<void(const TrainProgress&)> &onSnapshot);
+
+    /// Current weights as an Evaluator (consistent enough for a snapshot while training).
+    Evaluator snapshot() const;
+
+private:
+    struct Worker;
+
+    TrainOptions _opt;
+    Evaluator _proto;
+    mutable std::vector<float> _w;          ///< shared weights, accessed only through atomic_ref
+    std::atomic<uint64_t> _next{0}, _done{0}, _turns{0};
+    std::atomic<uint32_t> _generation{0};
+
+    void load(std::vector<float> &local) const;
+    void add(size_t i, float delta);
+    void playGame(uint64_t game, Worker &w);
+};
+
+/**
+ * @brief Mean points per game won by @p a against @p b over 0-ply games.
+ *
+ * Games are played in pairs on the same dice with colours (and first
+ * move) swapped, so most dice luck cancels. @p games is rounded up to even.
+ */
+double benchmarkEvaluators(const Evaluator &a, const Evaluator &b, uint64_t games, uint64_t seed,
+                           unsigned threads = 0, unsigned maxTurns = 5000);
+
+} // namespace BG
+
+#endif // TDTRAIN_HPP
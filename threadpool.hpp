@@ -0,0 +1,162 @@
+/**
+ * @file threadpool.hpp
+ * @brief Small work-stealing thread pool for the batch tools.
+ */
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @class ThreadPool
+ * @brief Per-worker task deques with stealing.
+ *
+ * A worker pops its own newest task (LIFO, cache-warm) and, when idle,
+ * steals the oldest task of another worker (FIFO, usually the largest
+ * remaining piece). Tasks submitted from a worker go to that worker's deque;
+ * external submissions are dealt round-robin. The first exception thrown by
+ * a task is rethrown by wait().
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0) {
+        unsigned n = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i=0; i<n; ++i) _queues.push_back(std::make_unique<Queue>());
+        for (unsigned i=0; i<n; ++i) _threads.emplace_back([this, i]{ run(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(_mu);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto &t : _threads) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return unsigned(_threads.size()); }
+
+    /// Queue a task; callable from any thread, including pool workers.
+    void submit(std::function<void()> fn) {
+        size_t q = (tlPool()==this) ? tlIndex() : _next.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+        _pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lk(_mu);
+            ++_queued;              // counted first so a taker never sees the task uncounted
+        }
+        {
+            std::lock_guard<std::mutex> lk(_queues[q]->mu);
+            _queues[q]->tasks.push_back(std::move(fn));
+        }
+        _wake.notify_one();
+    }
+
+    /// Block until every submitted task has finished; rethrows the first task exception.
+    /// Must not be called from a pool task.
+    void wait() {
+        std::unique_lock<std::mutex> lk(_mu);
+        _done.wait(lk, [&]{ return _pending.load()==0; });
+        if (_error) {
+            std::exception_ptr e = _error;
+            _error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    /**
+     * @brief Run fn(i) for i in [0, n) and wait.
+     *
+     * Indices are grouped into chunks of @p grain so cheap bodies do not pay
+     * a task per element; stealing balances uneven chunks.
+     */
+    template <class F>
+    void parallelFor(size_t n, F &&fn, size_t grain = 1) {
+        grain = std::max<size_t>(1, grain);
+        for (size_t b=0; b<n; b+=grain) {
+            size_t e = std::min(n, b+grain);
+            submit([&fn, b, e]{ for (size_t i=b; i<e; ++i) fn(i); });
+        }
+        wait();
+    }
+
+private:
+    struct Queue {
+        std::mutex mu;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::atomic<size_t> _next{0};
+    std::atomic<size_t> _pending{0};   ///< submitted and not yet finished
+
+    std::mutex _mu;                    ///< guards _queued, _stop, _error
+    std::condition_variable _wake, _done;
+    size_t _queued = 0;                ///< submitted and not yet taken
+    bool _stop = false;
+    std::exception_ptr _error;
+
+    static ThreadPool *&tlPool() { static thread_local ThreadPool *p = nullptr; return p; }
+    static size_t &tlIndex() { static thread_local size_t i = 0; return i; }
+
+    bool take(size_t self, std::function<void()> &out) {
+        {
+            Queue &q = *_queues[self];
+            std::lock_guard<std::mutex> lk(q.mu);
+            if (!q.tasks.empty()) { out = std::move(q.tasks.back()); q.tasks.pop_back(); return true; }
+        }
+        for (size_t k=1; k<_queues.size(); ++k) {
+            Queue &q = *_queues[(self+k) % _queues.size()];
+            std::lock_guard<std::mutex> lk(q.mu);
+            if (!q.tasks.empty()) { out = std::move(q.tasks.front()); q.tasks.pop_front(); return true; }
+        }
+        return false;
+    }
+
+    void run(size_t self) {
+        tlPool() = this;
+        tlIndex() = self;
+        std::function<void()> task;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(_mu);
+                _wake.wait(lk, [&]{ return _queued>0 || _stop; });
+                if (_queued==0 && _stop) return;
+            }
+            if (!take(self, task)) continue;   // lost the race to another worker
+            {
+                std::lock_guard<std::mutex> lk(_mu);
+                --_queued;
+            }
+            try { task(); }
+            catch (...) {
+                std::lock_guard<std::mutex> lk(_mu);
+                if (!_error) _error = std::current_exception();
+            }
+            task = nullptr;
+            if (_pending.fetch_sub(1, std::memory_order_acq_rel)==1) {
+                std::lock_guard<std::mutex> lk(_mu);
+                _done.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace BG
+
+#endif // THREADPOOL_HPP
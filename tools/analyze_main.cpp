@@ -0,0 +1,261 @@
+/**
+ * @file analyze_main.cpp
+ * @brief bg_analyze: equity loss of every checker play in record archives.
+ *
+ * Usage: bg_analyze [-j threads] [-p plies] [-w weights] [--cache file] [-g games-per-chunk]
+ *                   [--fresh] -o out.bgc archive.bgr...
+ *
+ * Games are taken in archive order and analyzed a chunk at a time on a
+ * work-stealing pool. Each chunk becomes one row group of the column file
+ * (one row per checker decision with more than one legal play), after which
+ * OUT.ckpt records the games done, the file length and the running
+ * per-player totals. Rerunning the same command resumes from there.
+ * Per-player error rates go to OUT.players.tsv. With --cache, searched equities
+ * are shared through a persistent EvalCache, so positions seen by earlier
+ * runs (or by concurrent ones) are not searched again.
+ */
+
+#include "archivegames.hpp"
+#include "columnar.hpp"
+#include "evalcache.hpp"
+#include "evaluator.hpp"
+#include "gamerecord.hpp"
+#include "position.hpp"
+#include "search.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+namespace {
+
+constexpr double kError   = 0.04;   ///< loss counted as an error
+constexpr double kBlunder = 0.16;   ///< loss counted as a blunder
+
+struct Row {
+    uint64_t gameId;
+    uint32_t move;
+    uint8_t  player, dice;
+    uint16_t candidates, rank;
+    float    eqPlayed, eqBest, loss;
+};
+
+struct PlayerStats {
+    uint64_t decisions=0, errors=0, blunders=0;
+    double loss=0.0;
+
+    void add(double l) {
+        ++decisions; loss += l;
+        if (l>=kError) ++errors;
+        if (l>=kBlunder) ++blunders;
+    }
+};
+
+const std::vector<ColumnSpec> SCHEMA = {
+    {"game_id", ColType::U64}, {"move", ColType::U32}, {"player", ColType::U8}, {"dice", ColType::U8},
+    {"candidates", ColType::U16}, {"rank", ColType::U16},
+    {"eq_played", ColType::F32}, {"eq_best", ColType::F32}, {"loss", ColType::F32},
+};
+
+struct Checkpoint {
+    uint64_t games=0, bytes=0;
+    unsigned plies=0;
+    std::string evaluator;
+    std::map<std::string, PlayerStats> players;
+};
+
+bool loadCheckpoint(const std::string &path, Checkpoint &ck) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line, tag;
+    if (!std::getline(in, line) || line!="bg_analyze-checkpoint 1") throw std::runtime_error(path + ": not a checkpoint");
+    while (std::getline(in, line)) {
+        std::istringstream ls(line);
+        ls >> tag;
+        if (tag=="games") ls >> ck.games;
+        else if (tag=="bytes") ls >> ck.bytes;
+        else if (tag=="plies") ls >> ck.plies;
+        else if (tag=="evaluator") { ls >> std::ws; std::getline(ls, ck.evaluator); }
+        else if (tag=="player") {
+            PlayerStats s; std::string name;
+            ls >> s.decisions >> s.errors >> s.blunders >> s.loss >> std::ws;
+            std::getline(ls, name);
+            ck.players[name] = s;
+        }
+    }
+    return true;
+}
+
+void saveCheckpoint(const std::string &path, const Checkpoint &ck) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out.precision(17);
+        out << "bg_analyze-checkpoint 1\n"
+            << "games " << ck.games << "\n"
+            << "bytes " << ck.bytes << "\n"
+            << "plies " << ck.plies << "\n"
+            << "evaluator " << ck.evaluator << "\n";
+        for (const auto &[name, s] : ck.players)
+            out << "player " << s.decisions << ' ' << s.errors << ' ' << s.blunders << ' ' << s.loss << ' ' << name << "\n";
+        out.flush();
+        if (!out) throw std::runtime_error(tmp + ": write failed");
+    }
+    std::filesystem::rename(tmp, path);
+}
+
+struct GameResult {
+    std::vector<Row> rows;
+    std::string white, black;
+};
+
+void analyzeGame(const std::vector<RecordEvent> &game, const Search &search, unsigned plies, GameResult &out) {
+    const GameHeader &h = game.front().header;
+    out.white = h.white.empty() ? "(white)" : h.white;
+    out.black = h.black.empty() ? "(black)" : h.black;
+
+    Board b;
+    Board::State st;
+    std::vector<ScoredPlay> scored;
+    int d1=0, d2=0;
+    uint32_t move=0;
+    for (const RecordEvent &ev : game) {
+        if (ev.type==RecordEvent::Type::Roll || ev.type==RecordEvent::Type::OpeningRoll) { d1=ev.d1; d2=ev.d2; }
+        if (ev.type!=RecordEvent::Type::Play) {
+            if (!replayEvent(b, ev)) return;
+            continue;
+        }
+
+        Side mover = b.sideToMove();
+        b.getState(st);
+        Position pos = Position::fromState(st, mover);
+        search.rankPlays(pos, d1, d2, plies, scored);
+        if (!replayEvent(b, ev)) return;
+        uint32_t m = move++;
+        if (scored.size()<2) continue;
+
+        b.getState(st);
+        Position after = Position::fromState(st, mover);
+        auto it = std::find_if(scored.begin(), scored.end(), [&](const ScoredPlay &s){ return s.cand.after==after; });
+        if (it==scored.end()) continue;   // cannot happen for a replayable game
+        double played = it->plies==plies ? it->equity : search.playEquity(after, plies);
+        double best = std::max(scored.front().equity, played);
+        out.rows.push_back({h.gameId, m, uint8_t(mover==BLACK), uint8_t(std::max(d1,d2)*10 + std::min(d1,d2)),
+                            uint16_t(scored.size()), uint16_t(it-scored.begin()),
+                            float(played), float(best), float(best-played)});
+    }
+}
+
+int usage() {
+    std::cerr << "usage: bg_analyze [-j threads] [-p plies] [-w weights] [--cache file] [-g games-per-chunk]\n"
+                 "                  [--fresh] -o out.bgc archive.bgr...\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string outPath, weights, cachePath;
+    unsigned threads=0, plies=0;
+    size_t chunk=2000;
+    bool fresh=false;
+    std::vector<std::string> inputs;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-o" && i+1<argc) outPath = argv[++i];
+        else if (a=="-j" && i+1<argc) threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-p" && i+1<argc) plies = unsigned(std::stoul(argv[++i]));
+        else if (a=="-w" && i+1<argc) weights = argv[++i];
+        else if (a=="--cache" && i+1<argc) cachePath = argv[++i];
+        else if (a=="-g" && i+1<argc) chunk = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (a=="--fresh") fresh = true;
+        else if (a=="-h" || a=="--help") return usage();
+        else inputs.push_back(a);
+    }
+    if (outPath.empty() || inputs.empty()) return usage();
+
+    try {
+        Evaluator ev = weights.empty() ? Evaluator() : Evaluator::load(weights);
+        Search search(ev);
+        std::unique_ptr<EvalCache> cache;
+        if (!cachePath.empty()) { cache = std::make_unique<EvalCache>(cachePath, ev); search.setCache(cache.get()); }
+        std::string evalId = ev.name + " " + std::to_string(ev.generation);
+
+        const std::string ckPath = outPath + ".ckpt";
+        Checkpoint ck;
+        if (!fresh && loadCheckpoint(ckPath, ck)) {
+            if (ck.plies!=plies || ck.evaluator!=evalId)
+                throw std::runtime_error(ckPath + ": checkpoint was made with different settings (use --fresh)");
+            std::cerr << "bg_analyze: resuming after " << ck.games << " games\n";
+        } else {
+            ck = Checkpoint{};
+            ck.plies = plies; ck.evaluator = evalId;
+        }
+
+        ColumnWriter out(outPath, SCHEMA, ck.bytes);
+        if (ck.bytes==0) { ck.bytes = out.sync(); saveCheckpoint(ckPath, ck); }
+
+        ArchiveGames src(inputs);
+        std::vector<RecordEvent> g;
+        for (uint64_t skip=0; skip<ck.games; ++skip)
+            if (!src.next(g)) throw std::runtime_error("checkpoint is past the end of the input");
+
+        ThreadPool pool(threads);
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t done=0, rowsOut=0;
+        std::vector<std::vector<RecordEvent>> batch;
+        std::vector<GameResult> results;
+        for (;;) {
+            batch.clear();
+            while (batch.size()<chunk && src.next(g)) batch.push_back(std::move(g));
+            if (batch.empty()) break;
+
+            results.assign(batch.size(), GameResult{});
+            pool.parallelFor(batch.size(), [&](size_t i){ analyzeGame(batch[i], search, plies, results[i]); });
+
+            std::vector<uint64_t> gid; std::vector<uint32_t> mv; std::vector<uint8_t> pl, dc;
+            std::vector<uint16_t> nc, rk; std::vector<float> ep, eb, ls;
+            for (const GameResult &r : results) {
+                for (const Row &x : r.rows) {
+                    gid.push_back(x.gameId); mv.push_back(x.move); pl.push_back(x.player); dc.push_back(x.dice);
+                    nc.push_back(x.candidates); rk.push_back(x.rank);
+                    ep.push_back(x.eqPlayed); eb.push_back(x.eqBest); ls.push_back(x.loss);
+                    ck.players[x.player ? r.black : r.white].add(x.loss);
+                }
+            }
+            out.writeGroup(gid.size(), {gid.data(), mv.data(), pl.data(), dc.data(), nc.data(), rk.data(),
+                                        ep.data(), eb.data(), ls.data()});
+            ck.bytes = out.sync();
+            ck.games += batch.size();
+            saveCheckpoint(ckPath, ck);
+            done += batch.size(); rowsOut += gid.size();
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::ofstream tsv(outPath + ".players.tsv", std::ios::trunc);
+        tsv << "player\tdecisions\terrors\tblunders\ttotal_loss\tmean_loss_milli\terror_rate\n";
+        for (const auto &[name, s] : ck.players) {
+            double n = double(std::max<uint64_t>(1, s.decisions));
+            tsv << name << '\t' << s.decisions << '\t' << s.errors << '\t' << s.blunders << '\t'
+                << s.loss << '\t' << 1000.0*s.loss/n << '\t' << double(s.errors)/n << '\n';
+        }
+        std::cerr << "bg_analyze: " << done << " games, " << rowsOut << " decisions in " << secs << " s ("
+                  << ck.games << " games total, " << ck.players.size() << " players)\n";
+        if (cache) std::cerr << "bg_analyze: " << cache->path() << ": " << cache->entries() << " of " << cache->slots() << " slots used\n";
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_analyze: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file archivegames.hpp
+ * @brief Sequential whole-game iteration over several mapped record archives.
+ */
+
+#ifndef ARCHIVEGAMES_HPP
+#define ARCHIVEGAMES_HPP
+
+#include "gamerecord.hpp"
+#include "mappedfile.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BG {
+
+/**
+ * @class ArchiveGames
+ * @brief Yields the games of each archive in turn, mapping one file at a time.
+ */
+class ArchiveGames {
+public:
+    explicit ArchiveGames(std::vector<std::string> paths) : _paths(std::move(paths)) {}
+
+    /// Next game, or false when every archive is exhausted. Throws as RecordReader.
+    bool next(std::vector<RecordEvent> &g) {
+        for (;;) {
+            if (!_games) {
+                if (_i>=_paths.size()) return false;
+                _file = std::make_unique<MappedFile>(_paths[_i++]);
+                _reader = std::make_unique<RecordReader>(_file->data(), _file->size());
+                _games = std::make_unique<GameReader>(*_reader);
+            }
+            if (_games->next(g)) return true;
+            _games.reset(); _reader.reset(); _file.reset();
+        }
+    }
+
+private:
+    std::vector<std::string> _paths;
+    size_t _i=0;
+    std::unique_ptr<MappedFile> _file;
+    std::unique_ptr<RecordReader> _reader;
+    std::unique_ptr<GameReader> _games;
+};
+
+} // namespace BG
+
+#endif // ARCHIVEGAMES_HPP
@@ -0,0 +1,148 @@
+/**
+ * @file arena_main.cpp
+ * @brief bg_arena: round-robin strength check between engine configurations.
+ *
+ * Usage: bg_arena [-n games-per-pairing] [-m match-length] [-c] [-j threads] [-s seed]
+ *                 engine engine [engine...]
+ *
+ * An engine is "bootstrap" or a weights file, optionally followed by
+ * ":plies" and "@book.bgb", e.g. "td.bgev:1@open.bgb". Every pairing plays
+ * mirrored pairs: two games (or matches) on the same dice stream with the
+ * engines' seats swapped. Without -m, money games are played and scored
+ * by who wins the game; -c lets each engine handle the cube with
+ * ThresholdCubePolicy. Reports, per pairing, the score, Elo difference
+ * with a 95% interval and points per game, then Bradley-Terry ratings.
+ */
+
+#include "arena.hpp"
+#include "openingbook.hpp"
+#include "threadpool.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+namespace {
+
+struct Engine {
+    std::string spec;
+    Evaluator ev;
+    unsigned plies = 0;
+    std::unique_ptr<OpeningBook> book;
+    std::unique_ptr<Search> search;
+    std::unique_ptr<ThresholdCubePolicy> cube;
+};
+
+std::unique_ptr<Engine> makeEngine(const std::string &spec) {
+    auto e = std::make_unique<Engine>();
+    e->spec = spec;
+    std::string s = spec, bookPath;
+    if (auto at = s.find('@'); at!=std::string::npos) { bookPath = s.substr(at+1); s.resize(at); }
+    if (auto colon = s.rfind(':'); colon!=std::string::npos) { e->plies = unsigned(std::stoul(s.substr(colon+1))); s.resize(colon); }
+    if (s!="bootstrap") e->ev = Evaluator::load(s);
+    e->search = std::make_unique<Search>(e->ev);
+    if (!bookPath.empty()) { e->book = std::make_unique<OpeningBook>(bookPath); e->search->setBook(e->book.get()); }
+    e->cube = std::make_unique<ThresholdCubePolicy>(*e->search, 0);
+    return e;
+}
+
+int usage() {
+    std::cerr << "usage: bg_arena [-n games-per-pairing] [-m match-length] [-c] [-j threads] [-s seed]\n"
+                 "                engine engine [engine...]\n"
+                 "       engine = bootstrap | weights.bgev[:plies][@book.bgb]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint64_t games = 2000, seed = 1;
+    unsigned matchLength = 0, threads = 0;
+    bool cubeful = false;
+    std::vector<std::string> specs;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-n" && i+1<argc) games = std::stoull(argv[++i]);
+        else if (a=="-m" && i+1<argc) matchLength = unsigned(std::stoul(argv[++i]));
+        else if (a=="-j" && i+1<argc) threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-s" && i+1<argc) seed = std::stoull(argv[++i]);
+        else if (a=="-c") cubeful = true;
+        else if (a=="-h" || a=="--help") return usage();
+        else specs.push_back(a);
+    }
+    if (specs.size()<2) return usage();
+
+    try {
+        std::vector<std::unique_ptr<Engine>> engines;
+        for (const std::string &s : specs) engines.push_back(makeEngine(s));
+        const size_t n = engines.size();
+        std::vector<std::vector<double>> wins(n, std::vector<double>(n, 0.0));
+
+        ThreadPool pool(threads);
+        const uint64_t pairs = (games+1)/2;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t a=0; a<n; ++a) {
+            for (size_t b=a+1; b<n; ++b) {
+                ArenaPlayer pa{engines[a]->search.get(), engines[a]->plies, cubeful ? engines[a]->cube.get() : nullptr};
+                ArenaPlayer pb{engines[b]->search.get(), engines[b]->plies, cubeful ? engines[b]->cube.get() : nullptr};
+                std::vector<double> score(2*pairs, 0.0);   // for engine a
+                std::vector<int> points(2*pairs, 0);
+                pool.parallelFor(2*pairs, [&](size_t g){
+                    // Seat swap within a pair; the dice stream belongs to the pair.
+                    RolloutDice dice(DiceMode::Stratified, 2, seed, g/2);
+                    const bool aFirst = g%2==0;
+                    const ArenaPlayer seats[2] = { aFirst ? pa : pb, aFirst ? pb : pa };
+                    if (matchLength) {
+                        bool firstWon = playArenaMatch(seats, matchLength, dice);
+                        score[g] = firstWon==aFirst ? 1.0 : 0.0;
+                    } else {
+                        unsigned turn = 0;
+                        ArenaGame r = playArenaGame(seats, dice, turn);
+                        int pts = aFirst ? r.points : -r.points;
+                        points[g] = pts;
+                        score[g] = pts>0 ? 1.0 : pts<0 ? 0.0 : 0.5;
+                    }
+                });
+
+                std::vector<double> pairScore(pairs);
+                double totalPts = 0.0, won = 0.0;
+                for (uint64_t k=0; k<pairs; ++k) pairScore[k] = 0.5*(score[2*k] + score[2*k+1]);
+                for (size_t g=0; g<score.size(); ++g) { won += score[g]; totalPts += points[g]; }
+                wins[a][b] += won;
+                wins[b][a] += double(score.size()) - won;
+
+                EloEstimate e = eloFromPairs(pairScore);
+                char line[240];
+                std::snprintf(line, sizeof line, "%s vs %s: score %.3f  Elo %+.1f [%+.1f, %+.1f]",
+                              engines[a]->spec.c_str(), engines[b]->spec.c_str(), e.score, e.elo, e.lo, e.hi);
+                std::cout << line;
+                if (!matchLength) {
+                    std::snprintf(line, sizeof line, "  %+.3f ppg", totalPts/double(score.size()));
+                    std::cout << line;
+                }
+                std::cout << "  (" << score.size() << (matchLength ? " matches)\n" : " games)\n");
+            }
+        }
+
+        if (n>2) {
+            std::vector<double> elo = bradleyTerryElo(wins);
+            std::cout << "ratings (Bradley-Terry, " << engines[0]->spec << " = 0):\n";
+            for (size_t i=0; i<n; ++i) {
+                char line[160];
+                std::snprintf(line, sizeof line, "  %+8.1f  %s", elo[i], engines[i]->spec.c_str());
+                std::cout << line << "\n";
+            }
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cerr << "bg_arena: " << secs << " s\n";
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_arena: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file book_main.cpp
+ * @brief bg_book: build and consult the opening book.
+ *
+ * Usage:
+ * @code
+ *   bg_book build [-j threads] [-d moves] [-p plies] [-x expand] [-w weights] -o book.bgb
+ *   bg_book show book.bgb
+ *   bg_book hint [-b book.bgb] [-p plies] [-w weights] [-n plays] [--cache file] <key-hex | XGID> [dice]
+ * @endcode
+ * "show" prints the booked opening plays; "hint" answers one position the
+ * way a bot would (book first, then search). Keys are PositionKey hex as
+ * printed by "bg_index key", with WHITE on roll, or an XGID line; dice are
+ * two digits, e.g. 31, and may be left out when the XGID has them.
+ */
+
+#include "evalcache.hpp"
+#include "openingbook.hpp"
+#include "positionkey.hpp"
+#include "xgid.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+static int usage() {
+    std::cerr << "usage: bg_book build [-j threads] [-d moves] [-p plies] [-x expand] [-w weights] -o book.bgb\n"
+                 "       bg_book show book.bgb\n"
+                 "       bg_book hint [-b book.bgb] [-p plies] [-w weights] [-n plays] [--cache file] <key-hex | XGID> [dice]\n";
+    return 2;
+}
+
+static void printPlays(const std::vector<ScoredPlay> &plays) {
+    for (const ScoredPlay &sp : plays) {
+        char eq[32]; std::snprintf(eq, sizeof eq, "%+.4f", sp.equity);
+        std::cout << "  " << eq << "  " << (sp.cand.move.n ? sp.cand.move.text() : std::string("(no move)"))
+                  << "  [" << sp.plies << "-ply]\n";
+    }
+}
+
+static int build(int argc, char **argv) {
+    BookOptions opt;
+    std::string out, weights;
+    for (int i=0; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-o" && i+1<argc) out = argv[++i];
+        else if (a=="-j" && i+1<argc) opt.threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-d" && i+1<argc) opt.depth = unsigned(std::stoul(argv[++i]));
+        else if (a=="-p" && i+1<argc) opt.plies = unsigned(std::stoul(argv[++i]));
+        else if (a=="-x" && i+1<argc) opt.expand = unsigned(std::stoul(argv[++i]));
+        else if (a=="-w" && i+1<argc) weights = argv[++i];
+        else return usage();
+    }
+    if (out.empty()) return usage();
+
+    Evaluator ev = weights.empty() ? Evaluator() : Evaluator::load(weights);
+    Search search(ev);
+    auto t0 = std::chrono::steady_clock::now();
+    BookBuildStats st = buildOpeningBook(search, out, opt);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cerr << "bg_book: " << st.positions << " positions, " << st.entries << " entries in "
+              << st.slots << " slots (" << secs << " s)\n";
+    return 0;
+}
+
+static int show(const std::string &path) {
+    OpeningBook book(path);
+    std::cout << path << ": " << book.entries() << " entries, " << book.depth() << " moves deep, "
+              << book.plies() << "-ply, evaluator " << book.evaluator() << " " << book.generation() << "\n";
+    Position start = Position::initial();
+    std::vector<ScoredPlay> plays;
+    for (int hi=2; hi<=6; ++hi) {
+        for (int lo=1; lo<hi; ++lo) {
+            std::cout << hi << lo << ":\n";
+            if (book.lookup(start, hi, lo, plays)) printPlays(plays);
+            else std::cout << "  (not booked)\n";
+        }
+    }
+    return 0;
+}
+
+static int hint(int argc, char **argv) {
+    std::string bookPath, weights, cachePath;
+    unsigned plies=0;
+    size_t n=5;
+    std::vector<std::string> args;
+    for (int i=0; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-b" && i+1<argc) bookPath = argv[++i];
+        else if (a=="-p" && i+1<argc) plies = unsigned(std::stoul(argv[++i]));
+        else if (a=="-w" && i+1<argc) weights = argv[++i];
+        else if (a=="-n" && i+1<argc) n = std::stoul(argv[++i]);
+        else if (a=="--cache" && i+1<argc) cachePath = argv[++i];
+        else args.push_back(a);
+    }
+    if (args.empty() || args.size()>2) return usage();
+    Board::State st;
+    Side onRoll = WHITE;
+    int d1=0, d2=0;
+    PositionKey k;
+    Xgid x;
+    if (parseXgid(args[0], x)) { st = x.state; onRoll = x.turn; d1 = x.d1; d2 = x.d2; }
+    else if (PositionKey::parseHex(args[0], k)) k.toState(st);
+    else return usage();
+    if (args.size()==2) {
+        if (args[1].size()!=2) return usage();
+        d1 = args[1][0]-'0'; d2 = args[1][1]-'0';
+    }
+    if (d1<1 || d1>6 || d2<1 || d2>6) return usage();
+    Position p = Position::fromState(st, onRoll);
+
+    Evaluator ev = weights.empty() ? Evaluator() : Evaluator::load(weights);
+    Search search(ev);
+    std::unique_ptr<OpeningBook> book;
+    if (!bookPath.empty()) { book = std::make_unique<OpeningBook>(bookPath); search.setBook(book.get()); }
+    std::unique_ptr<EvalCache> cache;
+    if (!cachePath.empty()) { cache = std::make_unique<EvalCache>(cachePath, ev); search.setCache(cache.get()); }
+
+    std::vector<ScoredPlay> plays;
+    auto t0 = std::chrono::steady_clock::now();
+    search.hint(p, d1, d2, plies, n, plays);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    printPlays(plays);
+    std::cerr << "bg_book: " << us << " us\n";
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc<2) return usage();
+    std::string cmd = argv[1];
+    try {
+        if (cmd=="build") return build(argc-2, argv+2);
+        if (cmd=="show" && argc==3) return show(argv[2]);
+        if (cmd=="hint") return hint(argc-2, argv+2);
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_book: " << ex.what() << "\n";
+        return 1;
+    }
+    return usage();
+}
@@ -0,0 +1,182 @@
+/**
+ * @file export_main.cpp
+ * @brief bg_export: game records to a column file for analytics.
+ *
+ * Usage: bg_export [-j threads] [-g games-per-group] [-c none|delta|zlib] -o out.bgc archive.bgr...
+ *
+ * One row per checker play or cube action:
+ *  - game_id, ply (action index in the game), player (0 white, 1 black)
+ *  - action (0 play, 1 double, 2 take, 3 drop), dice (high*10+low, 0 for cube actions)
+ *  - play: up to four (from<<3 | pip) bytes, first step in the low byte
+ *  - cube: cube value before the action
+ *  - pos_id_lo/pos_id_hi: 80-bit PositionId seen by the acting player; pos_hash: its
+ *    colour-canonical key hash (same for a position and its mirror with the other side acting)
+ *  - match_length, score_white, score_black, winner (2 = unfinished), points: per-game context
+ *
+ * Each group of games becomes one row group with min/max per column chunk,
+ * so scans on e.g. game_id or match_length can skip whole chunks.
+ */
+
+#include "archivegames.hpp"
+#include "columnar.hpp"
+#include "gamerecord.hpp"
+#include "position.hpp"
+#include "positionkey.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+namespace {
+
+struct Rows {
+    std::vector<uint64_t> gameId, posLo, posHash;
+    std::vector<uint32_t> ply, play;
+    std::vector<uint16_t> cube, posHi, matchLength, scoreWhite, scoreBlack, points;
+    std::vector<uint8_t>  player, action, dice, winner;
+
+    size_t size() const { return gameId.size(); }
+
+    void append(const Rows &o) {
+        auto cat = [](auto &a, const auto &b){ a.insert(a.end(), b.begin(), b.end()); };
+        cat(gameId, o.gameId); cat(posLo, o.posLo); cat(posHash, o.posHash);
+        cat(ply, o.ply); cat(play, o.play);
+        cat(cube, o.cube); cat(posHi, o.posHi); cat(matchLength, o.matchLength);
+        cat(scoreWhite, o.scoreWhite); cat(scoreBlack, o.scoreBlack); cat(points, o.points);
+        cat(player, o.player); cat(action, o.action); cat(dice, o.dice); cat(winner, o.winner);
+    }
+    std::vector<const void*> columns() const {
+        return { gameId.data(), ply.data(), player.data(), action.data(), dice.data(), play.data(),
+                 cube.data(), posLo.data(), posHi.data(), posHash.data(),
+                 matchLength.data(), scoreWhite.data(), scoreBlack.data(), winner.data(), points.data() };
+    }
+};
+
+std::vector<ColumnSpec> schema(ColCodec codec) {
+    std::vector<ColumnSpec> s = {
+        {"game_id", ColType::U64}, {"ply", ColType::U32}, {"player", ColType::U8}, {"action", ColType::U8},
+        {"dice", ColType::U8}, {"play", ColType::U32}, {"cube", ColType::U16},
+        {"pos_id_lo", ColType::U64}, {"pos_id_hi", ColType::U16}, {"pos_hash", ColType::U64},
+        {"match_length", ColType::U16}, {"score_white", ColType::U16}, {"score_black", ColType::U16},
+        {"winner", ColType::U8}, {"points", ColType::U16},
+    };
+    for (ColumnSpec &c : s) c.codec = codec;
+    return s;
+}
+
+void exportGame(const std::vector<RecordEvent> &game, Rows &r) {
+    const GameHeader &h = game.front().header;
+    GameEnd end;
+    for (const RecordEvent &ev : game) if (ev.type==RecordEvent::Type::GameEnd) end = ev.end;
+
+    Board b;
+    Board::State st;
+    int d1=0, d2=0;
+    uint32_t ply=0;
+    for (const RecordEvent &ev : game) {
+        uint8_t action = 0xFF;
+        Side actor = b.sideToMove();
+        switch (ev.type) {
+            case RecordEvent::Type::Roll:
+            case RecordEvent::Type::OpeningRoll: d1 = ev.d1; d2 = ev.d2; break;
+            case RecordEvent::Type::Play:   action = 0; break;
+            case RecordEvent::Type::Double: action = 1; break;
+            case RecordEvent::Type::Take:   action = 2; actor = actor==WHITE ? BLACK : WHITE; break;
+            case RecordEvent::Type::Drop:   action = 3; actor = actor==WHITE ? BLACK : WHITE; break;
+            default: break;
+        }
+        if (action!=0xFF) {
+            b.getState(st);
+            Position pos = Position::fromState(st, actor);
+            PositionId id = PositionId::from(pos);
+            uint32_t packed = 0;
+            if (action==0)
+                for (unsigned k=0; k<ev.play.n; ++k)
+                    packed |= uint32_t(ev.play.steps[k].from<<3 | ev.play.steps[k].pip) << (8*k);
+
+            r.gameId.push_back(h.gameId);
+            r.ply.push_back(ply++);
+            r.player.push_back(actor==BLACK);
+            r.action.push_back(action);
+            r.dice.push_back(action==0 ? uint8_t(std::max(d1,d2)*10 + std::min(d1,d2)) : 0);
+            r.play.push_back(packed);
+            r.cube.push_back(uint16_t(b.cubeValue()));
+            r.posLo.push_back(id.lo);
+            r.posHi.push_back(id.hi);
+            r.posHash.push_back(positionHash(st, actor));
+            r.matchLength.push_back(uint16_t(h.matchLength));
+            r.scoreWhite.push_back(uint16_t(h.scoreWhite));
+            r.scoreBlack.push_back(uint16_t(h.scoreBlack));
+            r.winner.push_back(end.winner==WHITE ? 0 : end.winner==BLACK ? 1 : 2);
+            r.points.push_back(uint16_t(end.points));
+        }
+        if (!replayEvent(b, ev)) return;
+    }
+}
+
+int usage() {
+    std::cerr << "usage: bg_export [-j threads] [-g games-per-group] [-c none|delta|zlib] -o out.bgc archive.bgr...\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string outPath;
+    unsigned threads=0;
+    size_t groupGames=4096;
+    ColCodec codec = ColCodec::Delta;
+    std::vector<std::string> inputs;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-o" && i+1<argc) outPath = argv[++i];
+        else if (a=="-j" && i+1<argc) threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-g" && i+1<argc) groupGames = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (a=="-c" && i+1<argc) {
+            std::string c = argv[++i];
+            if (c=="none") codec = ColCodec::None;
+            else if (c=="delta") codec = ColCodec::Delta;
+            else if (c=="zlib") codec = ColCodec::Zlib;
+            else return usage();
+        }
+        else if (a=="-h" || a=="--help") return usage();
+        else inputs.push_back(a);
+    }
+    if (outPath.empty() || inputs.empty()) return usage();
+
+    try {
+        ColumnWriter out(outPath, schema(codec));
+        ThreadPool pool(threads);
+        ArchiveGames src(inputs);
+        std::vector<std::vector<RecordEvent>> batch;
+        std::vector<Rows> perGame;
+        std::vector<RecordEvent> g;
+        uint64_t games=0, rows=0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (;;) {
+            batch.clear();
+            while (batch.size()<groupGames && src.next(g)) batch.push_back(std::move(g));
+            if (batch.empty()) break;
+            perGame.assign(batch.size(), Rows{});
+            pool.parallelFor(batch.size(), [&](size_t i){ exportGame(batch[i], perGame[i]); }, 16);
+
+            Rows all;
+            for (const Rows &r : perGame) all.append(r);
+            out.writeGroup(all.size(), all.columns());
+            games += batch.size(); rows += all.size();
+        }
+        uint64_t bytes = out.sync();
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cerr << "bg_export: " << games << " games, " << rows << " rows, " << bytes << " bytes ("
+                  << secs << " s)\n";
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_export: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file hyper_main.cpp
+ * @brief bg_hyper: solve and consult exact tables for few-checker variants.
+ *
+ * Usage:
+ * @code
+ *   bg_hyper solve [-n checkers] [-j threads] [-t tolerance] [--sweeps N] -o table.bght
+ *   bg_hyper show table.bght
+ *   bg_hyper hint [-n plays] table.bght <key-hex> <dice>
+ * @endcode
+ * "solve" runs the retrograde solver (3 checkers = hypergammon) and logs
+ * each sweep; "show" prints the table's opening plays when it covers the
+ * hypergammon start; "hint" ranks one position's plays exactly. Keys are
+ * PositionKey hex as printed by "bg_index key"; dice are two digits, e.g. 31.
+ */
+
+#include "hypergammon.hpp"
+#include "positionkey.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+static int usage() {
+    std::cerr << "usage: bg_hyper solve [-n checkers] [-j threads] [-t tolerance] [--sweeps N] -o table.bght\n"
+                 "       bg_hyper show table.bght\n"
+                 "       bg_hyper hint [-n plays] table.bght <key-hex> <dice>\n";
+    return 2;
+}
+
+static void printPlays(const std::vector<ScoredPlay> &plays) {
+    for (const ScoredPlay &sp : plays) {
+        char eq[32]; std::snprintf(eq, sizeof eq, "%+.4f", sp.equity);
+        std::cout << "  " << eq << "  " << (sp.cand.move.n ? sp.cand.move.text() : std::string("(no move)")) << "\n";
+    }
+}
+
+static int solve(int argc, char **argv) {
+    HyperSolveOptions opt;
+    std::string out;
+    for (int i=0; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-o" && i+1<argc) out = argv[++i];
+        else if (a=="-n" && i+1<argc) opt.checkers = unsigned(std::stoul(argv[++i]));
+        else if (a=="-j" && i+1<argc) opt.threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-t" && i+1<argc) opt.tolerance = std::stod(argv[++i]);
+        else if (a=="--sweeps" && i+1<argc) opt.maxSweeps = unsigned(std::stoul(argv[++i]));
+        else return usage();
+    }
+    if (out.empty()) return usage();
+
+    HyperSolveStats st = solveHypergammon(out, opt, [](const HyperSolveStats &s){
+        char line[160];
+        std::snprintf(line, sizeof line, "bg_hyper: sweep %u  %llu positions  max change %.3g  (%.1f s)",
+                      s.sweeps, (unsigned long long)s.positions, s.maxDelta, s.seconds);
+        std::cerr << line << "\n";
+    });
+    if (st.maxDelta>=opt.tolerance)
+        std::cerr << "bg_hyper: warning: not converged after " << st.sweeps << " sweeps\n";
+    return 0;
+}
+
+static int show(const std::string &path) {
+    HyperTable table(path);
+    std::cout << path << ": " << table.checkers() << " checkers, " << table.index().size() << " numbered positions, "
+              << table.sweeps() << " sweeps, last change " << table.maxDelta() << "\n";
+    Position start = Position::initial(Variant::Hypergammon);
+    if (!table.covers(start)) return 0;
+
+    char eq[32]; std::snprintf(eq, sizeof eq, "%+.4f", table.equity(start));
+    std::cout << "start: " << eq << " for the side on roll\n";
+    std::vector<ScoredPlay> plays;
+    for (int hi=2; hi<=6; ++hi) {
+        for (int lo=1; lo<hi; ++lo) {
+            std::cout << hi << lo << ":\n";
+            table.rankPlays(start, hi, lo, plays);
+            if (plays.size()>3) plays.resize(3);
+            printPlays(plays);
+        }
+    }
+    return 0;
+}
+
+static int hint(int argc, char **argv) {
+    size_t n=5;
+    std::vector<std::string> args;
+    for (int i=0; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-n" && i+1<argc) n = std::stoul(argv[++i]);
+        else args.push_back(a);
+    }
+    PositionKey k;
+    if (args.size()!=3 || !PositionKey::parseHex(args[1], k) || args[2].size()!=2) return usage();
+    int d1 = args[2][0]-'0', d2 = args[2][1]-'0';
+    if (d1<1 || d1>6 || d2<1 || d2>6) return usage();
+
+    Board::State st;
+    k.toState(st);
+    Position p = Position::fromState(st, WHITE);
+
+    HyperTable table(args[0]);
+    std::vector<ScoredPlay> plays;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!table.rankPlays(p, d1, d2, plays)) {
+        std::cerr << "bg_hyper: position is not in the table (" << table.checkers() << " checkers a side)\n";
+        return 1;
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (plays.size()>n) plays.resize(n);
+    printPlays(plays);
+    std::cerr << "bg_hyper: " << us << " us\n";
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc<2) return usage();
+    std::string cmd = argv[1];
+    try {
+        if (cmd=="solve") return solve(argc-2, argv+2);
+        if (cmd=="show" && argc==3) return show(argv[2]);
+        if (cmd=="hint") return hint(argc-2, argv+2);
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_hyper: " << ex.what() << "\n";
+        return 1;
+    }
+    return usage();
+}
@@ -0,0 +1,107 @@
+/**
+ * @file index_main.cpp
+ * @brief bg_index: build and query the position index over game record archives.
+ *
+ * Usage:
+ * @code
+ *   bg_index build [-j threads] [-m MB] [-t tmpdir] -o out.bgi archive.bgr...
+ *   bg_index query index.bgi <key-hex | hash-hex>
+ *   bg_index key archive.bgr <gameId> <move>
+ * @endcode
+ * "key" prints the packed key and hash of the position before a given play,
+ * which can then be fed to "query" to list every game that reached it.
+ */
+
+#include "gamerecord.hpp"
+#include "mappedfile.hpp"
+#include "positionindex.hpp"
+#include "positionkey.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+static int usage() {
+    std::cerr << "usage: bg_index build [-j threads] [-m MB] [-t tmpdir] -o out.bgi archive.bgr...\n"
+                 "       bg_index query index.bgi <key-hex | hash-hex>\n"
+                 "       bg_index key archive.bgr <gameId> <move>\n";
+    return 2;
+}
+
+static int build(int argc, char **argv) {
+    IndexBuildOptions opt;
+    std::string out;
+    std::vector<std::string> inputs;
+    for (int i=0; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-o" && i+1<argc) out = argv[++i];
+        else if (a=="-j" && i+1<argc) opt.threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-m" && i+1<argc) opt.memoryBytes = size_t(std::stoull(argv[++i])) << 20;
+        else if (a=="-t" && i+1<argc) opt.tmpDir = argv[++i];
+        else inputs.push_back(a);
+    }
+    if (out.empty() || inputs.empty()) return usage();
+
+    auto t0 = std::chrono::steady_clock::now();
+    IndexBuildStats st = buildPositionIndex(inputs, out, opt);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cerr << "bg_index: " << st.games << " games, " << st.positions << " positions, "
+              << st.runs << " runs, " << st.badGames << " games failed replay (" << secs << " s)\n";
+    return 0;
+}
+
+static int query(const std::string &path, const std::string &arg) {
+    uint64_t hash = 0;
+    PositionKey k;
+    if (PositionKey::parseHex(arg, k)) hash = k.hash();
+    else if (arg.size()==16) hash = std::stoull(arg, nullptr, 16);
+    else { std::cerr << "bg_index: expected a " << 2*PositionKey::kSize << "-digit key or 16-digit hash\n"; return 2; }
+
+    PositionIndex idx(path);
+    auto hits = idx.find(hash);
+    for (const IndexEntry &e : hits) std::cout << e.gameId << ' ' << e.move << '\n';
+    std::cerr << "bg_index: " << hits.size() << " occurrences\n";
+    return 0;
+}
+
+static int key(const std::string &path, uint64_t gameId, uint32_t move) {
+    MappedFile mf(path);
+    RecordReader rr(mf.data(), mf.size());
+    GameReader gr(rr);
+    std::vector<RecordEvent> g;
+    while (gr.next(g)) {
+        if (g.front().header.gameId!=gameId) continue;
+        bool found = false;
+        forEachPlayPosition(g, [&](const Board &b, uint32_t m){
+            if (m!=move || found) return;
+            Board::State s; b.getState(s);
+            PositionKey k = PositionKey::from(s, b.sideToMove());
+            char h[17]; std::snprintf(h, sizeof h, "%016llx", (unsigned long long)k.hash());
+            std::cout << k.hex() << ' ' << h << '\n';
+            found = true;
+        });
+        if (found) return 0;
+        std::cerr << "bg_index: game " << gameId << " has no play " << move << "\n";
+        return 1;
+    }
+    std::cerr << "bg_index: game " << gameId << " not found\n";
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc<2) return usage();
+    std::string cmd = argv[1];
+    try {
+        if (cmd=="build") return build(argc-2, argv+2);
+        if (cmd=="query" && argc==4) return query(argv[2], argv[3]);
+        if (cmd=="key" && argc==5) return key(argv[2], std::stoull(argv[3]), uint32_t(std::stoul(argv[4])));
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_index: " << ex.what() << "\n";
+        return 1;
+    }
+    return usage();
+}
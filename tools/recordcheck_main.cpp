@@ -0,0 +1,166 @@
+/**
+ * @file recordcheck_main.cpp
+ * @brief bg_recordcheck: the record reader against corrupt and torn input.
+ *
+ * Usage: bg_recordcheck [-n mutations] [-s seed]
+ *
+ * Writes a small archive with RecordWriter, then reads damaged copies of it
+ * through both RecordReader paths (stream and memory image):
+ *  - fixed cases: block lengths of 2^64-2, 2^64-4 and just over
+ *    RECORD_MAX_BLOCK must throw RecordError after the valid events; a
+ *    length running past the end must stop with a torn tail;
+ *  - random mutations: byte flips, truncations and spliced varint lengths,
+ *    after which the reader may only return events, stop, or throw
+ *    RecordError (any other exception is a failure).
+ * Memory errors show up as crashes, or as reports when built with
+ * -fsanitize=address. Exits 1 if any case fails.
+ */
+
+#include "gamerecord.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace BG;
+
+namespace {
+
+std::string varint(uint64_t v) {
+    std::string s;
+    while (v>=0x80) { s += char(v|0x80); v >>= 7; }
+    return s + char(v);
+}
+
+/// A few short games, several blocks long.
+std::string sampleArchive(size_t &events) {
+    std::ostringstream out;
+    RecordWriter w(out, true, 64);
+    events = 0;
+    for (int g=0; g<4; ++g) {
+        GameHeader h;
+        h.gameId = uint64_t(g+1);
+        h.matchLength = 7;
+        h.white = "white";
+        h.black = "black";
+        w.gameStart(h);
+        w.openingRoll(3, 1);
+        Play p;
+        p.push(8, 3); p.push(6, 1);
+        w.play(p);
+        w.roll(6, 6);
+        w.play(Play{});
+        w.cubeOffer();
+        w.cubeTake();
+        w.gameEnd(GameEnd{WHITE, 2, false});
+        events += 8;
+    }
+    w.flush();
+    return out.str();
+}
+
+struct Outcome {
+    size_t events = 0;
+    bool torn = false, recordError = false;
+    std::string other;          ///< any exception that is not a RecordError
+};
+
+Outcome read(const std::string &image, bool stream) {
+    Outcome o;
+    RecordEvent ev;
+    try {
+        if (stream) {
+            std::istringstream in(image);
+            RecordReader r(in);
+            while (r.next(ev)) ++o.events;
+            o.torn = r.truncatedTail();
+        } else {
+            RecordReader r(image.data(), image.size());
+            while (r.next(ev)) ++o.events;
+            o.torn = r.truncatedTail();
+        }
+    } catch (const RecordError &) {
+        o.recordError = true;
+    } catch (const std::exception &ex) {
+        o.other = ex.what();
+    }
+    return o;
+}
+
+int usage() {
+    std::cerr << "usage: bg_recordcheck [-n mutations] [-s seed]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint64_t mutations = 20000, seed = 1;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-n" && i+1<argc) mutations = std::stoull(argv[++i]);
+        else if (a=="-s" && i+1<argc) seed = std::stoull(argv[++i]);
+        else return usage();
+    }
+
+    size_t valid = 0;
+    const std::string archive = sampleArchive(valid);
+    unsigned failures = 0;
+    auto fail = [&](const std::string &what) {
+        if (++failures<=10) std::cout << "FAIL " << what << "\n";
+    };
+
+    for (bool stream : {true, false}) {
+        const char *how = stream ? "stream" : "memory";
+        Outcome clean = read(archive, stream);
+        if (clean.events!=valid || clean.torn || clean.recordError || !clean.other.empty())
+            fail(std::string(how) + ": the undamaged archive does not read back");
+
+        struct Case { uint64_t len; bool wantError; };
+        for (Case c : { Case{~uint64_t(0)-1, true}, Case{~uint64_t(0)-3, true},
+                        Case{RECORD_MAX_BLOCK+1, true}, Case{16, false} }) {
+            Outcome o = read(archive + varint(c.len) + "abc", stream);
+            std::string where = std::string(how) + ": block length " + std::to_string(c.len);
+            if (o.events!=valid) fail(where + ": read " + std::to_string(o.events) + " events, expected " + std::to_string(valid));
+            else if (c.wantError ? !o.recordError : !(o.torn || o.recordError)) fail(where + ": accepted");
+            if (!o.other.empty()) fail(where + ": " + o.other);
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    uint64_t errors = 0, torn = 0;
+    for (uint64_t m=0; m<mutations; ++m) {
+        std::string img = archive;
+        const size_t body = 8;   // leave the file header alone
+        switch (rng()%3) {
+            case 0:
+                for (int k = int(rng()%4); k>=0; --k) img[body + rng()%(img.size()-body)] ^= char(1u << (rng()%8));
+                break;
+            case 1:
+                img.resize(body + rng()%(img.size()-body));
+                break;
+            default: {
+                size_t at = body + rng()%(img.size()-body);
+                img.insert(at, varint(rng() >> (rng()%64)));
+                break;
+            }
+        }
+        for (bool stream : {true, false}) {
+            Outcome o = read(img, stream);
+            if (!o.other.empty()) fail(std::string(stream ? "stream" : "memory") + ": mutation " + std::to_string(m) + ": " + o.other);
+            errors += o.recordError;
+            torn += o.torn;
+        }
+    }
+
+    std::cout << "bg_recordcheck: " << mutations << " mutations, " << errors << " RecordErrors, "
+              << torn << " torn tails\n";
+    if (!failures) {
+        std::cout << "no failures\n";
+        return 0;
+    }
+    std::cout << failures << " failures\n";
+    return 1;
+}
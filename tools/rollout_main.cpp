@@ -0,0 +1,211 @@
+/**
+ * @file rollout_main.cpp
+ * @brief bg_rollout: cubeless and cubeful rollouts of a position or of the plays for a roll.
+ *
+ * Usage: bg_rollout [-t trials] [-p plies] [-d random|stratified] [-r rotate] [-l] [-s seed]
+ *                   [-c] [--jacoby] [--truncate turns] [--stop stderr] [--prune sigmas]
+ *                   [-n plays] [-j threads] [-w weights] [-b book.bgb] [--cache file] <position> [dice]
+ *        bg_rollout [rollout options] --farm addr[,addr...] [--checkpoint file] [--chunk trials]
+ *                   [--timeout secs] <position>
+ *        bg_rollout [-j threads] [-w weights] [-b book.bgb] [--cache file] --serve addr
+ *
+ * The position is PositionKey hex (WHITE on roll) or an XGID line, whose
+ * dice are ignored. Without dice it is rolled out for the side on roll.
+ * With dice (two digits, e.g. 31) the best @c -n plays at 0-ply are each
+ * rolled out with the same dice streams, so their differences are not
+ * blurred by luck.
+ * @c -l enables luck adjustment; @c -c plays the cube for both sides with
+ * ThresholdCubePolicy and adds the cubeful equity (centred cube) to the report.
+ * @c --truncate scores trials by the evaluator after that many turns.
+ * @c --stop ends the rollout early once the standard error (of the
+ * differences from the leading play, with dice) is below the given value;
+ * @c --prune drops plays trailing the leader by that many standard errors.
+ *
+ * @c --serve runs a worker on a Unix socket path or "[host:]port" (loopback
+ * unless a host is given); @c --farm rolls a position out on such workers
+ * in chunks, checkpointing after each so a rerun with the same options and
+ * checkpoint resumes. Workers must load the same weights and book. A worker
+ * that does not answer a chunk within @c --timeout seconds (default 600)
+ * is dropped and its chunk goes to another.
+ *
+ * @c --cache keeps the n-ply equities of checker play (-p 1 and up) in a
+ * persistent EvalCache shared with other runs, tools and workers.
+ */
+
+#include "evalcache.hpp"
+#include "openingbook.hpp"
+#include "positionkey.hpp"
+#include "rollout.hpp"
+#include "rolloutfarm.hpp"
+#include "xgid.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+namespace {
+
+int usage() {
+    std::cerr << "usage: bg_rollout [-t trials] [-p plies] [-d random|stratified] [-r rotate] [-l] [-s seed]\n"
+                 "                  [-c] [--jacoby] [--truncate turns] [--stop stderr] [--prune sigmas]\n"
+                 "                  [-n plays] [-j threads] [-w weights] [-b book.bgb] [--cache file] <position> [dice]\n"
+                 "       bg_rollout [rollout options] --farm addr[,addr...] [--checkpoint file] [--chunk trials]\n"
+                 "                  [--timeout secs] <position>\n"
+                 "       bg_rollout [-j threads] [-w weights] [-b book.bgb] [--cache file] --serve addr\n";
+    return 2;
+}
+
+void report(const std::string &label, const RolloutStats &st, bool cubeful) {
+    Probs pr = st.probs();
+    char line[160];
+    std::snprintf(line, sizeof line, "%+.4f +- %.4f  win %.3f  gammon %.3f  lose gammon %.3f  (%llu trials)",
+                  st.mean(), st.stdErr(), pr.win, pr.winGammon, pr.loseGammon, (unsigned long long)st.trials);
+    std::cout << "  " << line << "  " << label << "\n";
+    if (!cubeful) return;
+    std::snprintf(line, sizeof line, "  cubeful %+.4f +- %.4f  doubled %.3f  dropped %.3f",
+                  st.cubefulMean(), st.cubefulStdErr(), double(st.doubles)/double(st.trials),
+                  double(st.drops)/double(st.trials));
+    std::cout << "  " << line << "\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    RolloutOptions opt;
+    std::string weights, bookPath, cachePath, serve, checkpoint;
+    std::vector<std::string> farm;
+    uint64_t chunk = 1296;
+    unsigned timeout = 600;
+    size_t n = 3;
+    bool cubeful = false;
+    std::vector<std::string> args;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-t" && i+1<argc) opt.trials = std::stoull(argv[++i]);
+        else if (a=="-p" && i+1<argc) opt.plies = unsigned(std::stoul(argv[++i]));
+        else if (a=="-r" && i+1<argc) opt.rotate = unsigned(std::stoul(argv[++i]));
+        else if (a=="-s" && i+1<argc) opt.seed = std::stoull(argv[++i]);
+        else if (a=="-n" && i+1<argc) n = std::stoul(argv[++i]);
+        else if (a=="-j" && i+1<argc) opt.threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-w" && i+1<argc) weights = argv[++i];
+        else if (a=="-b" && i+1<argc) bookPath = argv[++i];
+        else if (a=="--cache" && i+1<argc) cachePath = argv[++i];
+        else if (a=="-l") opt.luckAdjust = true;
+        else if (a=="-c") cubeful = true;
+        else if (a=="--jacoby") opt.jacoby = true;
+        else if (a=="--truncate" && i+1<argc) opt.truncate = unsigned(std::stoul(argv[++i]));
+        else if (a=="--stop" && i+1<argc) opt.stopStdErr = std::stod(argv[++i]);
+        else if (a=="--prune" && i+1<argc) opt.pruneSigmas = std::stod(argv[++i]);
+        else if (a=="--serve" && i+1<argc) serve = argv[++i];
+        else if (a=="--checkpoint" && i+1<argc) checkpoint = argv[++i];
+        else if (a=="--chunk" && i+1<argc) chunk = std::stoull(argv[++i]);
+        else if (a=="--timeout" && i+1<argc) timeout = unsigned(std::stoul(argv[++i]));
+        else if (a=="--farm" && i+1<argc) {
+            std::string list = argv[++i];
+            for (size_t at=0; at<=list.size(); ) {
+                size_t comma = std::min(list.find(',', at), list.size());
+                if (comma>at) farm.push_back(list.substr(at, comma-at));
+                at = comma+1;
+            }
+        }
+        else if (a=="-d" && i+1<argc) {
+            std::string d = argv[++i];
+            if (d=="random") opt.dice = DiceMode::Random;
+            else if (d=="stratified") opt.dice = DiceMode::Stratified;
+            else return usage();
+        }
+        else if (a=="-h" || a=="--help") return usage();
+        else args.push_back(a);
+    }
+    if (!serve.empty()) {
+        if (!args.empty()) return usage();
+        try {
+            Evaluator ev = weights.empty() ? Evaluator() : Evaluator::load(weights);
+            Search search(ev);
+            std::unique_ptr<OpeningBook> book;
+            if (!bookPath.empty()) { book = std::make_unique<OpeningBook>(bookPath); search.setBook(book.get()); }
+            std::unique_ptr<EvalCache> cache;
+            if (!cachePath.empty()) { cache = std::make_unique<EvalCache>(cachePath, ev); search.setCache(cache.get()); }
+            serveRollouts(serve, search, opt.threads, [](const std::string &line){ std::cerr << "bg_rollout: " << line << "\n"; });
+        } catch (const std::exception &ex) {
+            std::cerr << "bg_rollout: " << ex.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (args.empty() || args.size()>2) return usage();
+    Board::State st;
+    Side onRoll = WHITE;
+    PositionKey k;
+    Xgid x;
+    if (parseXgid(args[0], x)) { st = x.state; onRoll = x.turn; }
+    else if (PositionKey::parseHex(args[0], k)) k.toState(st);
+    else return usage();
+    if (!farm.empty() && (args.size()!=1 || chunk==0)) return usage();
+    int d1=0, d2=0;
+    if (args.size()==2) {
+        if (args[1].size()!=2) return usage();
+        d1 = args[1][0]-'0'; d2 = args[1][1]-'0';
+        if (d1<1 || d1>6 || d2<1 || d2>6) return usage();
+    }
+
+    try {
+        Position p = Position::fromState(st, onRoll);
+
+        Evaluator ev = weights.empty() ? Evaluator() : Evaluator::load(weights);
+        Search search(ev);
+        std::unique_ptr<OpeningBook> book;
+        if (!bookPath.empty()) { book = std::make_unique<OpeningBook>(bookPath); search.setBook(book.get()); }
+        std::unique_ptr<EvalCache> cache;
+        if (!cachePath.empty()) { cache = std::make_unique<EvalCache>(cachePath, ev); search.setCache(cache.get()); }
+        ThresholdCubePolicy cubePolicy(search);
+        if (cubeful) opt.cubePolicy[0] = opt.cubePolicy[1] = &cubePolicy;
+        Rollout ro(search, opt);
+
+        auto t0 = std::chrono::steady_clock::now();
+        if (!farm.empty()) {
+            RolloutJob job;
+            job.position = p;
+            job.options = opt;
+            job.cubeful = cubeful;
+            job.evaluator = weightsFingerprint(ev);
+            job.chunk = chunk;
+            RolloutStats res = farmRollout(job, farm, checkpoint, [&](const FarmProgress &fp){
+                char line[160];
+                std::snprintf(line, sizeof line, "bg_rollout: %llu/%llu chunks  %+.4f +- %.4f  (%u workers, %.1f s)",
+                              (unsigned long long)fp.done, (unsigned long long)fp.chunks, fp.stats.mean(), fp.stats.stdErr(),
+                              fp.workers, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+                std::cerr << line << "\n";
+            }, timeout);
+            report("(position)", res, cubeful);
+        } else if (!d1) {
+            report("(position)", ro.position(p), cubeful);
+        } else {
+            std::vector<ScoredPlay> plays;
+            search.rankPlays(p, d1, d2, 0, plays);
+            if (plays.size()>n) plays.resize(n);
+            std::vector<Position> afters;
+            for (const ScoredPlay &sp : plays) afters.push_back(sp.cand.after);
+            std::vector<RolloutStats> res = ro.compare(afters);
+            uint64_t most = 0;
+            for (const RolloutStats &r : res) most = std::max(most, r.trials);
+            for (size_t i=0; i<plays.size(); ++i) {
+                const Move &m = plays[i].cand.move;
+                report((m.n ? m.text() : std::string("(no move)")) + (res[i].trials<most ? "  (dropped)" : ""), res[i], cubeful);
+            }
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cerr << "bg_rollout: " << secs << " s\n";
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_rollout: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
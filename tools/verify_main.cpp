@@ -0,0 +1,271 @@
+/**
+ * @file verify_main.cpp
+ * @brief bg_verify: differential check of the engine rules against the reference Board.
+ *
+ * Usage: bg_verify [-g games] [-j threads] [-s seed] [-x max-examples]
+ *
+ * Plays random games of every variant in parallel. At each position the
+ * rules-checked Board (the reference) is compared with the engine path
+ * (canStep, generatePlays, Board::makePlay):
+ *  - the set of single steps each die allows;
+ *  - whether any step is legal at all, and Board::maxPlayableDice()
+ *    against the most steps in any generated play;
+ *  - every generated play: accepted step by step and at commit, leaving
+ *    the position the generator reports, and made/unmade without checks;
+ *  - random step sequences on the Board: commit refuses any stopped while
+ *    a step was still legal and accepts only those that end in a generated
+ *    play. (It may refuse one that does: the same position reached with
+ *    fewer dice or the wrong die, which the generator's deduplication hides.)
+ * Each mismatch is shrunk by removing checkers while it persists and is
+ * printed as a PositionKey (WHITE on roll, see "bg_index key") with the
+ * dice.
+ * Exits 1 if any mismatch was found.
+ */
+
+#include "movegen.hpp"
+#include "positionkey.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace BG;
+
+namespace {
+
+struct Stats {
+    std::atomic<uint64_t> positions{0}, steps{0}, plays{0}, walks{0}, mismatches{0};
+};
+
+bool sameBoard(const Board::State &a, const Board::State &b) {
+    for (int i=0; i<24; ++i) {
+        if (a.points[i].count!=b.points[i].count) return false;
+        if (a.points[i].count && a.points[i].side!=b.points[i].side) return false;
+    }
+    return a.whitebar==b.whitebar && a.blackbar==b.blackbar && a.whiteoff==b.whiteoff && a.blackoff==b.blackoff;
+}
+
+std::string dice(int d1, int d2) { return std::to_string(d1) + std::to_string(d2); }
+
+/**
+ * Compare Board and the engine path on @p start (phase Moving, dice set).
+ * Returns a description of the first mismatch, or an empty string.
+ */
+std::string check(const Board &start, std::mt19937_64 &rng, Stats *stats) {
+    Board::State st;
+    start.getState(st);
+    const Side s = start.sideToMove();
+    const Position p = Position::fromState(st, s);
+    const std::vector<int> left = start.diceRemaining();
+    const int d1 = left[0], d2 = left[1];
+    std::vector<Candidate> cands;
+    generatePlays(p, d1, d2, cands);
+    uint64_t steps=0, plays=0, walks=0;
+
+    // Single steps, die by die.
+    Board b = start;
+    for (int die : {d1, d2}) {
+        for (int from=0; from<=24; ++from) {
+            int i = from==0 ? Position::kBar : (s==WHITE ? from-1 : 24-from);
+            bool ref = b.applyStep(from, die);
+            if (ref) b.undoStep();
+            ++steps;
+            if (ref!=canStep(p, i, die))
+                return "step " + std::to_string(from) + " with " + std::to_string(die) + ": Board "
+                       + (ref ? "allows" : "refuses") + " it, canStep " + (ref ? "refuses" : "allows") + " it";
+        }
+        if (d1==d2) break;
+    }
+
+    const bool canMove = !(cands.size()==1 && cands[0].move.n==0);
+    if (start.hasAnyLegalStep()!=canMove)
+        return std::string("any legal step: Board says ") + (canMove ? "no" : "yes") + ", movegen " + (canMove ? "yes" : "no");
+    unsigned most = 0;
+    for (const Candidate &c : cands) most = std::max(most, unsigned(c.move.n));
+    if (const unsigned ref = start.maxPlayableDice(); ref!=most)
+        return "dice playable: Board says " + std::to_string(ref) + ", movegen's longest play uses " + std::to_string(most);
+
+    // Every generated play, through the rules and through makePlay.
+    for (const Candidate &c : cands) {
+        Play play = c.move.toPlay(s);
+        Board r = start;
+        for (unsigned k=0; k<play.n; ++k)
+            if (!r.applyStep(play.steps[k].from, play.steps[k].pip))
+                return "play " + c.move.text() + ": step " + std::to_string(k+1) + " refused (" + r.lastError() + ")";
+        if (!r.commitTurn()) return "play " + c.move.text() + ": commit refused (" + r.lastError() + ")";
+        Board::State got, want;
+        r.getState(got);
+        c.after.toState(s, want);
+        if (!sameBoard(got, want)) return "play " + c.move.text() + ": Board and movegen reach different positions";
+
+        Board m = start;
+        PlayUndo undo;
+        m.makePlay(s, play, undo);
+        m.getState(got);
+        if (!sameBoard(got, want)) return "play " + c.move.text() + ": makePlay reaches a different position";
+        m.unmakePlay(undo);
+        m.getState(got);
+        if (!sameBoard(got, st)) return "play " + c.move.text() + ": unmakePlay does not restore the position";
+        ++plays;
+    }
+
+    // Random step sequences. One cut short leaves dice unused that could be
+    // played, even if it happens to reach a generated position.
+    for (int w=0; w<4; ++w) {
+        Board r = start;
+        Move seq;
+        bool cut = false;
+        std::vector<std::pair<int,int>> legal;
+        while (true) {
+            legal.clear();
+            std::vector<int> dl = r.diceRemaining();
+            std::sort(dl.begin(), dl.end());
+            dl.erase(std::unique(dl.begin(), dl.end()), dl.end());
+            for (int die : dl)
+                for (int from=0; from<=24; ++from)
+                    if (r.applyStep(from, die)) { r.undoStep(); legal.emplace_back(from, die); }
+            if (legal.empty()) break;
+            if (seq.n>0 && rng()%5==0) { cut = true; break; }
+            auto [from, die] = legal[rng()%legal.size()];
+            r.applyStep(from, die);
+            int own = from==0 ? 25 : (s==WHITE ? from : 25-from);
+            seq.steps[seq.n++] = { int8_t(own), int8_t(own-die<0 ? 0 : own-die), int8_t(die) };
+        }
+        Board::State got;
+        r.getState(got);
+        const Position reached = Position::fromState(got, s);
+        bool generated = std::any_of(cands.begin(), cands.end(), [&](const Candidate &c){ return c.after==reached; });
+        bool accepted = r.commitTurn();
+        ++walks;
+        if (cut && accepted)
+            return "steps " + seq.text() + ": Board commit accepts with a legal step left";
+        if (accepted && !generated)
+            return "steps " + (seq.n ? seq.text() : std::string("(none)")) + ": Board commit accepts, movegen lacks the play";
+    }
+
+    if (stats) {
+        stats->positions += 1; stats->steps += steps; stats->plays += plays; stats->walks += walks;
+    }
+    return {};
+}
+
+/// check() for @p p with @p s on roll, set up from scratch.
+std::string checkPosition(const Position &p, Side s, int d1, int d2, std::mt19937_64 &rng) {
+    Board::State st;
+    p.toState(s, st);
+    Board b;
+    b.setState(st, s);
+    b.setDice(d1, d2);
+    return check(b, rng, nullptr);
+}
+
+/// Remove checkers one at a time while the mismatch persists.
+Position minimize(Position p, Side s, int d1, int d2, uint64_t seed, std::string &why) {
+    for (bool shrunk=true; shrunk; ) {
+        shrunk = false;
+        for (int side=0; side<2; ++side) {
+            for (int i=0; i<25; ++i) {
+                if (!p.checkers[side][i] || p.inPlay(side)<2) continue;
+                Position q = p;
+                --q.checkers[side][i]; ++q.off[side];
+                std::mt19937_64 rng(seed);
+                std::string w = checkPosition(q, s, d1, d2, rng);
+                if (w.empty()) continue;
+                p = q; why = w; shrunk = true;
+            }
+        }
+    }
+    return p;
+}
+
+int usage() {
+    std::cerr << "usage: bg_verify [-g games] [-j threads] [-s seed] [-x max-examples]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint64_t games = 10000, seed = 1;
+    unsigned threads = 0, maxExamples = 5;
+    for (int i=1; i<argc; ++i) {
+        std::string a = argv[i];
+        if (a=="-g" && i+1<argc) games = std::stoull(argv[++i]);
+        else if (a=="-j" && i+1<argc) threads = unsigned(std::stoul(argv[++i]));
+        else if (a=="-s" && i+1<argc) seed = std::stoull(argv[++i]);
+        else if (a=="-x" && i+1<argc) maxExamples = unsigned(std::stoul(argv[++i]));
+        else return usage();
+    }
+
+    Stats stats;
+    std::mutex mu;
+    std::vector<std::string> examples;
+    auto t0 = std::chrono::steady_clock::now();
+    try {
+        ThreadPool pool(threads);
+        pool.parallelFor(games, [&](size_t g){
+            std::mt19937_64 rng(seed*0x9E3779B97F4A7C15ull + g);
+            auto die = [&]{ return int(rng()%6) + 1; };
+            Rules rules;
+            rules.variant = Variant(g%3);
+            Board b;
+            b.startGame(rules);
+            int w, k;
+            do { w = die(); k = die(); } while (w==k);
+            b.setOpeningDice(w, k);
+
+            for (unsigned turn=0; turn<5000; ++turn) {
+                const uint64_t checkSeed = rng();
+                std::mt19937_64 crng(checkSeed);
+                std::string why = check(b, crng, &stats);
+                if (!why.empty()) {
+                    ++stats.mismatches;
+                    Board::State st;
+                    b.getState(st);
+                    const Side s = b.sideToMove();
+                    std::vector<int> dl = b.diceRemaining();
+                    Position small = minimize(Position::fromState(st, s), s, dl[0], dl[1], checkSeed, why);
+                    small.toState(s, st);
+                    std::lock_guard<std::mutex> lk(mu);
+                    if (examples.size()<maxExamples)
+                        examples.push_back(PositionKey::from(st, s).hex() + " " + dice(dl[0], dl[1]) + "  "
+                                           + variantName(rules.variant) + ": " + why);
+                    return;
+                }
+
+                Board::State st;
+                b.getState(st);
+                const Side s = b.sideToMove();
+                std::vector<int> dl = b.diceRemaining();
+                std::vector<Candidate> cands;
+                generatePlays(Position::fromState(st, s), dl[0], dl[1], cands);
+                Play play = cands[rng()%cands.size()].move.toPlay(s);
+                for (unsigned i=0; i<play.n; ++i) b.applyStep(play.steps[i].from, play.steps[i].pip);
+                b.commitTurn();
+                if (b.countOff(s)==b.checkers()) return;
+                b.setDice(die(), die());
+            }
+        }, 4);
+    } catch (const std::exception &ex) {
+        std::cerr << "bg_verify: " << ex.what() << "\n";
+        return 1;
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "bg_verify: " << games << " games, " << stats.positions << " positions, " << stats.steps << " steps, "
+              << stats.plays << " plays, " << stats.walks << " step sequences (" << secs << " s)\n";
+    if (!stats.mismatches) {
+        std::cout << "no mismatches\n";
+        return 0;
+    }
+    std::cout << stats.mismatches << " mismatching games; minimized examples (key dice):\n";
+    for (const std::string &e : examples) std::cout << "  " << e << "\n";
+    return 1;
+}
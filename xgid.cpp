@@ -0,0 +1,148 @@
+/**
+ * @file xgid.cpp
+ * @brief XGID formatting into caller buffers and single-pass parsing.
+ */
+
+#include "xgid.hpp"
+#include <charconv>
+
+namespace BG {
+
+namespace {
+
+constexpr std::string_view XGID_PREFIX = "XGID=";
+
+/// Appends to a fixed buffer; remembers running out of room.
+struct Out {
+    char *p, *end;
+    bool ok = true;
+
+    void put(char c) { if (p<end) *p++ = c; else ok = false; }
+    void put(std::string_view s) { for (char c : s) put(c); }
+    void num(long v) {
+        char tmp[24];
+        auto r = std::to_chars(tmp, tmp+sizeof tmp, v);
+        put(std::string_view(tmp, size_t(r.ptr-tmp)));
+    }
+};
+
+/// Splits on ':' without copying.
+struct Fields {
+    std::string_view rest;
+    bool more = true;
+
+    std::string_view next() {
+        size_t c = rest.find(':');
+        std::string_view f = rest.substr(0, c);
+        if (c==std::string_view::npos) { rest = {}; more = false; }
+        else rest.remove_prefix(c+1);
+        return f;
+    }
+};
+
+bool toInt(std::string_view f, long &v) {
+    auto r = std::from_chars(f.data(), f.data()+f.size(), v);
+    return r.ec==std::errc() && r.ptr==f.data()+f.size();
+}
+
+int sideSign(Side s) { return s==WHITE ? 1 : s==BLACK ? -1 : 0; }
+
+} // namespace
+
+size_t formatXgid(const Xgid &x, char *out, size_t cap) {
+    const Board::State &s = x.state;
+    unsigned cubeLog = 0;
+    while ((1u << cubeLog) < s.cube) ++cubeLog;
+    if ((1u << cubeLog)!=s.cube || s.whitebar>26 || s.blackbar>26) return 0;
+
+    Out o{out, out+cap};
+    o.put(XGID_PREFIX);
+    o.put(s.blackbar ? char('a' + s.blackbar - 1) : '-');
+    for (const Board::State::Point &pt : s.points) {
+        if (pt.count>26) return 0;
+        if (!pt.count || pt.side==NONE) o.put('-');
+        else o.put(char((pt.side==WHITE ? 'A' : 'a') + pt.count - 1));
+    }
+    o.put(s.whitebar ? char('A' + s.whitebar - 1) : '-');
+    o.put(':'); o.num(cubeLog);
+    o.put(':'); o.num(sideSign(x.cubeOwner));
+    o.put(':'); o.num(x.turn==BLACK ? -1 : 1);
+    o.put(':');
+    if (x.cubeAction) o.put(x.cubeAction);
+    else { o.put(char('0' + x.d1)); o.put(char('0' + x.d2)); }
+    o.put(':'); o.num(x.score[0]);
+    o.put(':'); o.num(x.score[1]);
+    o.put(':'); o.num(x.matchLength ? int(x.crawford) : int(x.jacoby) + 2*int(x.beavers));
+    o.put(':'); o.num(x.matchLength);
+    o.put(':'); o.num(x.maxCube);
+    return o.ok ? size_t(o.p-out) : 0;
+}
+
+std::string toXgid(const Xgid &x) {
+    char buf[Xgid::kMaxLength];
+    return std::string(buf, formatXgid(x, buf, sizeof buf));
+}
+
+bool parseXgid(std::string_view text, Xgid &out, unsigned checkers) {
+    if (text.substr(0, XGID_PREFIX.size())==XGID_PREFIX) text.remove_prefix(XGID_PREFIX.size());
+    Fields f{text};
+    Xgid x;
+    Board::State &s = x.state;
+
+    std::string_view pos = f.next();
+    if (pos.size()!=26 || !f.more) return false;
+    unsigned total[2] = {0, 0};
+    auto decode = [&](char c, Side &side, unsigned &n) {
+        if (c=='-') { side = NONE; n = 0; return true; }
+        if (c>='A' && c<='Z') { side = WHITE; n = unsigned(c-'A'+1); }
+        else if (c>='a' && c<='z') { side = BLACK; n = unsigned(c-'a'+1); }
+        else return false;
+        total[int(side)] += n;
+        return true;
+    };
+    Side side;
+    unsigned n;
+    if (!decode(pos[0], side, n) || side==WHITE) return false;
+    s.blackbar = n;
+    for (int p=1; p<=24; ++p) {
+        if (!decode(pos[size_t(p)], side, n)) return false;
+        s.points[p-1] = {side, n};
+    }
+    if (!decode(pos[25], side, n) || side==BLACK) return false;
+    s.whitebar = n;
+    if (total[0]>checkers || total[1]>checkers) return false;
+    s.whiteoff = checkers - total[0];
+    s.blackoff = checkers - total[1];
+
+    long v;
+    if (!toInt(f.next(), v) || v<0 || v>30 || !f.more) return false;
+    s.cube = 1u << v;
+    if (!toInt(f.next(), v) || v<-1 || v>1 || !f.more) return false;
+    x.cubeOwner = v==1 ? WHITE : v==-1 ? BLACK : NONE;
+    if (!toInt(f.next(), v) || (v!=1 && v!=-1) || !f.more) return false;
+    x.turn = v==1 ? WHITE : BLACK;
+
+    std::string_view dice = f.next();
+    if (dice.size()==1 && (dice[0]=='D' || dice[0]=='B' || dice[0]=='R')) x.cubeAction = dice[0];
+    else if (dice.size()==2 && dice!="00") {
+        x.d1 = dice[0]-'0'; x.d2 = dice[1]-'0';
+        if (x.d1<1 || x.d1>6 || x.d2<1 || x.d2>6) return false;
+    }
+    else if (dice!="00") return false;
+
+    long flags = 0;
+    unsigned *targets[] = { &x.score[0], &x.score[1], nullptr, &x.matchLength, &x.maxCube };
+    for (unsigned *t : targets) {
+        if (!f.more) break;
+        if (!toInt(f.next(), v) || v<0) return false;
+        if (t) *t = unsigned(v);
+        else flags = v;
+    }
+    if (f.more || flags>3) return false;
+    if (x.matchLength) x.crawford = flags & 1;
+    else { x.jacoby = flags & 1; x.beavers = flags & 2; }
+    out = x;
+    return true;
+}
+
+} // namespace BG
@@ -0,0 +1,73 @@
+/**
+ * @file xgid.hpp
+ * @brief XGID position strings: allocation-free formatting and parsing.
+ */
+
+#ifndef XGID_HPP
+#define XGID_HPP
+
+#include "board.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace BG {
+
+/**
+ * @struct Xgid
+ * @brief Everything one XGID line carries: checkers, cube, turn, dice and match score.
+ *
+ * The line is ten colon-separated fields, the first prefixed "XGID=":
+ * @code
+ *   XGID=-b----E-C---eE---c-e----B-:0:0:1:52:0:0:3:0:10
+ *        position   cube owner turn dice scoreW scoreB flags length maxcube
+ * @endcode
+ * The position is 26 characters: O's bar, points 1..24 of the bottom
+ * player, the bottom player's bar. Upper-case letters are that many
+ * checkers ('A' = 1) of the bottom player, here WHITE; lower-case are
+ * BLACK's; '-' is empty. Off counts are not written: each side has
+ * @c checkers minus those on the board and bar. Cube and maximum cube are
+ * log2 values; owner and turn are 1 for WHITE, -1 for BLACK (owner 0 =
+ * centred). Dice are "00" before the roll, or 'D', 'B' or 'R' while a
+ * double, beaver or raccoon awaits an answer. The flags are the Crawford
+ * game in a match, Jacoby (1) plus beavers (2) for money (length 0).
+ */
+struct Xgid {
+    /// Longest line formatXgid() writes (a 26-character position and ten fields).
+    static constexpr size_t kMaxLength = 80;
+
+    Board::State state;         ///< checkers, bars, off counts and cube value
+    Side turn = WHITE;          ///< side on roll (or facing the cube action)
+    Side cubeOwner = NONE;
+    int d1 = 0, d2 = 0;         ///< 0 before the roll
+    char cubeAction = 0;        ///< 'D', 'B', 'R', or 0
+    unsigned score[2] = {0, 0}; ///< WHITE, BLACK
+    unsigned matchLength = 0;   ///< 0 = money game
+    bool crawford = false;
+    bool jacoby = false, beavers = false;
+    unsigned maxCube = 10;      ///< log2 of the cube limit
+};
+
+/**
+ * @brief Write @p x into @p out[0..cap) (no terminator, no allocation).
+ * @return Characters written, or 0 if @p cap is too small or a field does
+ *         not fit the format (cube not a power of two, more than 26 on a point).
+ */
+size_t formatXgid(const Xgid &x, char *out, size_t cap);
+
+/// formatXgid() into a string.
+std::string toXgid(const Xgid &x);
+
+/**
+ * @brief Parse an XGID line, with or without the "XGID=" prefix, without allocating.
+ *
+ * Fields after the dice may be left out and keep their defaults.
+ *
+ * @param checkers Checkers per side, for the off counts.
+ * @return false on malformed text or more than @p checkers of one side.
+ */
+bool parseXgid(std::string_view text, Xgid &out, unsigned checkers = 15);
+
+} // namespace BG
+
+#endif // XGID_HPP